@@ -0,0 +1,121 @@
+#include "batch_raster.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+namespace {
+
+// Everything one worker touches, padded so neighbours don't share cache lines
+struct alignas(64) WorkerContext {
+    TTFReader reader;
+    OutlineArena arena;
+    GlyphOutline glyph;
+    std::vector<int32_t> scratch;
+    std::vector<uint8_t> pixels;
+    WorkerStats stats;
+    uint64_t failedGlyphs = 0;
+};
+
+void rasterizeRange(WorkerContext& context, unsigned worker, int first, int last,
+                    const std::vector<float>& pixelSizes, const BitmapVisitor& visitor) {
+    uint16_t unitsPerEm = context.reader.getUnitsPerEm();
+
+    for (int glyphIndex = first; glyphIndex < last; glyphIndex++) {
+        // Each glyph is done with once rendered, so its arena space is reused
+        context.arena.reset();
+        if (!context.reader.loadOutline(glyphIndex, context.arena, context.glyph)) {
+            context.failedGlyphs++;
+            continue;
+        }
+        context.stats.glyphs++;
+        if (context.glyph.empty()) continue; // Nothing to draw
+
+        for (float pixelSize : pixelSizes) {
+            RasterPlacement placement = computeRasterPlacement(context.glyph.header, pixelSize, unitsPerEm);
+            if (placement.width <= 0 || placement.height <= 0) continue;
+
+            size_t cells = rasterScratchCells(placement);
+            size_t pixelCount = static_cast<size_t>(placement.width) * placement.height;
+            if (context.scratch.size() < cells) context.scratch.resize(cells);
+            if (context.pixels.size() < pixelCount) context.pixels.resize(pixelCount);
+
+            GlyphBitmap bitmap;
+            bitmap.pixels = context.pixels.data();
+            bitmap.width = placement.width;
+            bitmap.height = placement.height;
+            bitmap.stride = placement.width;
+            if (!rasterizeGlyph(context.glyph, placement, context.scratch.data(), context.scratch.size(), bitmap)) {
+                continue;
+            }
+
+            context.stats.bitmaps++;
+            context.stats.pixels += pixelCount;
+            if (visitor) visitor(worker, glyphIndex, pixelSize, placement, bitmap);
+        }
+    }
+}
+
+} // namespace
+
+bool rasterizeFontParallel(const std::string& fontPath, const BatchRasterOptions& options,
+                           BatchRasterResult& result, const BitmapVisitor& visitor) {
+    result = BatchRasterResult();
+    std::shared_ptr<FontFace> face = std::make_shared<FontFace>();
+    if (!face->open(fontPath)) return false;
+    face->widenLoca();  // Every glyph gets visited
+    return rasterizeFontParallel(face, options, result, visitor);
+}
+
+bool rasterizeFontParallel(std::shared_ptr<const FontFace> face, const BatchRasterOptions& options,
+                           BatchRasterResult& result, const BitmapVisitor& visitor) {
+    result = BatchRasterResult();
+    if (options.pixelSizes.empty() || !face) return false;
+
+    WorkStealingPool pool(options.threads);
+    unsigned threadCount = pool.size();
+
+    std::vector<std::unique_ptr<WorkerContext>> contexts;
+    contexts.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        contexts.push_back(std::unique_ptr<WorkerContext>(new WorkerContext()));
+        if (!contexts.back()->reader.attachFace(face)) return false;
+    }
+
+    int numGlyphs = contexts[0]->reader.getNumGlyphs();
+    int first = std::max(0, options.firstGlyph);
+    int last = options.glyphCount < 0 ? numGlyphs : std::min(numGlyphs, first + options.glyphCount);
+    if (first >= last) return false;
+    int chunk = std::max(1, options.glyphsPerTask);
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (int begin = first; begin < last; begin += chunk) {
+        int end = std::min(last, begin + chunk);
+        pool.submit([&contexts, &options, &visitor, begin, end](unsigned worker) {
+            WorkerContext& context = *contexts[worker];
+            auto taskStart = std::chrono::steady_clock::now();
+            rasterizeRange(context, worker, begin, end, options.pixelSizes, visitor);
+            context.stats.busySeconds +=
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - taskStart).count();
+        });
+    }
+    pool.wait();
+
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<WorkerTaskStats> taskStats = pool.getTaskStats();
+    result.workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        WorkerStats stats = contexts[i]->stats;
+        stats.tasks = taskStats[i].executed;
+        stats.stolen = taskStats[i].stolen;
+
+        result.glyphs += stats.glyphs;
+        result.bitmaps += stats.bitmaps;
+        result.pixels += stats.pixels;
+        result.failedGlyphs += contexts[i]->failedGlyphs;
+        result.workers.push_back(stats);
+    }
+    return true;
+}
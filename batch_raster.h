@@ -0,0 +1,55 @@
+#ifndef BATCH_RASTER_H
+#define BATCH_RASTER_H
+
+#include <functional>
+#include <memory>
+#include "rasterizer.h"
+
+// What to pre-render
+struct BatchRasterOptions {
+    int firstGlyph = 0;
+    int glyphCount = -1;            // -1 = every glyph from firstGlyph on
+    std::vector<float> pixelSizes;  // Each glyph is rendered at every size
+    unsigned threads = 0;           // 0 = one per hardware thread
+    int glyphsPerTask = 8;          // Work unit; small enough for stealing to even out load
+};
+
+// Per-thread accounting
+struct WorkerStats {
+    uint64_t glyphs = 0;        // Glyphs decoded
+    uint64_t bitmaps = 0;       // Glyph x size renders
+    uint64_t pixels = 0;
+    uint64_t tasks = 0;
+    uint64_t stolen = 0;        // Tasks taken from another thread's queue
+    double busySeconds = 0;
+
+    double glyphsPerSecond() const { return busySeconds > 0 ? glyphs / busySeconds : 0; }
+};
+
+struct BatchRasterResult {
+    uint64_t glyphs = 0;
+    uint64_t failedGlyphs = 0;  // Malformed or undecodable
+    uint64_t bitmaps = 0;
+    uint64_t pixels = 0;
+    double wallSeconds = 0;
+    std::vector<WorkerStats> workers;
+};
+
+// Called for every rendered bitmap, on the worker thread that rendered it.
+// The bitmap's pixels are reused right after the call returns - copy them out.
+typedef std::function<void(unsigned worker, int glyphIndex, float pixelSize,
+                           const RasterPlacement& placement, const GlyphBitmap& bitmap)> BitmapVisitor;
+
+// Decodes and rasterizes a glyph range at every requested size across a
+// work-stealing pool. The file is opened once as a shared FontFace; each
+// worker reads it through its own TTFReader with its own scratch buffers,
+// so workers never contend on anything but the task queues.
+// Each glyph is decoded once and rendered at all sizes while it's hot.
+bool rasterizeFontParallel(const std::string& fontPath, const BatchRasterOptions& options,
+                           BatchRasterResult& result, const BitmapVisitor& visitor = BitmapVisitor());
+
+// Same, on an already open face (e.g. one the caller shares between threads)
+bool rasterizeFontParallel(std::shared_ptr<const FontFace> face, const BatchRasterOptions& options,
+                           BatchRasterResult& result, const BitmapVisitor& visitor = BitmapVisitor());
+
+#endif
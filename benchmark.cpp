@@ -0,0 +1,880 @@
+// Benchmark driver: times each pipeline stage over whole fonts.
+//
+//   text_raster_bench [options] [font.ttf ...]
+//     --iterations N   timed samples per stage (default 20)
+//     --warmup N       untimed runs before sampling (default 3)
+//     --format F       text, json or csv (default text)
+//     --stage NAME     run only stages whose name contains NAME (repeatable)
+//     --list           print the stage names and exit
+//     --selftest       check the SIMD kernels against their scalar
+//                      references and the flattening error bound, then
+//                      exit (nonzero on a failure)
+//     --synthetic SPEC generate a font from SPEC (see parseSyntheticFontSpec)
+//                      and benchmark it too; repeatable
+//     --counters F     after the run, print the reader's instrumentation
+//                      counters to stderr as json or prometheus (needs a
+//                      build with -DTTF_INSTRUMENTATION)
+//
+// The library doesn't print, so JSON/CSV on stdout stays machine-readable;
+// progress goes to stderr.
+
+#include "ttf_reader.h"
+#include "rasterizer.h"
+#include "glyph_cache.h"
+#include "glyph_atlas.h"
+#include "char_map.h"
+#include "kerning.h"
+#include "glyph_bounds.h"
+#include "text_layout.h"
+#include "thread_pool.h"
+#include "batch_raster.h"
+#include "distance_field.h"
+#include "font_pack.h"
+#include "svg_writer.h"
+#include "instrumentation.h"
+#include "font_generator.h"
+#include "point_decode.h"
+#include "loca_table.h"
+#include "coverage_kernels.h"
+#include "font_variations.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+struct BenchOptions {
+    int iterations = 20;
+    int warmup = 3;
+    std::string format = "text";
+    std::vector<std::string> stageFilters;
+    std::vector<std::string> fonts;
+    std::vector<std::string> syntheticSpecs;
+    std::string counters;                   // "", "json" or "prometheus"
+};
+
+// Everything a stage may need, opened once per font outside the timings
+struct FontFixture {
+    std::string path;
+    std::string label;                      // Reported font name; the spec for synthetic fonts
+    TTFReader reader;
+    int glyphCount = 0;
+    std::vector<GlyphOutline> outlines;     // Every decodable glyph, in arena
+    OutlineArena arena;
+    std::string exportPath;
+    std::string packPath;                   // Font pack compiled from the font, for the startup stages
+};
+
+// A stage runs once per sample and returns how many items it processed
+struct BenchStage {
+    std::string name;
+    std::function<size_t(FontFixture&)> run;
+};
+
+struct StageResult {
+    std::string font;
+    std::string stage;
+    size_t items = 0;           // Per run
+    std::vector<double> samples; // Seconds, sorted
+};
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    if (rank > 0) rank--;
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+double mean(const std::vector<double>& samples) {
+    double sum = 0;
+    for (double s : samples) sum += s;
+    return samples.empty() ? 0 : sum / samples.size();
+}
+
+double stddev(const std::vector<double>& samples) {
+    if (samples.size() < 2) return 0;
+    double m = mean(samples), sum = 0;
+    for (double s : samples) sum += (s - m) * (s - m);
+    return std::sqrt(sum / (samples.size() - 1));
+}
+
+// Results are folded in here so the optimizer can't drop the work
+volatile size_t benchSink = 0;
+
+size_t flattenAll(FontFixture& fixture, int resolution) {
+    size_t vertices = 0;
+    for (const GlyphOutline& outline : fixture.outlines) {
+        vertices += fixture.reader.generateGlyphOutline(outline, resolution).size();
+    }
+    benchSink = benchSink + vertices;
+    return fixture.outlines.size();
+}
+
+size_t rasterizeAll(FontFixture& fixture, float pixelSize) {
+    static thread_local std::vector<int32_t> scratch;
+    static thread_local std::vector<uint8_t> pixels;
+    size_t rendered = 0;
+
+    for (const GlyphOutline& outline : fixture.outlines) {
+        if (outline.empty()) continue;
+        RasterPlacement placement = computeRasterPlacement(outline.header, pixelSize, fixture.reader.getUnitsPerEm());
+        if (placement.width <= 0 || placement.height <= 0) continue;
+
+        size_t cells = rasterScratchCells(placement);
+        size_t pixelCount = static_cast<size_t>(placement.width) * placement.height;
+        if (scratch.size() < cells) scratch.resize(cells);
+        if (pixels.size() < pixelCount) pixels.resize(pixelCount);
+
+        GlyphBitmap bitmap;
+        bitmap.pixels = pixels.data();
+        bitmap.width = placement.width;
+        bitmap.height = placement.height;
+        bitmap.stride = placement.width;
+        if (rasterizeGlyph(outline, placement, scratch.data(), scratch.size(), bitmap)) rendered++;
+    }
+    return rendered;
+}
+
+size_t distanceFieldAll(FontFixture& fixture, float pixelSize, bool multiChannel) {
+    static thread_local DistanceFieldGenerator generator;
+    static thread_local std::vector<uint8_t> pixels;
+    DistanceFieldOptions options;
+    options.multiChannel = multiChannel;
+    int channels = multiChannel ? 3 : 1;
+    size_t rendered = 0;
+
+    for (const GlyphOutline& outline : fixture.outlines) {
+        if (outline.empty()) continue;
+        RasterPlacement placement = computeDistanceFieldPlacement(outline.header, pixelSize,
+                                                                  fixture.reader.getUnitsPerEm(), options.spread);
+        if (placement.width <= 0 || placement.height <= 0) continue;
+
+        size_t bytes = static_cast<size_t>(placement.width) * placement.height * channels;
+        if (pixels.size() < bytes) pixels.resize(bytes);
+
+        GlyphBitmap bitmap;
+        bitmap.pixels = pixels.data();
+        bitmap.width = placement.width;
+        bitmap.height = placement.height;
+        bitmap.stride = placement.width * channels;
+        if (generator.generate(outline, placement, options, bitmap)) rendered++;
+    }
+    return rendered;
+}
+
+// New stages go here; each one is timed for every font
+std::vector<BenchStage> buildStages() {
+    std::vector<BenchStage> stages;
+
+    stages.push_back({"open+loca", [](FontFixture& fixture) -> size_t {
+        TTFReader reader;
+        if (!reader.openFont(fixture.path) || !reader.loadLocaTable()) return 0;
+        return 1;
+    }});
+
+    stages.push_back({"open+widenLoca", [](FontFixture& fixture) -> size_t {
+        TTFReader reader;
+        if (!reader.openFont(fixture.path)) return 0;
+        return reader.getGlyphOffsets().size();
+    }});
+
+    // Cold start: everything a fresh process does before its first outline
+    stages.push_back({"startup/ttf/all", [](FontFixture& fixture) -> size_t {
+        static thread_local OutlineArena arena;
+        TTFReader reader;
+        if (!reader.openFont(fixture.path)) return 0;
+        arena.reset();
+        GlyphOutline outline;
+        size_t read = 0;
+        for (int i = 0; i < reader.getNumGlyphs(); i++) {
+            if (reader.loadOutline(i, arena, outline)) read++;
+        }
+        return read;
+    }});
+
+    // Includes the staleness check: mapping the TTF and hashing its bytes
+    stages.push_back({"startup/fontPack/all", [](FontFixture& fixture) -> size_t {
+        FontPack pack;
+        if (!openFontPack(fixture.path, fixture.packPath, FontPackOptions(), pack)) return 0;
+        GlyphOutline outline;
+        size_t read = 0;
+        for (int i = 0; i < pack.getNumGlyphs(); i++) {
+            if (pack.getOutline(i, outline)) read++;
+        }
+        return read;
+    }});
+
+    stages.push_back({"readGlyphByIndex/all", [](FontFixture& fixture) -> size_t {
+        size_t read = 0;
+        SimpleGlyph glyph;
+        for (int i = 0; i < fixture.glyphCount; i++) {
+            if (fixture.reader.readGlyphByIndex(i, glyph)) read++;
+        }
+        return read;
+    }});
+
+    stages.push_back({"loadOutline/all", [](FontFixture& fixture) -> size_t {
+        static thread_local OutlineArena arena;
+        GlyphOutline outline;
+        size_t read = 0;
+        arena.reset();
+        for (int i = 0; i < fixture.glyphCount; i++) {
+            if (fixture.reader.loadOutline(i, arena, outline)) read++;
+        }
+        return read;
+    }});
+
+    stages.push_back({"loadOutline/varied8", [](FontFixture& fixture) -> size_t {
+        // An animated weight: every glyph at 8 locations along the first axis
+        // (0 items for static fonts)
+        FontVariations variations;
+        if (!variations.load(*fixture.reader.getFace())) return 0;
+        static thread_local OutlineArena arena;
+        GlyphOutline outline;
+        size_t read = 0;
+        for (int step = 1; step <= 8; step++) {
+            std::vector<float> normalized(variations.getAxes().size(), 0.0f);
+            normalized[0] = step / 8.0f;
+            fixture.reader.setVariationInstance(variations.createInstance(normalized));
+            arena.reset();
+            for (int i = 0; i < fixture.glyphCount; i++) {
+                if (fixture.reader.loadOutline(i, arena, outline)) read++;
+            }
+        }
+        fixture.reader.setVariationInstance(nullptr);
+        return read;
+    }});
+
+    for (int resolution : {5, 10, 20}) {
+        stages.push_back({"generateGlyphOutline/res" + std::to_string(resolution),
+                          [resolution](FontFixture& fixture) { return flattenAll(fixture, resolution); }});
+    }
+
+    stages.push_back({"flattenGlyphOutline/0.25px@64", [](FontFixture& fixture) -> size_t {
+        static thread_local std::vector<BezierPoint> flattened;
+        float scale = fixture.reader.getUnitsPerEm() ? 64.0f / fixture.reader.getUnitsPerEm() : 1.0f;
+        for (const GlyphOutline& outline : fixture.outlines) {
+            fixture.reader.flattenGlyphOutline(outline, 0.25f, scale, flattened);
+        }
+        return fixture.outlines.size();
+    }});
+
+    stages.push_back({"exportGlyphWithCurves", [](FontFixture& fixture) -> size_t {
+        for (const GlyphOutline& outline : fixture.outlines) {
+            fixture.reader.exportGlyphWithCurves(outline, fixture.exportPath);
+        }
+        return fixture.outlines.size();
+    }});
+
+    stages.push_back({"exportFontSprite/all", [](FontFixture& fixture) -> size_t {
+        SvgSpriteResult result;
+        if (!exportFontSprite(fixture.path, fixture.exportPath, SvgSpriteOptions(), result)) return 0;
+        return result.glyphs;
+    }});
+
+    for (float pixelSize : {16.0f, 48.0f}) {
+        stages.push_back({"rasterizeGlyph/" + std::to_string(static_cast<int>(pixelSize)) + "px",
+                          [pixelSize](FontFixture& fixture) { return rasterizeAll(fixture, pixelSize); }});
+    }
+
+    stages.push_back({"distanceField/64px", [](FontFixture& fixture) { return distanceFieldAll(fixture, 64.0f, false); }});
+    stages.push_back({"distanceField/msdf/64px", [](FontFixture& fixture) { return distanceFieldAll(fixture, 64.0f, true); }});
+
+    stages.push_back({"acquireGlyph/cached", [](FontFixture& fixture) -> size_t {
+        // One cold pass (decode + insert), then one pass of pure hits
+        GlyphCache cache;
+        fixture.reader.setGlyphCache(&cache);
+        size_t found = 0;
+        for (int pass = 0; pass < 2; pass++) {
+            for (int i = 0; i < fixture.glyphCount; i++) {
+                if (fixture.reader.acquireGlyph(i)) found++;
+            }
+        }
+        fixture.reader.setGlyphCache(nullptr);
+        return found;
+    }});
+
+    stages.push_back({"glyphAtlas/16+48px", [](FontFixture& fixture) -> size_t {
+        // Every glyph packed into 1024x1024 pages from cold, pages allocated as needed
+        GlyphAtlasOptions options;
+        options.maxPages = 64;
+        GlyphAtlas atlas(fixture.reader, options);
+        AtlasEntry entry;
+        size_t packed = 0;
+        for (float pixelSize : {16.0f, 48.0f}) {
+            for (int i = 0; i < fixture.glyphCount; i++) {
+                if (atlas.acquire(static_cast<uint16_t>(i), pixelSize, entry)) packed++;
+            }
+        }
+        return packed;
+    }});
+
+    stages.push_back({"loadKerning", [](FontFixture& fixture) -> size_t {
+        KerningTable kerning;
+        fixture.reader.loadKerning(kerning);
+        return kerning.getPairCount() + kerning.getClassSubtableCount();
+    }});
+
+    stages.push_back({"kernRun/1M", [](FontFixture& fixture) -> size_t {
+        // English text mapped once, kerned 256 times over; the table build is
+        // in the timing too (compare with loadKerning)
+        static const char text[] = "AVATAR Type Wave: \"To your office,\" Yvonne wrote. We'll try P.Ty. "
+                                   "The quick brown fox jumps over the lazy dog; LT, VA, Fo, r., y, Tw.";
+        CharMap map;
+        KerningTable kerning;
+        fixture.reader.loadCharMap(map);
+        fixture.reader.loadKerning(kerning);
+        std::vector<uint16_t> glyphs(4096);
+        std::vector<int32_t> adjustments(glyphs.size());
+        for (size_t i = 0; i < glyphs.size(); i++) {
+            glyphs[i] = map.glyphForCodepoint(static_cast<uint8_t>(text[i % (sizeof(text) - 1)]));
+        }
+        int64_t total = 0;
+        for (int pass = 0; pass < 256; pass++) {
+            total += kerning.kernRun(glyphs.data(), glyphs.size(), adjustments.data());
+        }
+        benchSink = benchSink + static_cast<size_t>(total);
+        return glyphs.size() * 256;
+    }});
+
+    stages.push_back({"glyphBounds/scan", [](FontFixture& fixture) -> size_t {
+        GlyphBoundsTable bounds;
+        fixture.reader.loadGlyphBounds(bounds);
+        bounds.resolveComposites();
+        return bounds.glyphCount();
+    }});
+
+    stages.push_back({"glyphBounds/scanParallel", [](FontFixture& fixture) -> size_t {
+        static WorkStealingPool pool;
+        GlyphBoundsTable bounds;
+        bounds.build(*fixture.reader.getFace(), &pool, 1024);
+        return bounds.glyphCount();
+    }});
+
+    stages.push_back({"measureRunInk/100k", [](FontFixture& fixture) -> size_t {
+        // 100k short strings laid out and measured from headers only; with
+        // -DTTF_INSTRUMENTATION, this stage adds nothing to GlyphDecode
+        static const char* words[] = {"Hello,", "world!", "Quartz", "glyph", "AVATAR", "jumpy", "Wave", "fox."};
+        CharMap map;
+        HorizontalMetrics metrics;
+        GlyphBoundsTable bounds;
+        if (!fixture.reader.loadCharMap(map) || !fixture.reader.loadHorizontalMetrics(metrics) ||
+            !fixture.reader.loadGlyphBounds(bounds) || fixture.reader.getUnitsPerEm() == 0) {
+            return 0;
+        }
+        float scale = 16.0f / fixture.reader.getUnitsPerEm();
+        uint16_t glyphs[32];
+        float penX[32];
+        InkBounds ink;
+        float width = 0;
+        for (size_t i = 0; i < 100000; i++) {
+            std::string text = std::string(words[i % 8]) + " " + words[(i / 8) % 8];
+            size_t count = map.mapUtf8(text.data(), text.size(), glyphs);
+            layoutGlyphRun(glyphs, count, metrics, scale, penX);
+            if (measureRunInk(glyphs, count, penX, scale, bounds, ink)) width += ink.xMax - ink.xMin;
+        }
+        benchSink = benchSink + static_cast<size_t>(width);
+        return 100000;
+    }});
+
+    stages.push_back({"rasterizeFontParallel/16+48px", [](FontFixture& fixture) -> size_t {
+        BatchRasterOptions options;
+        options.pixelSizes = {16.0f, 48.0f};
+        BatchRasterResult result;
+        if (!rasterizeFontParallel(fixture.path, options, result)) return 0;
+        return static_cast<size_t>(result.bitmaps);
+    }});
+
+    return stages;
+}
+
+bool stageSelected(const BenchOptions& options, const std::string& name) {
+    if (options.stageFilters.empty()) return true;
+    for (const std::string& filter : options.stageFilters) {
+        if (name.find(filter) != std::string::npos) return true;
+    }
+    return false;
+}
+
+bool prepareFixture(FontFixture& fixture) {
+    if (!fixture.reader.openFont(fixture.path)) return false;
+    fixture.glyphCount = fixture.reader.getNumGlyphs();
+
+    for (int i = 0; i < fixture.glyphCount; i++) {
+        GlyphOutline outline;
+        if (fixture.reader.loadOutline(i, fixture.arena, outline)) fixture.outlines.push_back(outline);
+    }
+    fixture.exportPath = "bench_export.svg";
+    fixture.packPath = "bench_fontpack.pack";
+    return buildFontPack(fixture.path, fixture.packPath);
+}
+
+StageResult runStage(const BenchOptions& options, const BenchStage& stage, FontFixture& fixture) {
+    StageResult result;
+    result.font = fixture.label.empty() ? fixture.path : fixture.label;
+    result.stage = stage.name;
+
+    for (int i = 0; i < options.warmup; i++) result.items = stage.run(fixture);
+
+    result.samples.reserve(options.iterations);
+    for (int i = 0; i < options.iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        result.items = stage.run(fixture);
+        result.samples.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(result.samples.begin(), result.samples.end());
+    return result;
+}
+
+// JSON strings here are paths and stage names; escape the few characters that matter
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+// Synthetic font labels carry comma-separated specs: quote CSV fields (RFC 4180)
+std::string csvField(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+void printResults(const BenchOptions& options, const std::vector<StageResult>& results) {
+    if (options.format == "json") {
+        std::printf("{\n  \"iterations\": %d,\n  \"warmup\": %d,\n  \"results\": [\n", options.iterations, options.warmup);
+        for (size_t i = 0; i < results.size(); i++) {
+            const StageResult& r = results[i];
+            double median = percentile(r.samples, 50);
+            std::printf("    {\"font\": \"%s\", \"stage\": \"%s\", \"items\": %zu, \"min_us\": %.3f, "
+                        "\"median_us\": %.3f, \"p90_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f, "
+                        "\"mean_us\": %.3f, \"stddev_us\": %.3f, \"items_per_sec\": %.1f}%s\n",
+                        jsonEscape(r.font).c_str(), jsonEscape(r.stage).c_str(), r.items,
+                        r.samples.front() * 1e6, median * 1e6, percentile(r.samples, 90) * 1e6,
+                        percentile(r.samples, 99) * 1e6, r.samples.back() * 1e6, mean(r.samples) * 1e6,
+                        stddev(r.samples) * 1e6, median > 0 ? r.items / median : 0.0,
+                        i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    } else if (options.format == "csv") {
+        std::printf("font,stage,items,min_us,median_us,p90_us,p99_us,max_us,mean_us,stddev_us,items_per_sec\n");
+        for (const StageResult& r : results) {
+            double median = percentile(r.samples, 50);
+            std::printf("%s,%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n",
+                        csvField(r.font).c_str(), csvField(r.stage).c_str(), r.items, r.samples.front() * 1e6,
+                        median * 1e6, percentile(r.samples, 90) * 1e6, percentile(r.samples, 99) * 1e6,
+                        r.samples.back() * 1e6, mean(r.samples) * 1e6, stddev(r.samples) * 1e6,
+                        median > 0 ? r.items / median : 0.0);
+        }
+    } else {
+        std::string lastFont;
+        for (const StageResult& r : results) {
+            if (r.font != lastFont) {
+                std::printf("\n%s\n", r.font.c_str());
+                std::printf("  %-32s %8s %12s %12s %12s %14s\n", "stage", "items", "median(us)", "p90(us)",
+                            "p99(us)", "items/s");
+                lastFont = r.font;
+            }
+            double median = percentile(r.samples, 50);
+            std::printf("  %-32s %8zu %12.1f %12.1f %12.1f %14.0f\n", r.stage.c_str(), r.items, median * 1e6,
+                        percentile(r.samples, 90) * 1e6, percentile(r.samples, 99) * 1e6,
+                        median > 0 ? r.items / median : 0.0);
+        }
+    }
+}
+
+// --selftest: each SIMD kernel against its scalar reference on generated
+// inputs, plus the curve flattening error bound. Backends the CPU can't run,
+// or that the build left out, are skipped.
+
+uint64_t nextSelfTestRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+void reportSelfTest(const char* name, size_t cases, size_t failures) {
+    std::printf("  %-40s %8zu cases  %s\n", name, cases, failures ? "FAILED" : "ok");
+}
+
+// Well-formed point streams (flags run-length coded, deltas of every width),
+// the same streams cut short, and plain noise, so the bounds checks are
+// compared as well as the decoded points
+bool checkPointDecode() {
+    const char* name = "point decode: scalar vs SSSE3";
+    if (!pointDecodeBackendSupported(PointDecodeBackend::SSSE3)) {
+        std::printf("  %-40s skipped (not supported)\n", name);
+        return true;
+    }
+    const uint8_t REPEAT = 0x08;
+    uint64_t state = 1;
+    size_t cases = 4000, failures = 0;
+    for (size_t c = 0; c < cases; c++) {
+        uint32_t numPoints = 1 + static_cast<uint32_t>(nextSelfTestRandom(state) % 400);
+        std::vector<uint8_t> data;
+        if (c % 4 == 3) {
+            data.resize(nextSelfTestRandom(state) % (numPoints * 5 + 16));
+            for (uint8_t& b : data) b = static_cast<uint8_t>(nextSelfTestRandom(state));
+        } else {
+            // Flag bits 0-2, 4 and 5; repeats of the previous flag make runs
+            std::vector<uint8_t> flags(numPoints);
+            for (uint32_t i = 0; i < numPoints; i++) {
+                uint64_t r = nextSelfTestRandom(state);
+                flags[i] = (i > 0 && (r & 0x300) == 0) ? flags[i - 1] : static_cast<uint8_t>(r & 0x37);
+            }
+            for (uint32_t i = 0; i < numPoints; ) {
+                uint32_t run = 1;
+                while (i + run < numPoints && run < 256 && flags[i + run] == flags[i]) run++;
+                if (run > 1) {
+                    data.push_back(flags[i] | REPEAT);
+                    data.push_back(static_cast<uint8_t>(run - 1));
+                } else {
+                    data.push_back(flags[i]);
+                }
+                i += run;
+            }
+            for (int axis = 0; axis < 2; axis++) {
+                uint8_t shortBit = axis ? 0x04 : 0x02;
+                uint8_t sameBit = axis ? 0x20 : 0x10;
+                for (uint8_t flag : flags) {
+                    size_t bytes = (flag & shortBit) ? 1 : (flag & sameBit) ? 0 : 2;
+                    for (size_t b = 0; b < bytes; b++) data.push_back(static_cast<uint8_t>(nextSelfTestRandom(state)));
+                }
+            }
+            if (c % 4 == 2) data.resize(nextSelfTestRandom(state) % (data.size() + 1));
+        }
+
+        std::vector<uint8_t> flagsA(numPoints), flagsB(numPoints);
+        std::vector<int16_t> xsA(numPoints), ysA(numPoints), xsB(numPoints), ysB(numPoints);
+        std::vector<uint8_t> onCurveA((numPoints + 7) / 8), onCurveB((numPoints + 7) / 8);
+        size_t scalarBytes = decodeGlyphPointsScalar(data.data(), data.size(), numPoints, flagsA.data(),
+                                                     xsA.data(), ysA.data(), onCurveA.data());
+        size_t simdBytes = decodeGlyphPointsSSSE3(data.data(), data.size(), numPoints, flagsB.data(),
+                                                  xsB.data(), ysB.data(), onCurveB.data());
+        bool same = scalarBytes == simdBytes &&
+                    (scalarBytes == 0 || (xsA == xsB && ysA == ysB && onCurveA == onCurveB));
+        if (!same && failures++ == 0) {
+            std::fprintf(stderr, "point decode mismatch: case %zu, %u points, %zu bytes (scalar %zu, SSSE3 %zu)\n",
+                         c, numPoints, data.size(), scalarBytes, simdBytes);
+        }
+    }
+    reportSelfTest(name, cases, failures);
+    return failures == 0;
+}
+
+// Rows of every width up to a few hundred cells: dense noise, sparse edge
+// cells like a real raster leaves, and overlapping windings past 1.0
+bool checkCoverageKernels() {
+    struct Kernel {
+        const char* name;
+        RasterBackend backend;
+        void (*run)(const int32_t*, uint8_t*, int);
+    };
+    const Kernel kernels[] = {
+        {"coverage rows: scalar vs SSE2", RasterBackend::SSE2, accumulateCoverageRowSSE2},
+        {"coverage rows: scalar vs AVX2", RasterBackend::AVX2, accumulateCoverageRowAVX2},
+    };
+    bool ok = true;
+    for (const Kernel& kernel : kernels) {
+        if (!rasterBackendSupported(kernel.backend)) {
+            std::printf("  %-40s skipped (not supported)\n", kernel.name);
+            continue;
+        }
+        uint64_t state = 2;
+        size_t cases = 3000, failures = 0;
+        for (size_t c = 0; c < cases; c++) {
+            int width = 1 + static_cast<int>(nextSelfTestRandom(state) % 300);
+            std::vector<int32_t> cells(width);
+            for (int32_t& cell : cells) {
+                uint64_t r = nextSelfTestRandom(state);
+                int32_t range = 2 * RASTER_COVERAGE_ONE;
+                if (c % 3 == 0) {
+                    cell = static_cast<int32_t>(r % (2 * range + 1)) - range;
+                } else if (c % 3 == 1) {
+                    cell = (r & 0xF00) ? 0 : static_cast<int32_t>(r % (2 * range + 1)) - range;
+                } else {
+                    cell = (r & 0x300) ? 0 : (static_cast<int32_t>(r % 9) - 4) * RASTER_COVERAGE_ONE;
+                }
+            }
+            std::vector<uint8_t> expected(width), actual(width);
+            accumulateCoverageRowScalar(cells.data(), expected.data(), width);
+            kernel.run(cells.data(), actual.data(), width);
+            if (expected != actual && failures++ == 0) {
+                std::fprintf(stderr, "%s mismatch: case %zu, width %d\n", kernel.name, c, width);
+            }
+        }
+        reportSelfTest(kernel.name, cases, failures);
+        ok = ok && failures == 0;
+    }
+    return ok;
+}
+
+// Deltas with fractions, exact halves of both signs (half rounds up, so
+// -2.5 -> -2), the floats either side of a half, and sums that saturate
+bool checkRoundedDeltas() {
+    const char* name = "delta rounding: scalar vs SSE2";
+    if (!deltaKernelsVectorized()) {
+        std::printf("  %-40s skipped (built without SSE2)\n", name);
+        return true;
+    }
+    uint64_t state = 3;
+    size_t cases = 3000, failures = 0;
+    for (size_t c = 0; c < cases; c++) {
+        size_t count = 1 + nextSelfTestRandom(state) % 100;
+        std::vector<int16_t> coords(count);
+        std::vector<float> deltas(count);
+        for (size_t i = 0; i < count; i++) {
+            uint64_t r = nextSelfTestRandom(state);
+            coords[i] = static_cast<int16_t>(r);
+            float whole = static_cast<float>(static_cast<int32_t>((r >> 16) % 4001) - 2000);
+            switch (c % 4) {
+                case 0:
+                    deltas[i] = whole + static_cast<float>((r >> 32) % 1000) / 1000.0f;
+                    break;
+                case 1:
+                    deltas[i] = whole + ((r >> 32) & 1 ? 0.5f : -0.5f);
+                    break;
+                case 2:
+                    deltas[i] = std::nextafter(whole + 0.5f, (r >> 32) & 1 ? 1e9f : -1e9f);
+                    break;
+                default: {
+                    const float large[] = {32767.0f, 32768.0f, 40000.5f, 65535.0f, 1e6f, 3e9f};
+                    coords[i] = static_cast<int16_t>((r >> 32) & 1 ? 32767 - (r >> 40) % 8 : -32768 + (r >> 40) % 8);
+                    deltas[i] = large[(r >> 48) % 6] * ((r >> 56) & 1 ? 1.0f : -1.0f);
+                    break;
+                }
+            }
+        }
+        std::vector<int16_t> expected = coords, actual = coords;
+        applyRoundedDeltasScalar(expected.data(), deltas.data(), count);
+        applyRoundedDeltas(actual.data(), deltas.data(), count);
+        if (expected != actual && failures++ == 0) {
+            for (size_t i = 0; i < count; i++) {
+                if (expected[i] == actual[i]) continue;
+                std::fprintf(stderr, "delta rounding mismatch: case %zu, %d + %.9g -> %d (scalar %d)\n", c,
+                             coords[i], deltas[i], actual[i], expected[i]);
+                break;
+            }
+        }
+    }
+    reportSelfTest(name, cases, failures);
+    return failures == 0;
+}
+
+// Flattens random quadratics and measures each chord against the curve at
+// the middle of its span in t, where a uniformly split quadratic strays
+// furthest. Every chord must stay within the tolerance it was flattened to.
+bool checkQuadraticFlattening() {
+    const char* name = "quadratic flattening: chord error";
+    TTFReader reader;
+    uint64_t state = 4;
+    size_t cases = 3000, failures = 0;
+    std::vector<BezierPoint> points;
+    for (size_t c = 0; c < cases; c++) {
+        BezierPoint start, control, end;
+        float tolerance;
+        if (c == 0) {
+            // One chord here is 0.5 from the curve, twice the tolerance
+            start = BezierPoint(0.0f, 0.0f);
+            control = BezierPoint(0.5f, 1.0f);
+            end = BezierPoint(1.0f, 0.0f);
+            tolerance = 0.25f;
+        } else {
+            float coords[6];
+            for (float& v : coords) v = static_cast<float>(nextSelfTestRandom(state) % 100001) / 100.0f - 500.0f;
+            start = BezierPoint(coords[0], coords[1]);
+            control = BezierPoint(coords[2], coords[3]);
+            end = BezierPoint(coords[4], coords[5]);
+            tolerance = 0.05f + static_cast<float>(nextSelfTestRandom(state) % 1000) / 500.0f;
+        }
+
+        points.assign(1, start);
+        size_t segments = reader.flattenQuadratic(start, control, end, tolerance, points);
+        float worst = 0.0f;
+        for (size_t i = 0; i < segments; i++) {
+            float t = (i + 0.5f) / segments;
+            float mt = 1.0f - t;
+            float curveX = mt * mt * start.x + 2.0f * mt * t * control.x + t * t * end.x;
+            float curveY = mt * mt * start.y + 2.0f * mt * t * control.y + t * t * end.y;
+            float chordX = (points[i].x + points[i + 1].x) * 0.5f;
+            float chordY = (points[i].y + points[i + 1].y) * 0.5f;
+            worst = std::max(worst, std::hypot(curveX - chordX, curveY - chordY));
+        }
+        // Slack for float rounding in the curve points themselves
+        if (worst > tolerance * 1.001f + 1e-3f && failures++ == 0) {
+            std::fprintf(stderr, "%s: case %zu, %zu segments, %.4f from the curve at tolerance %.4f\n", name, c,
+                         segments, worst, tolerance);
+        }
+    }
+    reportSelfTest(name, cases, failures);
+    return failures == 0;
+}
+
+// Both formats at every length up to a few vectors and then longer runs,
+// read from an odd address, with entries clustered around the edges: short
+// entries near 0xFFFF (offsets near 0x1FFFE) and long ones near 0xFFFF,
+// 0x1FFFE and the top of the range
+bool checkLocaWidening() {
+    const char* name = "loca widening: scalar vs SSSE3";
+    if (!locaWideningVectorized()) {
+        std::printf("  %-40s skipped (not supported)\n", name);
+        return true;
+    }
+    const uint32_t edges[] = {0, 1, 0x7FFF, 0x8000, 0xFFFE, 0xFFFF, 0x10000, 0x1FFFE, 0x1FFFF, 0x20000,
+                              0x7FFFFFFF, 0x80000000, 0xFFFFFFFF};
+    uint64_t state = 5;
+    size_t cases = 0, failures = 0;
+    for (int longFormat = 0; longFormat < 2; longFormat++) {
+        size_t entrySize = longFormat ? 4 : 2;
+        for (size_t c = 0; c < 1000; c++, cases++) {
+            size_t count = c < 64 ? c : 64 + nextSelfTestRandom(state) % 4000;
+            std::vector<uint8_t> buffer(1 + count * entrySize);
+            uint8_t* data = buffer.data() + 1;
+            for (size_t i = 0; i < count; i++) {
+                // Half random, half an edge value give or take one; short
+                // entries keep the low 16 bits
+                uint64_t r = nextSelfTestRandom(state);
+                uint32_t value = static_cast<uint32_t>(r >> 32);
+                if (r & 1) {
+                    uint32_t edge = edges[(r >> 1) % (sizeof(edges) / sizeof(edges[0]))];
+                    value = edge + static_cast<uint32_t>((r >> 8) % 3) - 1;
+                }
+                for (size_t b = 0; b < entrySize; b++) {
+                    data[i * entrySize + b] = static_cast<uint8_t>(value >> (8 * (entrySize - 1 - b)));
+                }
+            }
+            std::vector<uint32_t> expected(count), actual(count);
+            widenLocaOffsetsScalar(data, count, longFormat != 0, expected.data());
+            widenLocaOffsetsSSSE3(data, count, longFormat != 0, actual.data());
+            if (expected != actual && failures++ == 0) {
+                std::fprintf(stderr, "%s mismatch: %s format, %zu entries\n", name,
+                             longFormat ? "long" : "short", count);
+            }
+        }
+    }
+    reportSelfTest(name, cases, failures);
+    return failures == 0;
+}
+
+bool runSelfTest() {
+    bool ok = checkPointDecode();
+    ok = checkLocaWidening() && ok;
+    ok = checkCoverageKernels() && ok;
+    ok = checkRoundedDeltas() && ok;
+    ok = checkQuadraticFlattening() && ok;
+    std::printf("%s\n", ok ? "selftest passed" : "selftest FAILED");
+    return ok;
+}
+
+void printUsage() {
+    std::fprintf(stderr, "usage: text_raster_bench [--iterations N] [--warmup N] [--format text|json|csv]\n"
+                         "                         [--stage NAME]... [--list] [--selftest] [--synthetic SPEC]...\n"
+                         "                         [--counters json|prometheus]\n"
+                         "                         [font.ttf ...]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    std::vector<BenchStage> stages = buildStages();
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--iterations" && hasValue) {
+            options.iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--format" && hasValue) {
+            options.format = argv[++i];
+        } else if (arg == "--stage" && hasValue) {
+            options.stageFilters.push_back(argv[++i]);
+        } else if (arg == "--synthetic" && hasValue) {
+            options.syntheticSpecs.push_back(argv[++i]);
+        } else if (arg == "--counters" && hasValue) {
+            options.counters = argv[++i];
+        } else if (arg == "--list") {
+            for (const BenchStage& stage : stages) std::printf("%s\n", stage.name.c_str());
+            return 0;
+        } else if (arg == "--selftest") {
+            return runSelfTest() ? 0 : 1;
+        } else if (!arg.empty() && arg[0] == '-') {
+            printUsage();
+            return 1;
+        } else {
+            options.fonts.push_back(arg);
+        }
+    }
+    if (options.format != "text" && options.format != "json" && options.format != "csv") {
+        printUsage();
+        return 1;
+    }
+    if (!options.counters.empty() && options.counters != "json" && options.counters != "prometheus") {
+        printUsage();
+        return 1;
+    }
+    if (!options.counters.empty() && !instrumentationEnabled()) {
+        std::fprintf(stderr, "Built without TTF_INSTRUMENTATION; counters will all be zero\n");
+    }
+    if (options.fonts.empty() && options.syntheticSpecs.empty()) {
+        options.fonts.push_back("RobotoMono-VariableFont_wght.ttf");
+    }
+
+    // Synthetic fonts are written next to the export file and removed afterwards
+    size_t fontCount = options.fonts.size() + options.syntheticSpecs.size();
+    std::vector<StageResult> results;
+    for (size_t f = 0; f < fontCount; f++) {
+        FontFixture fixture;
+        bool synthetic = f >= options.fonts.size();
+        if (synthetic) {
+            const std::string& spec = options.syntheticSpecs[f - options.fonts.size()];
+            SyntheticFontOptions fontOptions;
+            fixture.path = "bench_synthetic_" + std::to_string(f) + ".ttf";
+            fixture.label = "synthetic:" + spec;
+            if (!parseSyntheticFontSpec(spec, fontOptions) || !writeSyntheticFont(fontOptions, fixture.path)) {
+                std::fprintf(stderr, "Invalid synthetic font spec: %s\n", spec.c_str());
+                return 1;
+            }
+        } else {
+            fixture.path = options.fonts[f];
+        }
+        const std::string& path = fixture.label.empty() ? fixture.path : fixture.label;
+
+        if (!prepareFixture(fixture)) {
+            std::fprintf(stderr, "Failed to open font: %s\n", path.c_str());
+            if (synthetic) std::remove(fixture.path.c_str());
+            return 1;
+        }
+
+        for (const BenchStage& stage : stages) {
+            if (!stageSelected(options, stage.name)) continue;
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), stage.name.c_str());
+            results.push_back(runStage(options, stage, fixture));
+        }
+        std::remove(fixture.exportPath.c_str());
+        std::remove(fixture.packPath.c_str());
+        if (synthetic) std::remove(fixture.path.c_str());
+    }
+
+    printResults(options, results);
+
+    if (!options.counters.empty()) {
+        InstrumentationSnapshot snapshot;
+        collectInstrumentation(snapshot);
+        std::string text = options.counters == "json" ? formatInstrumentationJSON(snapshot)
+                                                      : formatInstrumentationPrometheus(snapshot);
+        std::fputs(text.c_str(), stderr);
+    }
+    return 0;
+}
@@ -0,0 +1,252 @@
+#include "char_map.h"
+#include <algorithm>
+
+// Subtable preference: full Unicode repertoire first, then BMP
+static int subtableScore(uint16_t platformID, uint16_t encodingID, uint16_t format) {
+    bool unicode = (platformID == 0) || (platformID == 3 && (encodingID == 1 || encodingID == 10));
+    if (!unicode) return 0;
+    if (format == 12) return 2;
+    if (format == 4) return 1;
+    return 0;
+}
+
+bool CharMap::build(ByteSpan cmapTable, size_t maxPages) {
+    clear();
+
+    uint16_t numTables;
+    if (!cmapTable.readU16(2, numTables)) return false;
+    if (!cmapTable.contains(4, static_cast<size_t>(numTables) * 8)) return false;
+
+    // Pick the best subtable from the encoding records
+    int bestScore = 0;
+    uint32_t bestOffset = 0;
+    uint16_t bestFormat = 0;
+    for (uint16_t i = 0; i < numTables; i++) {
+        size_t record = 4 + static_cast<size_t>(i) * 8;
+        uint16_t platformID = cmapTable.u16(record);
+        uint16_t encodingID = cmapTable.u16(record + 2);
+        uint32_t offset = cmapTable.u32(record + 4);
+
+        uint16_t format;
+        if (!cmapTable.readU16(offset, format)) continue;
+
+        int score = subtableScore(platformID, encodingID, format);
+        if (score > bestScore) {
+            bestScore = score;
+            bestOffset = offset;
+            bestFormat = format;
+        }
+    }
+    if (bestScore == 0) return false;
+
+    ByteSpan subtable = cmapTable.subspan(bestOffset, cmapTable.size - bestOffset);
+    bool ok = (bestFormat == 12) ? parseFormat12(subtable) : parseFormat4(subtable);
+    if (!ok) {
+        clear();
+        return false;
+    }
+    subtableFormat = bestFormat;
+
+    // Subtables are supposed to be sorted; don't trust it
+    std::sort(groups.begin(), groups.end(),
+              [](const CharGroup& a, const CharGroup& b) { return a.startCode < b.startCode; });
+    std::vector<CharGroup> cleaned;
+    cleaned.reserve(groups.size());
+    for (const CharGroup& group : groups) {
+        if (!cleaned.empty() && group.startCode <= cleaned.back().endCode) continue; // Overlap - first wins
+        cleaned.push_back(group);
+    }
+    groups.swap(cleaned);
+
+    buildPages(maxPages);
+    return true;
+}
+
+void CharMap::clear() {
+    pageLookup.clear();
+    pageData.clear();
+    groups.clear();
+    subtableFormat = 0;
+}
+
+void CharMap::addMapping(uint32_t codepoint, uint32_t glyph) {
+    if (glyph == 0 || glyph > 0xFFFF || codepoint > MAX_CODEPOINT) return;
+
+    // Extend the previous group when both codepoint and glyph continue the run
+    if (!groups.empty()) {
+        CharGroup& last = groups.back();
+        if (codepoint == last.endCode + 1 && glyph == last.startGlyph + (codepoint - last.startCode)) {
+            last.endCode = codepoint;
+            return;
+        }
+    }
+    groups.push_back(CharGroup{codepoint, codepoint, glyph});
+}
+
+bool CharMap::parseFormat4(ByteSpan subtable) {
+    uint16_t length, segCountX2;
+    if (!subtable.readU16(2, length) || !subtable.readU16(6, segCountX2)) return false;
+    subtable = subtable.subspan(0, std::min<size_t>(length, subtable.size));
+
+    size_t segCount = segCountX2 / 2;
+    size_t endCodes = 14;
+    size_t startCodes = endCodes + segCountX2 + 2; // +2 skips reservedPad
+    size_t idDeltas = startCodes + segCountX2;
+    size_t idRangeOffsets = idDeltas + segCountX2;
+    if (!subtable.contains(endCodes, idRangeOffsets + segCountX2 - endCodes)) return false;
+
+    for (size_t seg = 0; seg < segCount; seg++) {
+        uint32_t endCode = subtable.u16(endCodes + seg * 2);
+        uint32_t startCode = subtable.u16(startCodes + seg * 2);
+        uint16_t idDelta = subtable.u16(idDeltas + seg * 2);
+        size_t rangeOffsetPos = idRangeOffsets + seg * 2;
+        uint16_t idRangeOffset = subtable.u16(rangeOffsetPos);
+        if (startCode > endCode) continue;
+
+        for (uint32_t c = startCode; c <= endCode; c++) {
+            uint32_t glyph;
+            if (idRangeOffset == 0) {
+                glyph = (c + idDelta) & 0xFFFF;
+            } else {
+                // Offset is relative to the idRangeOffset entry itself
+                size_t glyphPos = rangeOffsetPos + idRangeOffset + (c - startCode) * 2;
+                uint16_t raw;
+                if (!subtable.readU16(glyphPos, raw)) break;
+                glyph = raw ? ((raw + idDelta) & 0xFFFF) : 0;
+            }
+            addMapping(c, glyph);
+        }
+    }
+    return true;
+}
+
+bool CharMap::parseFormat12(ByteSpan subtable) {
+    uint32_t numGroups;
+    if (!subtable.readU32(12, numGroups)) return false;
+    if (!subtable.contains(16, static_cast<size_t>(numGroups) * 12)) return false;
+
+    groups.reserve(numGroups);
+    for (uint32_t i = 0; i < numGroups; i++) {
+        size_t record = 16 + static_cast<size_t>(i) * 12;
+        uint32_t startCode = subtable.u32(record);
+        uint32_t endCode = subtable.u32(record + 4);
+        uint32_t startGlyph = subtable.u32(record + 8);
+
+        if (startCode > endCode || startCode > MAX_CODEPOINT) continue;
+        endCode = std::min(endCode, MAX_CODEPOINT);
+        // Glyph ids are 16-bit; trim groups that would run past 0xFFFF
+        if (startGlyph > 0xFFFF) continue;
+        if (endCode - startCode > 0xFFFF - startGlyph) endCode = startCode + (0xFFFF - startGlyph);
+
+        if (startGlyph == 0) {
+            // Glyph 0 is the default anyway - keep the rest of the run
+            if (startCode == endCode) continue;
+            startCode++;
+            startGlyph = 1;
+        }
+        groups.push_back(CharGroup{startCode, endCode, startGlyph});
+    }
+    return true;
+}
+
+void CharMap::buildPages(size_t maxPages) {
+    pageLookup.assign(PAGE_COUNT, 0);
+    pageData.assign(256, 0); // Slot 0: shared empty page
+
+    // Cap so slot numbers stay below PAGE_FALLBACK
+    maxPages = std::min<size_t>(maxPages, PAGE_FALLBACK - 1);
+    size_t pagesUsed = 0;
+
+    // Groups are sorted, so pages fill from low codepoints up - the BMP,
+    // where nearly all text lives, gets flat pages first
+    for (const CharGroup& group : groups) {
+        uint32_t firstPage = group.startCode >> 8;
+        uint32_t lastPage = group.endCode >> 8;
+
+        for (uint32_t page = firstPage; page <= lastPage; page++) {
+            uint16_t& slot = pageLookup[page];
+            if (slot == PAGE_FALLBACK) continue;
+            if (slot == 0) {
+                if (pagesUsed >= maxPages) {
+                    slot = PAGE_FALLBACK;
+                    continue;
+                }
+                pagesUsed++;
+                slot = static_cast<uint16_t>(pagesUsed);
+                pageData.resize(pageData.size() + 256, 0);
+            }
+
+            uint32_t from = std::max(group.startCode, page << 8);
+            uint32_t to = std::min(group.endCode, (page << 8) | 0xFF);
+            uint16_t* data = &pageData[static_cast<size_t>(slot) << 8];
+            for (uint32_t c = from; c <= to; c++) {
+                data[c & 0xFF] = static_cast<uint16_t>(group.startGlyph + (c - group.startCode));
+            }
+        }
+    }
+}
+
+uint16_t CharMap::searchGroups(uint32_t codepoint) const {
+    auto it = std::upper_bound(groups.begin(), groups.end(), codepoint,
+                               [](uint32_t c, const CharGroup& g) { return c < g.startCode; });
+    if (it == groups.begin()) return 0;
+    --it;
+    if (codepoint > it->endCode) return 0;
+    return static_cast<uint16_t>(it->startGlyph + (codepoint - it->startCode));
+}
+
+size_t CharMap::mapUtf32(const uint32_t* codepoints, size_t count, uint16_t* glyphs) const {
+    for (size_t i = 0; i < count; i++) {
+        glyphs[i] = glyphForCodepoint(codepoints[i]);
+    }
+    return count;
+}
+
+size_t CharMap::mapUtf8(const char* text, size_t length, uint16_t* glyphs) const {
+    const uint8_t* s = reinterpret_cast<const uint8_t*>(text);
+    const uint32_t replacement = 0xFFFD;
+    size_t i = 0, out = 0;
+
+    while (i < length) {
+        uint8_t b = s[i];
+
+        // ASCII fast path - no decoding at all
+        if (b < 0x80) {
+            glyphs[out++] = glyphForCodepoint(b);
+            i++;
+            continue;
+        }
+
+        uint32_t cp;
+        size_t need;
+        uint32_t minValue;
+        if ((b & 0xE0) == 0xC0) { cp = b & 0x1F; need = 1; minValue = 0x80; }
+        else if ((b & 0xF0) == 0xE0) { cp = b & 0x0F; need = 2; minValue = 0x800; }
+        else if ((b & 0xF8) == 0xF0) { cp = b & 0x07; need = 3; minValue = 0x10000; }
+        else {
+            glyphs[out++] = glyphForCodepoint(replacement);
+            i++;
+            continue;
+        }
+
+        size_t j = 1;
+        for (; j <= need && i + j < length; j++) {
+            uint8_t c = s[i + j];
+            if ((c & 0xC0) != 0x80) break;
+            cp = (cp << 6) | (c & 0x3F);
+        }
+
+        if (j <= need) {
+            // Truncated sequence: replace, resume at the offending byte
+            glyphs[out++] = glyphForCodepoint(replacement);
+            i += j;
+            continue;
+        }
+
+        // Overlong forms, surrogates and out-of-range values are invalid
+        if (cp < minValue || (cp >= 0xD800 && cp <= 0xDFFF) || cp > MAX_CODEPOINT) cp = replacement;
+        glyphs[out++] = glyphForCodepoint(cp);
+        i += need + 1;
+    }
+    return out;
+}
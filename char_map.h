@@ -0,0 +1,70 @@
+#ifndef CHAR_MAP_H
+#define CHAR_MAP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "font_source.h"
+
+// A run of consecutive codepoints mapped to consecutive glyph ids
+struct CharGroup {
+    uint32_t startCode;
+    uint32_t endCode;       // Inclusive
+    uint32_t startGlyph;
+};
+
+// Codepoint -> glyph index lookup compiled from a 'cmap' subtable
+// (format 4 for the BMP, format 12 for full Unicode).
+//
+// Every mapped 256-codepoint page, up to a budget, is expanded into a flat
+// array, so a lookup is one load of the page number and one load of the
+// glyph id. Pages with no mappings share a single all-zero page. Pages past
+// the budget fall back to a binary search over the sorted groups.
+class CharMap {
+private:
+    static constexpr uint32_t MAX_CODEPOINT = 0x10FFFF;
+    static constexpr uint32_t PAGE_COUNT = (MAX_CODEPOINT + 1) >> 8;
+    static constexpr uint16_t PAGE_FALLBACK = 0xFFFF;
+
+    std::vector<uint16_t> pageLookup;   // PAGE_COUNT entries -> page slot
+    std::vector<uint16_t> pageData;     // 256 glyph ids per slot; slot 0 is all zero
+    std::vector<CharGroup> groups;      // Sorted, non-overlapping
+    int subtableFormat = 0;
+
+    bool parseFormat4(ByteSpan subtable);
+    bool parseFormat12(ByteSpan subtable);
+    void addMapping(uint32_t codepoint, uint32_t glyph);
+    void buildPages(size_t maxPages);
+    uint16_t searchGroups(uint32_t codepoint) const;
+
+public:
+    CharMap() = default;
+
+    // Picks the best Unicode subtable in the 'cmap' table and compiles it.
+    // maxPages caps the flat page memory (512 bytes per page).
+    bool build(ByteSpan cmapTable, size_t maxPages = 1024);
+    void clear();
+
+    bool empty() const { return groups.empty(); }
+    int getSubtableFormat() const { return subtableFormat; }
+    const std::vector<CharGroup>& getGroups() const { return groups; }
+    size_t pageCount() const { return pageData.size() / 256; }
+
+    // Glyph for a codepoint, 0 (.notdef) if unmapped
+    uint16_t glyphForCodepoint(uint32_t codepoint) const {
+        if (codepoint > MAX_CODEPOINT || pageLookup.empty()) return 0;
+        uint16_t page = pageLookup[codepoint >> 8];
+        if (page != PAGE_FALLBACK) {
+            return pageData[(static_cast<size_t>(page) << 8) | (codepoint & 0xFF)];
+        }
+        return searchGroups(codepoint);
+    }
+
+    // Batch mapping. UTF-32: glyphs must hold count entries; returns count.
+    // UTF-8: glyphs must hold length entries (worst case); returns glyphs
+    // written. Malformed sequences map as U+FFFD.
+    size_t mapUtf32(const uint32_t* codepoints, size_t count, uint16_t* glyphs) const;
+    size_t mapUtf8(const char* text, size_t length, uint16_t* glyphs) const;
+};
+
+#endif
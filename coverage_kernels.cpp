@@ -0,0 +1,206 @@
+#include "coverage_kernels.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COVERAGE_KERNELS_X86 1
+#endif
+
+// Shared tail / reference: running sum, |winding| clamped to 1 (non-zero
+// rule), then rounded to 0..255. Returns the running sum for the SIMD callers.
+static inline int32_t accumulateScalarFrom(const int32_t* cells, uint8_t* dst, int begin, int end, int32_t acc) {
+    for (int x = begin; x < end; x++) {
+        acc += cells[x];
+        int32_t a = std::abs(acc);
+        if (a > RASTER_COVERAGE_ONE) a = RASTER_COVERAGE_ONE;
+        dst[x] = static_cast<uint8_t>((a * 255 + RASTER_COVERAGE_ONE / 2) >> RASTER_COVERAGE_SHIFT);
+    }
+    return acc;
+}
+
+void accumulateCoverageRowScalar(const int32_t* cells, uint8_t* dst, int width) {
+    accumulateScalarFrom(cells, dst, 0, width, 0);
+}
+
+#ifdef COVERAGE_KERNELS_X86
+
+// SSE2 has no abs/min/mullo for 32-bit lanes, so those are built from
+// shifts, compares and masks. Four cells per step.
+__attribute__((target("sse2")))
+static inline __m128i coverageToAlphaSSE2(__m128i acc) {
+    const __m128i one = _mm_set1_epi32(RASTER_COVERAGE_ONE);
+    const __m128i half = _mm_set1_epi32(RASTER_COVERAGE_ONE / 2);
+
+    __m128i sign = _mm_srai_epi32(acc, 31);
+    __m128i a = _mm_sub_epi32(_mm_xor_si128(acc, sign), sign);           // |acc|
+    __m128i over = _mm_cmpgt_epi32(a, one);
+    a = _mm_or_si128(_mm_andnot_si128(over, a), _mm_and_si128(over, one)); // min(|acc|, 1.0)
+    a = _mm_sub_epi32(_mm_slli_epi32(a, 8), a);                          // * 255
+    return _mm_srai_epi32(_mm_add_epi32(a, half), RASTER_COVERAGE_SHIFT);
+}
+
+__attribute__((target("sse2")))
+static void accumulateSSE2Impl(const int32_t* cells, uint8_t* dst, int width) {
+    __m128i carry = _mm_setzero_si128();
+    int x = 0;
+
+    for (; x + 8 <= width; x += 8) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + x));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + x + 4));
+
+        // In-register inclusive prefix sum, then add the running total
+        lo = _mm_add_epi32(lo, _mm_slli_si128(lo, 4));
+        lo = _mm_add_epi32(lo, _mm_slli_si128(lo, 8));
+        lo = _mm_add_epi32(lo, carry);
+        carry = _mm_shuffle_epi32(lo, 0xFF);
+
+        hi = _mm_add_epi32(hi, _mm_slli_si128(hi, 4));
+        hi = _mm_add_epi32(hi, _mm_slli_si128(hi, 8));
+        hi = _mm_add_epi32(hi, carry);
+        carry = _mm_shuffle_epi32(hi, 0xFF);
+
+        // 8 x int32 (all 0..255) -> 8 bytes
+        __m128i words = _mm_packs_epi32(coverageToAlphaSSE2(lo), coverageToAlphaSSE2(hi));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(words, words));
+    }
+
+    accumulateScalarFrom(cells, dst, x, width, _mm_cvtsi128_si32(carry));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i prefixSumAVX2(__m256i v, __m256i carry) {
+    // Prefix sum within each 128-bit half, then carry the low half's total
+    // into the high half
+    v = _mm256_add_epi32(v, _mm256_slli_si256(v, 4));
+    v = _mm256_add_epi32(v, _mm256_slli_si256(v, 8));
+    __m256i lowTotal = _mm256_permutevar8x32_epi32(v, _mm256_set1_epi32(3));
+    v = _mm256_add_epi32(v, _mm256_blend_epi32(_mm256_setzero_si256(), lowTotal, 0xF0));
+    return _mm256_add_epi32(v, carry);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i coverageToAlphaAVX2(__m256i acc) {
+    __m256i a = _mm256_min_epi32(_mm256_abs_epi32(acc), _mm256_set1_epi32(RASTER_COVERAGE_ONE));
+    a = _mm256_sub_epi32(_mm256_slli_epi32(a, 8), a);
+    return _mm256_srai_epi32(_mm256_add_epi32(a, _mm256_set1_epi32(RASTER_COVERAGE_ONE / 2)),
+                             RASTER_COVERAGE_SHIFT);
+}
+
+__attribute__((target("avx2")))
+static void accumulateAVX2Impl(const int32_t* cells, uint8_t* dst, int width) {
+    const __m256i lastLane = _mm256_set1_epi32(7);
+    __m256i carry = _mm256_setzero_si256();
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + x));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(cells + x + 8));
+
+        lo = prefixSumAVX2(lo, carry);
+        carry = _mm256_permutevar8x32_epi32(lo, lastLane);
+        hi = prefixSumAVX2(hi, carry);
+        carry = _mm256_permutevar8x32_epi32(hi, lastLane);
+
+        // 16 x int32 -> 16 bytes. The packs work per 128-bit half, so
+        // permute the 64-bit quarters back into order after each one.
+        __m256i words = _mm256_packs_epi32(coverageToAlphaAVX2(lo), coverageToAlphaAVX2(hi));
+        words = _mm256_permute4x64_epi64(words, 0xD8);
+        __m256i bytes = _mm256_packus_epi16(words, words);
+        bytes = _mm256_permute4x64_epi64(bytes, 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm256_castsi256_si128(bytes));
+    }
+
+    accumulateScalarFrom(cells, dst, x, width, _mm256_cvtsi256_si32(carry));
+}
+
+#endif
+
+void accumulateCoverageRowSSE2(const int32_t* cells, uint8_t* dst, int width) {
+#ifdef COVERAGE_KERNELS_X86
+    accumulateSSE2Impl(cells, dst, width);
+#else
+    accumulateCoverageRowScalar(cells, dst, width);
+#endif
+}
+
+void accumulateCoverageRowAVX2(const int32_t* cells, uint8_t* dst, int width) {
+#ifdef COVERAGE_KERNELS_X86
+    accumulateAVX2Impl(cells, dst, width);
+#else
+    accumulateCoverageRowScalar(cells, dst, width);
+#endif
+}
+
+const char* rasterBackendName(RasterBackend backend) {
+    switch (backend) {
+        case RasterBackend::Auto: return "auto";
+        case RasterBackend::Scalar: return "scalar";
+        case RasterBackend::SSE2: return "sse2";
+        case RasterBackend::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+bool rasterBackendSupported(RasterBackend backend) {
+    switch (backend) {
+        case RasterBackend::Auto:
+        case RasterBackend::Scalar:
+            return true;
+#ifdef COVERAGE_KERNELS_X86
+        case RasterBackend::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case RasterBackend::AVX2:
+            return __builtin_cpu_supports("avx2");
+#else
+        case RasterBackend::SSE2:
+        case RasterBackend::AVX2:
+            return false;
+#endif
+    }
+    return false;
+}
+
+typedef void (*CoverageRowKernel)(const int32_t*, uint8_t*, int);
+
+static RasterBackend bestBackend() {
+    if (rasterBackendSupported(RasterBackend::AVX2)) return RasterBackend::AVX2;
+    if (rasterBackendSupported(RasterBackend::SSE2)) return RasterBackend::SSE2;
+    return RasterBackend::Scalar;
+}
+
+static CoverageRowKernel kernelFor(RasterBackend backend) {
+    switch (backend) {
+        case RasterBackend::SSE2: return accumulateCoverageRowSSE2;
+        case RasterBackend::AVX2: return accumulateCoverageRowAVX2;
+        default: return accumulateCoverageRowScalar;
+    }
+}
+
+// Resolved on first use so the CPU check happens once, not per row
+static std::atomic<RasterBackend> selectedBackend{RasterBackend::Auto};
+static std::atomic<CoverageRowKernel> selectedKernel{nullptr};
+
+bool setRasterBackend(RasterBackend backend) {
+    if (!rasterBackendSupported(backend)) return false;
+    if (backend == RasterBackend::Auto) backend = bestBackend();
+
+    selectedBackend.store(backend, std::memory_order_relaxed);
+    selectedKernel.store(kernelFor(backend), std::memory_order_release);
+    return true;
+}
+
+RasterBackend getRasterBackend() {
+    if (!selectedKernel.load(std::memory_order_acquire)) setRasterBackend(RasterBackend::Auto);
+    return selectedBackend.load(std::memory_order_relaxed);
+}
+
+void accumulateCoverageRow(const int32_t* cells, uint8_t* dst, int width) {
+    CoverageRowKernel kernel = selectedKernel.load(std::memory_order_acquire);
+    if (!kernel) {
+        setRasterBackend(RasterBackend::Auto);
+        kernel = selectedKernel.load(std::memory_order_acquire);
+    }
+    kernel(cells, dst, width);
+}
@@ -0,0 +1,38 @@
+#ifndef COVERAGE_KERNELS_H
+#define COVERAGE_KERNELS_H
+
+#include <cstdint>
+
+// Accumulation cells are 16.16 fixed point signed area; 1.0 = full coverage.
+// Integer cells keep the prefix sum exact whatever order it's computed in.
+const int RASTER_COVERAGE_SHIFT = 16;
+const int32_t RASTER_COVERAGE_ONE = 1 << RASTER_COVERAGE_SHIFT;
+
+// Implementations of the accumulation pass (running sum of signed area cells
+// -> 8-bit alpha). All backends do exact integer math, so every backend
+// produces bit-identical bitmaps.
+enum class RasterBackend {
+    Auto,       // Best one the CPU supports
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+const char* rasterBackendName(RasterBackend backend);
+bool rasterBackendSupported(RasterBackend backend);
+
+// Selects the kernel used by rasterizeGlyph. Returns false (and keeps the
+// current one) if the CPU can't run it. Auto picks the fastest available.
+bool setRasterBackend(RasterBackend backend);
+RasterBackend getRasterBackend();
+
+// Converts one row of accumulation cells into alpha using the selected backend
+void accumulateCoverageRow(const int32_t* cells, uint8_t* dst, int width);
+
+// Direct entry points, mainly for differential testing and benchmarks.
+// The SIMD ones fall back to scalar on builds without x86 kernels.
+void accumulateCoverageRowScalar(const int32_t* cells, uint8_t* dst, int width);
+void accumulateCoverageRowSSE2(const int32_t* cells, uint8_t* dst, int width);
+void accumulateCoverageRowAVX2(const int32_t* cells, uint8_t* dst, int width);
+
+#endif
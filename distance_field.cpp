@@ -0,0 +1,570 @@
+#include "distance_field.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+typedef DistanceFieldGenerator::Segment FieldSegment;
+
+// Edge colours: each one is two of the three channels, so neighbouring
+// edges always share exactly one channel
+static const uint8_t CHANNEL_ALL = 7;
+static const uint8_t EDGE_COLORS[3] = {6, 5, 3}; // Cyan, magenta, yellow
+
+// Directions closer than this (sine of the angle) don't make a corner
+static const float CORNER_CROSS_THRESHOLD = 0.14f;
+
+static inline BezierPoint pointAt(const FieldSegment& s, float t) {
+    float mt = 1.0f - t;
+    return BezierPoint(mt * mt * s.p0.x + 2.0f * mt * t * s.p1.x + t * t * s.p2.x,
+                       mt * mt * s.p0.y + 2.0f * mt * t * s.p1.y + t * t * s.p2.y);
+}
+
+// Tangent at t (not normalized). A control point sitting on an endpoint
+// gives a zero derivative there; the chord direction stands in for it.
+static inline BezierPoint directionAt(const FieldSegment& s, float t) {
+    BezierPoint d(2.0f * ((s.p1.x - s.p0.x) * (1.0f - t) + (s.p2.x - s.p1.x) * t),
+                  2.0f * ((s.p1.y - s.p0.y) * (1.0f - t) + (s.p2.y - s.p1.y) * t));
+    if (d.x == 0.0f && d.y == 0.0f) return BezierPoint(s.p2.x - s.p0.x, s.p2.y - s.p0.y);
+    return d;
+}
+
+static inline BezierPoint normalized(const BezierPoint& v) {
+    float length = std::sqrt(v.x * v.x + v.y * v.y);
+    return length > 0.0f ? BezierPoint(v.x / length, v.y / length) : BezierPoint(0.0f, 0.0f);
+}
+
+static inline float cross(const BezierPoint& a, const BezierPoint& b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+static inline float dot(const BezierPoint& a, const BezierPoint& b) {
+    return a.x * b.x + a.y * b.y;
+}
+
+// Real roots of a*t^2 + b*t + c
+static int solveQuadratic(double roots[2], double a, double b, double c) {
+    if (std::fabs(a) < 1e-14) {
+        if (std::fabs(b) < 1e-14) return 0;
+        roots[0] = -c / b;
+        return 1;
+    }
+    double discriminant = b * b - 4.0 * a * c;
+    if (discriminant < 0.0) return 0;
+    if (discriminant == 0.0) {
+        roots[0] = -b / (2.0 * a);
+        return 1;
+    }
+    double root = std::sqrt(discriminant);
+    roots[0] = (-b + root) / (2.0 * a);
+    roots[1] = (-b - root) / (2.0 * a);
+    return 2;
+}
+
+// Real roots of a*t^3 + b*t^2 + c*t + d (trigonometric / Cardano)
+static int solveCubic(double roots[3], double a, double b, double c, double d) {
+    if (std::fabs(a) < 1e-14 || std::fabs(b / a) > 1e6) return solveQuadratic(roots, b, c, d);
+
+    double an = b / a, bn = c / a, cn = d / a;
+    double an2 = an * an;
+    double q = (an2 - 3.0 * bn) / 9.0;
+    double r = (an * (2.0 * an2 - 9.0 * bn) + 27.0 * cn) / 54.0;
+    double r2 = r * r, q3 = q * q * q;
+    an /= 3.0;
+
+    if (r2 < q3) {
+        double t = std::acos(std::max(-1.0, std::min(1.0, r / std::sqrt(q3))));
+        double m = -2.0 * std::sqrt(q);
+        const double twoPi = 6.28318530717958647692;
+        roots[0] = m * std::cos(t / 3.0) - an;
+        roots[1] = m * std::cos((t + twoPi) / 3.0) - an;
+        roots[2] = m * std::cos((t - twoPi) / 3.0) - an;
+        return 3;
+    }
+
+    double u = (r < 0.0 ? 1.0 : -1.0) * std::cbrt(std::fabs(r) + std::sqrt(r2 - q3));
+    double v = u == 0.0 ? 0.0 : q / u;
+    roots[0] = (u + v) - an;
+    if (std::fabs(u - v) < 1e-12 * std::fabs(u + v)) {
+        roots[1] = -0.5 * (u + v) - an;
+        return 2;
+    }
+    return 1;
+}
+
+// Closest point on a segment to p: returns its parameter, squared distance in distanceSq
+static float closestParameter(const FieldSegment& s, const BezierPoint& p, float& distanceSq) {
+    if (!s.quadratic) {
+        float dx = s.p2.x - s.p0.x, dy = s.p2.y - s.p0.y;
+        float lengthSq = dx * dx + dy * dy;
+        float t = lengthSq > 0.0f ? ((p.x - s.p0.x) * dx + (p.y - s.p0.y) * dy) / lengthSq : 0.0f;
+        t = std::min(1.0f, std::max(0.0f, t));
+        float ex = s.p0.x + dx * t - p.x, ey = s.p0.y + dy * t - p.y;
+        distanceSq = ex * ex + ey * ey;
+        return t;
+    }
+
+    // d/dt |B(t) - p|^2 = 0 with B(t) = p0 + 2t*a + t^2*b is a cubic in t
+    double ax = s.p1.x - s.p0.x, ay = s.p1.y - s.p0.y;
+    double bx = s.p2.x - 2.0 * s.p1.x + s.p0.x, by = s.p2.y - 2.0 * s.p1.y + s.p0.y;
+    double mx = s.p0.x - p.x, my = s.p0.y - p.y;
+    double roots[3];
+    int count = solveCubic(roots, bx * bx + by * by, 3.0 * (ax * bx + ay * by),
+                           2.0 * (ax * ax + ay * ay) + mx * bx + my * by, mx * ax + my * ay);
+
+    // Endpoints are always candidates
+    float ex = s.p0.x - p.x, ey = s.p0.y - p.y;
+    float best = ex * ex + ey * ey, bestT = 0.0f;
+    ex = s.p2.x - p.x;
+    ey = s.p2.y - p.y;
+    if (ex * ex + ey * ey < best) {
+        best = ex * ex + ey * ey;
+        bestT = 1.0f;
+    }
+    for (int i = 0; i < count; i++) {
+        if (roots[i] <= 0.0 || roots[i] >= 1.0) continue;
+        float t = static_cast<float>(roots[i]);
+        BezierPoint q = pointAt(s, t);
+        float d = (q.x - p.x) * (q.x - p.x) + (q.y - p.y) * (q.y - p.y);
+        if (d < best) {
+            best = d;
+            bestT = t;
+        }
+    }
+    distanceSq = best;
+    return bestT;
+}
+
+// Signed distance, positive inside. TrueType fills to the right of the
+// contour direction (clockwise outer contours, y up). Past an endpoint the
+// distance to the edge's extended tangent is used when it's closer - that
+// pseudo-distance is what keeps multi-channel corners sharp.
+static float signedPseudoDistance(const FieldSegment& s, const BezierPoint& p, float t, float distance) {
+    BezierPoint q = pointAt(s, t);
+    BezierPoint v(p.x - q.x, p.y - q.y);
+    float signedDistance = cross(directionAt(s, t), v) < 0.0f ? distance : -distance;
+
+    if (t <= 0.0f) {
+        BezierPoint dir = normalized(directionAt(s, 0.0f));
+        BezierPoint aq(p.x - s.p0.x, p.y - s.p0.y);
+        if (dot(aq, dir) < 0.0f) {
+            float pseudo = -cross(dir, aq);
+            if (std::fabs(pseudo) <= distance) return pseudo;
+        }
+    } else if (t >= 1.0f) {
+        BezierPoint dir = normalized(directionAt(s, 1.0f));
+        BezierPoint bq(p.x - s.p2.x, p.y - s.p2.y);
+        if (dot(bq, dir) > 0.0f) {
+            float pseudo = -cross(dir, bq);
+            if (std::fabs(pseudo) <= distance) return pseudo;
+        }
+    }
+    return signedDistance;
+}
+
+// Squared distance from p to a segment's bounding box
+static inline float boxDistanceSq(const FieldSegment& s, const BezierPoint& p) {
+    float dx = std::max(std::max(s.minX - p.x, p.x - s.maxX), 0.0f);
+    float dy = std::max(std::max(s.minY - p.y, p.y - s.maxY), 0.0f);
+    return dx * dx + dy * dy;
+}
+
+// Where a horizontal line crosses the outline, with the crossing's direction
+struct RowCrossing {
+    float x;
+    int winding;
+    bool operator<(const RowCrossing& other) const { return x < other.x; }
+};
+
+// Each y-monotone piece counts when min <= y < max, so a row passing exactly
+// through a vertex counts it once on a slope and zero or two times at a
+// local extremum - the same rule the winding of the filled shape follows
+static void addMonotoneCrossing(const FieldSegment& s, double a, double b, double t0, double t1, float y,
+                                std::vector<RowCrossing>& crossings) {
+    float y0 = pointAt(s, static_cast<float>(t0)).y;
+    float y1 = pointAt(s, static_cast<float>(t1)).y;
+    if (y0 == y1 || y < std::min(y0, y1) || y >= std::max(y0, y1)) return;
+
+    double t = 0.5 * (t0 + t1);
+    double roots[2];
+    int count = solveQuadratic(roots, a, b, s.p0.y - y);
+    for (int i = 0; i < count; i++) {
+        if (roots[i] >= t0 - 1e-9 && roots[i] <= t1 + 1e-9) t = std::min(t1, std::max(t0, roots[i]));
+    }
+    crossings.push_back({pointAt(s, static_cast<float>(t)).x, y1 > y0 ? 1 : -1});
+}
+
+static void collectCrossings(const FieldSegment& s, float y, std::vector<RowCrossing>& crossings) {
+    if (y < s.minY || y > s.maxY) return;
+
+    if (!s.quadratic) {
+        float y0 = s.p0.y, y1 = s.p2.y;
+        if (y0 == y1 || y < std::min(y0, y1) || y >= std::max(y0, y1)) return;
+        float t = (y - y0) / (y1 - y0);
+        crossings.push_back({s.p0.x + (s.p2.x - s.p0.x) * t, y1 > y0 ? 1 : -1});
+        return;
+    }
+
+    // y(t) = a*t^2 + b*t + p0.y; split at its extremum
+    double a = s.p0.y - 2.0 * s.p1.y + s.p2.y;
+    double b = 2.0 * (s.p1.y - s.p0.y);
+    double extremum = a != 0.0 ? -b / (2.0 * a) : -1.0;
+    if (extremum > 0.0 && extremum < 1.0) {
+        addMonotoneCrossing(s, a, b, 0.0, extremum, y, crossings);
+        addMonotoneCrossing(s, a, b, extremum, 1.0, y, crossings);
+    } else {
+        addMonotoneCrossing(s, a, b, 0.0, 1.0, y, crossings);
+    }
+}
+
+static inline uint8_t encodeDistance(float distance, float spread) {
+    float v = (0.5f + distance / (2.0f * spread)) * 255.0f;
+    return static_cast<uint8_t>(std::lrintf(std::min(255.0f, std::max(0.0f, v))));
+}
+
+static inline float median(float a, float b, float c) {
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// Whether pixel a should be flattened to plain distance because of its
+// neighbour b. Two rules:
+//   - both are on the same side of the edge, but the median of the blended
+//     channels flips somewhere between them (a false edge when filtered)
+//   - the two most different channels both jump by more than one pixel of
+//     distance; of the pair, only the pixel farther from the edge is flagged
+static bool channelsClash(const uint8_t* a, const uint8_t* b, float threshold) {
+    bool insideA = median(a[0], a[1], a[2]) > 127.5f;
+    if (insideA == (median(b[0], b[1], b[2]) > 127.5f)) {
+        for (float f : {0.25f, 0.5f, 0.75f}) {
+            float m = median(a[0] + (b[0] - a[0]) * f, a[1] + (b[1] - a[1]) * f, a[2] + (b[2] - a[2]) * f);
+            if ((m > 127.5f) != insideA) return true;
+        }
+    }
+
+    int order[3] = {0, 1, 2};
+    std::sort(order, order + 3, [a, b](int i, int j) { return std::abs(b[i] - a[i]) > std::abs(b[j] - a[j]); });
+    if (std::abs(b[order[1]] - a[order[1]]) < threshold) return false;
+    if (b[0] == b[1] && b[0] == b[2]) return false; // Neighbour already equalized
+    return std::abs(a[order[2]] - 127.5f) >= std::abs(b[order[2]] - 127.5f);
+}
+
+// Sets flagged pixels to their median, turning them into plain distance
+static void correctChannelClashes(GlyphBitmap& out, int width, int height, float spread) {
+    float threshold = 1.001f / (2.0f * spread) * 255.0f;  // One pixel of distance
+    std::vector<uint8_t> clashes(static_cast<size_t>(width) * height, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t* a = out.pixels + static_cast<size_t>(y) * out.stride + x * 3;
+            bool clash = (x > 0 && channelsClash(a, a - 3, threshold)) ||
+                         (x + 1 < width && channelsClash(a, a + 3, threshold)) ||
+                         (y > 0 && channelsClash(a, a - out.stride, threshold)) ||
+                         (y + 1 < height && channelsClash(a, a + out.stride, threshold));
+            clashes[static_cast<size_t>(y) * width + x] = clash;
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            if (!clashes[static_cast<size_t>(y) * width + x]) continue;
+            uint8_t* a = out.pixels + static_cast<size_t>(y) * out.stride + x * 3;
+            a[0] = a[1] = a[2] = static_cast<uint8_t>(median(a[0], a[1], a[2]));
+        }
+    }
+}
+
+RasterPlacement computeDistanceFieldPlacement(const GlyphHeader& header, float pixelSize, uint16_t unitsPerEm,
+                                              float spread, float subpixelX, float subpixelY) {
+    RasterPlacement placement = computeRasterPlacement(header, pixelSize, unitsPerEm, subpixelX, subpixelY);
+    if (placement.width <= 0 || placement.height <= 0) return placement;
+
+    int pad = static_cast<int>(std::ceil(std::max(spread, 0.0f)));
+    placement.left -= pad;
+    placement.top += pad;
+    placement.width += 2 * pad;
+    placement.height += 2 * pad;
+    return placement;
+}
+
+// Collects outline segments in pixel space
+struct SegmentSink {
+    std::vector<FieldSegment>* segments;
+    std::vector<size_t>* contourEnds;
+    float scale, offsetX, offsetY;
+    BezierPoint current;
+
+    BezierPoint toPixels(const BezierPoint& p) const {
+        return BezierPoint(p.x * scale + offsetX, p.y * scale + offsetY);
+    }
+
+    void add(const BezierPoint& p0, const BezierPoint& p1, const BezierPoint& p2, bool quadratic) {
+        FieldSegment s;
+        s.p0 = p0;
+        s.p1 = p1;
+        s.p2 = p2;
+        s.quadratic = quadratic;
+        s.minX = std::min(std::min(p0.x, p1.x), p2.x);
+        s.minY = std::min(std::min(p0.y, p1.y), p2.y);
+        s.maxX = std::max(std::max(p0.x, p1.x), p2.x);
+        s.maxY = std::max(std::max(p0.y, p1.y), p2.y);
+        segments->push_back(s);
+    }
+
+    void moveTo(const BezierPoint& p) {
+        current = toPixels(p);
+    }
+    void lineTo(const BezierPoint& p) {
+        BezierPoint next = toPixels(p);
+        if (next.x == current.x && next.y == current.y) return;
+        add(current, BezierPoint((current.x + next.x) * 0.5f, (current.y + next.y) * 0.5f), next, false);
+        current = next;
+    }
+    void quadTo(const BezierPoint& c, const BezierPoint& p) {
+        BezierPoint control = toPixels(c);
+        BezierPoint next = toPixels(p);
+        if (next.x == current.x && next.y == current.y && control.x == current.x && control.y == current.y) return;
+        // A control point on the chord is just a line
+        float area = cross(BezierPoint(control.x - current.x, control.y - current.y),
+                           BezierPoint(next.x - current.x, next.y - current.y));
+        add(current, control, next, area != 0.0f);
+        current = next;
+    }
+    void closePath() {
+        contourEnds->push_back(segments->size());
+    }
+};
+
+void DistanceFieldGenerator::buildSegments(const GlyphOutline& glyph, const RasterPlacement& placement) {
+    segments.clear();
+    std::vector<size_t> contourEnds;
+
+    SegmentSink sink;
+    sink.segments = &segments;
+    sink.contourEnds = &contourEnds;
+    sink.scale = placement.scale;
+    sink.offsetX = placement.shiftX - placement.left;
+    sink.offsetY = placement.shiftY - (placement.top - placement.height);
+    walkGlyphContours(glyph, sink);
+
+    size_t start = 0;
+    for (size_t end : contourEnds) {
+        colorEdges(start, end);
+        start = end;
+    }
+}
+
+// Splits a contour into runs between sharp corners and gives neighbouring
+// runs different colours. Smooth contours stay white (all channels).
+void DistanceFieldGenerator::colorEdges(size_t contourStart, size_t contourEnd) {
+    size_t count = contourEnd - contourStart;
+    if (count == 0) return;
+    FieldSegment* edges = segments.data() + contourStart;
+
+    std::vector<size_t> corners;
+    BezierPoint previous = normalized(directionAt(edges[count - 1], 1.0f));
+    for (size_t i = 0; i < count; i++) {
+        BezierPoint next = normalized(directionAt(edges[i], 0.0f));
+        if (dot(previous, next) <= 0.0f || std::fabs(cross(previous, next)) > CORNER_CROSS_THRESHOLD) {
+            corners.push_back(i);
+        }
+        previous = normalized(directionAt(edges[i], 1.0f));
+    }
+
+    if (corners.empty()) {
+        for (size_t i = 0; i < count; i++) edges[i].channels = CHANNEL_ALL;
+    } else if (corners.size() == 1) {
+        // Teardrop: thirds in two colours with white between them
+        const uint8_t colors[3] = {EDGE_COLORS[0], CHANNEL_ALL, EDGE_COLORS[2]};
+        for (size_t k = 0; k < count; k++) {
+            size_t third = count < 3 ? (k == 0 ? 0 : 2) : k * 3 / count;
+            edges[(corners[0] + k) % count].channels = colors[third];
+        }
+    } else {
+        size_t runs = corners.size();
+        for (size_t run = 0; run < runs; run++) {
+            uint8_t color = EDGE_COLORS[run % 3];
+            // A last run that would meet the first one in the same colour takes the third colour
+            if (run == runs - 1 && runs % 3 == 1) color = EDGE_COLORS[1];
+            size_t end = run + 1 < runs ? corners[run + 1] : corners[0] + count;
+            for (size_t k = corners[run]; k < end; k++) edges[k % count].channels = color;
+        }
+    }
+}
+
+// Buckets segments by bounding box into spread-sized cells
+void DistanceFieldGenerator::buildGrid(int width, int height, float spread) {
+    cellSize = std::max(spread, 1.0f);
+    gridWidth = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+    gridHeight = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+
+    auto cellX = [this](float x) { return std::min(gridWidth - 1, std::max(0, static_cast<int>(std::floor(x / cellSize)))); };
+    auto cellY = [this](float y) { return std::min(gridHeight - 1, std::max(0, static_cast<int>(std::floor(y / cellSize)))); };
+
+    size_t cells = static_cast<size_t>(gridWidth) * gridHeight;
+    cellStart.assign(cells + 1, 0);
+    for (const FieldSegment& s : segments) {
+        for (int cy = cellY(s.minY); cy <= cellY(s.maxY); cy++) {
+            for (int cx = cellX(s.minX); cx <= cellX(s.maxX); cx++) {
+                cellStart[static_cast<size_t>(cy) * gridWidth + cx + 1]++;
+            }
+        }
+    }
+    for (size_t c = 0; c < cells; c++) cellStart[c + 1] += cellStart[c];
+
+    cellSegments.resize(cellStart[cells]);
+    std::vector<uint32_t> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < segments.size(); i++) {
+        const FieldSegment& s = segments[i];
+        for (int cy = cellY(s.minY); cy <= cellY(s.maxY); cy++) {
+            for (int cx = cellX(s.minX); cx <= cellX(s.maxX); cx++) {
+                cellSegments[fill[static_cast<size_t>(cy) * gridWidth + cx]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+}
+
+void DistanceFieldGenerator::renderRows(int rowBegin, int rowEnd, int width, int height,
+                                        const DistanceFieldOptions& options, GlyphBitmap& out) const {
+    const float spread = options.spread;
+    const bool multi = options.multiChannel;
+
+    // A segment sits in every cell its box touches; stamps skip repeats per pixel
+    std::vector<uint32_t> visited(segments.size(), 0);
+    uint32_t stamp = 0;
+    std::vector<RowCrossing> crossings;
+
+    for (int row = rowBegin; row < rowEnd; row++) {
+        uint8_t* dest = out.pixels + static_cast<size_t>(row) * out.stride;
+        float y = height - row - 0.5f;
+
+        crossings.clear();
+        for (const FieldSegment& s : segments) collectCrossings(s, y, crossings);
+        std::sort(crossings.begin(), crossings.end());
+        size_t nextCrossing = 0;
+        int winding = 0;
+
+        int cy0 = std::max(0, static_cast<int>(std::floor((y - spread) / cellSize)));
+        int cy1 = std::min(gridHeight - 1, static_cast<int>(std::floor((y + spread) / cellSize)));
+
+        for (int col = 0; col < width; col++) {
+            BezierPoint p(col + 0.5f, y);
+            while (nextCrossing < crossings.size() && crossings[nextCrossing].x < p.x) {
+                winding += crossings[nextCrossing++].winding;
+            }
+            bool inside = winding != 0;
+
+            // Per channel: nearest segment, its distance and parameter
+            float bestSq[3] = {spread * spread, spread * spread, spread * spread};
+            float bestDot[3] = {0, 0, 0};
+            float bestT[3] = {0, 0, 0};
+            int bestSegment[3] = {-1, -1, -1};
+            float limitSq = spread * spread;
+
+            int cx0 = std::max(0, static_cast<int>(std::floor((p.x - spread) / cellSize)));
+            int cx1 = std::min(gridWidth - 1, static_cast<int>(std::floor((p.x + spread) / cellSize)));
+            stamp++;
+            for (int cy = cy0; cy <= cy1; cy++) {
+                for (int cx = cx0; cx <= cx1; cx++) {
+                    size_t cell = static_cast<size_t>(cy) * gridWidth + cx;
+                    for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                        uint32_t index = cellSegments[k];
+                        if (visited[index] == stamp) continue;
+                        visited[index] = stamp;
+
+                        const FieldSegment& s = segments[index];
+                        if (boxDistanceSq(s, p) > limitSq) continue;
+
+                        float distanceSq;
+                        float t = closestParameter(s, p, distanceSq);
+                        if (!multi) {
+                            if (distanceSq < bestSq[0]) {
+                                bestSq[0] = distanceSq;
+                                limitSq = distanceSq;
+                            }
+                            continue;
+                        }
+
+                        // Equal distances (a shared endpoint) go to the edge
+                        // that points more directly away from p
+                        BezierPoint q = pointAt(s, t);
+                        float alignment = std::fabs(dot(normalized(directionAt(s, t)),
+                                                        normalized(BezierPoint(p.x - q.x, p.y - q.y))));
+                        for (int c = 0; c < 3; c++) {
+                            if (!(s.channels & (1 << c))) continue;
+                            bool closer = distanceSq < bestSq[c] * 0.9999f;
+                            bool tie = distanceSq <= bestSq[c] * 1.0001f;
+                            if (closer || (tie && (bestSegment[c] < 0 || alignment < bestDot[c]))) {
+                                bestSq[c] = distanceSq;
+                                bestDot[c] = alignment;
+                                bestT[c] = t;
+                                bestSegment[c] = static_cast<int>(index);
+                            }
+                        }
+                        limitSq = std::max(std::max(bestSq[0], bestSq[1]), bestSq[2]);
+                    }
+                }
+            }
+
+            if (!multi) {
+                float distance = std::sqrt(bestSq[0]);
+                dest[col] = encodeDistance(inside ? distance : -distance, spread);
+                continue;
+            }
+
+            float trueDistance = std::sqrt(std::min(std::min(bestSq[0], bestSq[1]), bestSq[2]));
+            float plain = inside ? trueDistance : -trueDistance;
+            float channel[3];
+            for (int c = 0; c < 3; c++) {
+                if (bestSegment[c] < 0) {
+                    channel[c] = inside ? spread : -spread;
+                } else {
+                    channel[c] = signedPseudoDistance(segments[bestSegment[c]], p, bestT[c], std::sqrt(bestSq[c]));
+                }
+            }
+            // Overlapping or oddly wound contours can flip the median; trust the winding
+            if ((median(channel[0], channel[1], channel[2]) > 0.0f) != inside) {
+                channel[0] = channel[1] = channel[2] = plain;
+            }
+            for (int c = 0; c < 3; c++) dest[col * 3 + c] = encodeDistance(channel[c], spread);
+        }
+    }
+}
+
+bool DistanceFieldGenerator::generate(const GlyphOutline& glyph, const RasterPlacement& placement,
+                                      const DistanceFieldOptions& options, GlyphBitmap& out,
+                                      WorkStealingPool* pool) {
+    int width = placement.width;
+    int height = placement.height;
+    int channels = options.multiChannel ? 3 : 1;
+    if (width <= 0 || height <= 0 || !(options.spread > 0.0f)) return false;
+    if (!out.pixels || out.width < width || out.height < height || out.stride < width * channels) return false;
+
+    buildSegments(glyph, placement);
+    buildGrid(width, height, options.spread);
+
+    int rowsPerTask = std::max(1, options.rowsPerTask);
+    if (!pool || pool->size() < 2 || height <= rowsPerTask) {
+        renderRows(0, height, width, height, options, out);
+    } else {
+        for (int row = 0; row < height; row += rowsPerTask) {
+            int rowEnd = std::min(height, row + rowsPerTask);
+            pool->submit([this, row, rowEnd, width, height, &options, &out](unsigned) {
+                renderRows(row, rowEnd, width, height, options, out);
+            });
+        }
+        pool->wait();
+    }
+
+    if (options.multiChannel) correctChannelClashes(out, width, height, options.spread);
+    return true;
+}
+
+bool writeBitmapPPM(const GlyphBitmap& bitmap, const std::string& filename) {
+    std::ofstream ppm(filename, std::ios::binary);
+    if (!ppm.is_open()) return false;
+
+    ppm << "P6\n" << bitmap.width << " " << bitmap.height << "\n255\n";
+    for (int y = 0; y < bitmap.height; y++) {
+        ppm.write(reinterpret_cast<const char*>(bitmap.pixels + static_cast<size_t>(y) * bitmap.stride),
+                  static_cast<std::streamsize>(bitmap.width) * 3);
+    }
+    return ppm.good();
+}
@@ -0,0 +1,72 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include "rasterizer.h"
+
+class WorkStealingPool;
+
+struct DistanceFieldOptions {
+    float spread = 4.0f;        // Pixels of distance on each side of the edge; maps to 0..255
+    bool multiChannel = false;  // MSDF: 3 bytes (RGB) per pixel, median = distance
+    int rowsPerTask = 8;        // Work unit when a pool is given
+};
+
+// Bitmap placement for a glyph's field: the raster placement grown by
+// ceil(spread) pixels on every side so the falloff isn't cut off
+RasterPlacement computeDistanceFieldPlacement(const GlyphHeader& header, float pixelSize, uint16_t unitsPerEm,
+                                              float spread, float subpixelX = 0.0f, float subpixelY = 0.0f);
+
+// Signed distance fields from glyph outlines. Values are 127.5 on the edge,
+// above inside, below outside, clamped at +-spread.
+//
+// Distances are exact: line segments and quadratics are evaluated directly
+// (closest point on a quadratic = roots of a cubic), never flattened. The
+// segments are bucketed into a uniform grid with spread-sized cells, so each
+// pixel only looks at the handful of segments in its 3x3 neighbourhood.
+// Inside/outside comes from the non-zero winding along each pixel row, so
+// overlapping contours (variable fonts) are handled correctly.
+//
+// Multi-channel fields colour the edges of each contour at its corners and
+// store per-channel pseudo-distances; the median of the three channels keeps
+// corners sharp when the field is magnified. Pixels where the median would
+// disagree with the true inside/outside, or that would create a false edge
+// when interpolated with a neighbour, fall back to the plain distance.
+//
+// A generator keeps its segment list and grid between calls - use one per
+// thread. Not thread-safe itself, but it can spread one glyph's rows over a
+// pool. Don't pass a pool from inside one of that pool's tasks.
+class DistanceFieldGenerator {
+public:
+    // out must be at least placement.width x placement.height, with a stride
+    // of width (or 3 * width for multi-channel) bytes or more
+    bool generate(const GlyphOutline& glyph, const RasterPlacement& placement,
+                  const DistanceFieldOptions& options, GlyphBitmap& out, WorkStealingPool* pool = nullptr);
+
+    size_t getSegmentCount() const { return segments.size(); }
+
+    // Pixel space, y up, origin at the bitmap's bottom-left corner
+    struct Segment {
+        BezierPoint p0, p1, p2;     // p1 is the control point (the midpoint for lines)
+        bool quadratic = false;
+        uint8_t channels = 7;       // Bits 0-2 = R, G, B
+        float minX = 0, minY = 0, maxX = 0, maxY = 0;
+    };
+
+private:
+    std::vector<Segment> segments;
+    std::vector<uint32_t> cellStart;    // Grid cell -> first entry in cellSegments
+    std::vector<uint32_t> cellSegments;
+    float cellSize = 1.0f;
+    int gridWidth = 0, gridHeight = 0;
+
+    void buildSegments(const GlyphOutline& glyph, const RasterPlacement& placement);
+    void colorEdges(size_t contourStart, size_t contourEnd);
+    void buildGrid(int width, int height, float spread);
+    void renderRows(int rowBegin, int rowEnd, int width, int height, const DistanceFieldOptions& options,
+                    GlyphBitmap& out) const;
+};
+
+// Writes a multi-channel field as a binary PPM image
+bool writeBitmapPPM(const GlyphBitmap& bitmap, const std::string& filename);
+
+#endif
@@ -0,0 +1,172 @@
+#include "font_face.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <utility>
+
+uint32_t tagFromString(const std::string& name) {
+    char tag[4] = {' ', ' ', ' ', ' '};
+    for (size_t i = 0; i < 4 && i < name.size(); i++) {
+        tag[i] = name[i];
+    }
+    return makeTag(tag[0], tag[1], tag[2], tag[3]);
+}
+
+const char* readerStatusName(ReaderStatus status) {
+    switch (status) {
+        case ReaderStatus::Ok: return "ok";
+        case ReaderStatus::OpenFailed: return "cannot open file";
+        case ReaderStatus::InvalidFont: return "invalid font";
+        case ReaderStatus::MissingTable: return "missing table";
+        case ReaderStatus::CorruptTable: return "corrupt table";
+        case ReaderStatus::GlyphOutOfRange: return "glyph out of range";
+        case ReaderStatus::EmptyGlyph: return "empty glyph";
+        case ReaderStatus::MalformedGlyph: return "malformed glyph";
+    }
+    return "unknown";
+}
+
+FontFace::~FontFace() {
+    close();
+}
+
+bool FontFace::open(const std::string& filename) {
+    TTF_TIME_STAGE(Open);
+    close();
+    if (!font.open(filename)) {
+        openStatus = ReaderStatus::OpenFailed;
+        return false;
+    }
+    fontData = font.bytes();
+
+    if (!buildTableIndex()) {
+        close();
+        openStatus = ReaderStatus::InvalidFont;
+        return false;
+    }
+
+    // unitsPerEm lives at offset 18 in 'head'; needed to scale outlines to pixels
+    uint16_t upem = 0;
+    if (tableData(headTable).readU16(18, upem)) {
+        unitsPerEm = upem;
+    }
+
+    uint16_t glyphCount = 0;
+    if (tableData(maxpTable).readU16(4, glyphCount)) {
+        numGlyphs = glyphCount;
+    }
+
+    locaStatus = resolveLoca();
+    openStatus = ReaderStatus::Ok;
+    return true;
+}
+
+void FontFace::close() {
+    font.close();
+    fontData = ByteSpan();
+    openStatus = ReaderStatus::OpenFailed;
+    unitsPerEm = 0;
+    numGlyphs = 0;
+    tableTags.clear();
+    tableEntries.clear();
+    glyfTable = locaTable = headTable = hheaTable = hmtxTable = cmapTable = maxpTable = nullptr;
+    loca = LocaTable();
+    locaStatus = ReaderStatus::MissingTable;
+    glyphOffsets.clear();
+}
+
+bool FontFace::buildTableIndex() {
+    // Offset table: scalerType, numTables, then three search hints
+    if (!fontData.contains(0, 12)) return false;
+    uint16_t numTables = fontData.u16(4);
+    TTF_COUNT(BytesRead, 12);
+
+    std::vector<std::pair<uint32_t, TableEntry>> records;
+    records.reserve(numTables);
+
+    for (int i = 0; i < numTables; i++) {
+        size_t record = 12 + static_cast<size_t>(i) * 16;
+        if (!fontData.contains(record, 16)) return false;
+
+        TableEntry entry;
+        for (int c = 0; c < 4; c++) {
+            entry.tag[c] = static_cast<char>(fontData.u8(record + c));
+        }
+        entry.tag[4] = '\0';
+        entry.checksum = fontData.u32(record + 4);
+        entry.offset = fontData.u32(record + 8);
+        entry.length = fontData.u32(record + 12);
+        records.emplace_back(fontData.u32(record), entry);
+    }
+    TTF_COUNT(BytesRead, static_cast<size_t>(numTables) * 16);
+
+    // Sorted by tag so lookups are a binary search over a small flat array
+    std::stable_sort(records.begin(), records.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    tableTags.reserve(records.size());
+    tableEntries.reserve(records.size());
+    for (const auto& record : records) {
+        // Keep the first entry if a (broken) font lists a tag twice
+        if (!tableTags.empty() && tableTags.back() == record.first) continue;
+        tableTags.push_back(record.first);
+        tableEntries.push_back(record.second);
+    }
+
+    glyfTable = lookupTable(TAG_GLYF);
+    locaTable = lookupTable(TAG_LOCA);
+    headTable = lookupTable(TAG_HEAD);
+    hheaTable = lookupTable(TAG_HHEA);
+    hmtxTable = lookupTable(TAG_HMTX);
+    cmapTable = lookupTable(TAG_CMAP);
+    maxpTable = lookupTable(TAG_MAXP);
+    return true;
+}
+
+const TableEntry* FontFace::lookupTable(uint32_t tag) const {
+    TTF_COUNT(TableLookups, 1);
+    auto it = std::lower_bound(tableTags.begin(), tableTags.end(), tag);
+    if (it == tableTags.end() || *it != tag) return nullptr;
+    return &tableEntries[it - tableTags.begin()];
+}
+
+ByteSpan FontFace::tableData(const TableEntry* entry) const {
+    if (!entry) return ByteSpan();
+    return fontData.subspan(entry->offset, entry->length);
+}
+
+ReaderStatus FontFace::resolveLoca() {
+    TTF_TIME_STAGE(LocaLoad);
+
+    // Step 1: Get format from head table
+    if (!headTable) return ReaderStatus::MissingTable;
+
+    int16_t indexToLocFormat;
+    if (!tableData(headTable).readI16(50, indexToLocFormat)) return ReaderStatus::CorruptTable;
+    bool longFormat = (indexToLocFormat == 1);
+
+    // Step 2: Point at the raw entries; they're decoded one at a time on lookup
+    if (!locaTable) return ReaderStatus::MissingTable;
+
+    size_t entrySize = longFormat ? 4 : 2;
+    size_t numEntries = locaTable->length / entrySize;
+
+    ByteSpan entries = fontData.subspan(locaTable->offset, numEntries * entrySize);
+    if (numEntries < 2 || entries.empty()) return ReaderStatus::CorruptTable;
+
+    loca.data = entries.data;
+    loca.entries = numEntries;
+    loca.longFormat = longFormat;
+    return ReaderStatus::Ok;
+}
+
+bool FontFace::widenLoca() {
+    if (loca.empty()) return false;
+    if (loca.widened) return true;
+
+    TTF_TIME_STAGE(LocaLoad);
+    glyphOffsets.resize(loca.entries);
+    widenLocaOffsets(loca.data, loca.entries, loca.longFormat, glyphOffsets.data());
+    TTF_COUNT(BytesRead, loca.entries * (loca.longFormat ? 4 : 2));
+    loca.widened = glyphOffsets.data();
+    return true;
+}
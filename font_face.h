@@ -0,0 +1,125 @@
+#ifndef FONT_FACE_H
+#define FONT_FACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "font_source.h"
+#include "loca_table.h"
+
+// Table Directory Entry
+struct TableEntry {
+    char tag[5];
+    uint32_t checksum;
+    uint32_t offset;
+    uint32_t length;
+};
+
+// Table tags packed big-endian into a uint32_t, e.g. makeTag('g','l','y','f')
+constexpr uint32_t makeTag(char a, char b, char c, char d) {
+    return (static_cast<uint32_t>(static_cast<uint8_t>(a)) << 24) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 16) |
+           (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 8) |
+           static_cast<uint32_t>(static_cast<uint8_t>(d));
+}
+
+// Packs a tag string; short names are padded with spaces ("cvt" -> "cvt ")
+uint32_t tagFromString(const std::string& name);
+
+const uint32_t TAG_GLYF = makeTag('g', 'l', 'y', 'f');
+const uint32_t TAG_LOCA = makeTag('l', 'o', 'c', 'a');
+const uint32_t TAG_HEAD = makeTag('h', 'e', 'a', 'd');
+const uint32_t TAG_HHEA = makeTag('h', 'h', 'e', 'a');
+const uint32_t TAG_HMTX = makeTag('h', 'm', 't', 'x');
+const uint32_t TAG_CMAP = makeTag('c', 'm', 'a', 'p');
+const uint32_t TAG_MAXP = makeTag('m', 'a', 'x', 'p');
+
+// Why the last reader call failed. Calls still return bool; the status is
+// there for callers that need to tell "empty" from "corrupt".
+enum class ReaderStatus {
+    Ok,
+    OpenFailed,         // File couldn't be opened or mapped
+    InvalidFont,        // No usable table directory
+    MissingTable,       // A table the call needs isn't in the font
+    CorruptTable,       // A table is truncated or its offsets don't add up
+    GlyphOutOfRange,
+    EmptyGlyph,         // readGlyphByIndex only; loadOutline returns empty outlines
+    MalformedGlyph      // Glyph data failed to decode (bad counts, cycles, nesting too deep)
+};
+
+const char* readerStatusName(ReaderStatus status);
+
+// The read-only part of an open font: the mapped bytes, the table directory,
+// the header fields everything needs and the 'loca' view. All of it is
+// resolved in open() and never changes afterwards, so one face can be shared
+// (as std::shared_ptr<const FontFace>) by any number of TTFReaders on any
+// number of threads. Each reader keeps the mutable state - cursor, scratch
+// buffers, component cache - for the thread that uses it.
+class FontFace {
+private:
+    MappedFile font;
+    ByteSpan fontData;
+    ReaderStatus openStatus = ReaderStatus::OpenFailed;
+    uint16_t unitsPerEm = 0;    // From 'head', 0 if the table is missing
+    uint16_t numGlyphs = 0;     // From 'maxp'
+
+    // Table directory, sorted by tag
+    std::vector<uint32_t> tableTags;
+    std::vector<TableEntry> tableEntries;
+
+    // Cached handles for the tables we use all the time (nullptr if missing)
+    const TableEntry* glyfTable = nullptr;
+    const TableEntry* locaTable = nullptr;
+    const TableEntry* headTable = nullptr;
+    const TableEntry* hheaTable = nullptr;
+    const TableEntry* hmtxTable = nullptr;
+    const TableEntry* cmapTable = nullptr;
+    const TableEntry* maxpTable = nullptr;
+
+    LocaTable loca;                     // Points into the mapping, or at glyphOffsets once widened
+    ReaderStatus locaStatus = ReaderStatus::MissingTable;
+    std::vector<uint32_t> glyphOffsets;
+
+    bool buildTableIndex();
+    ReaderStatus resolveLoca();
+
+public:
+    FontFace() = default;
+    ~FontFace();
+
+    FontFace(const FontFace&) = delete;
+    FontFace& operator=(const FontFace&) = delete;
+
+    // Maps the file and indexes it. A missing or broken 'loca' doesn't fail
+    // the open (the other tables may still be useful); it shows up in
+    // getLocaStatus() and in every glyph read instead.
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return openStatus == ReaderStatus::Ok; }
+    ReaderStatus getOpenStatus() const { return openStatus; }
+
+    ByteSpan bytes() const { return fontData; }
+    uint16_t getUnitsPerEm() const { return unitsPerEm; }
+    uint16_t getNumGlyphs() const { return numGlyphs; }
+
+    const TableEntry* lookupTable(uint32_t tag) const;   // O(log n) in-memory, no I/O
+    const std::vector<TableEntry>& getTableEntries() const { return tableEntries; }    // Sorted by tag
+    ByteSpan tableData(const TableEntry* entry) const;   // Empty if missing or out of bounds
+
+    const TableEntry* glyf() const { return glyfTable; }
+    const TableEntry* head() const { return headTable; }
+    const TableEntry* hhea() const { return hheaTable; }
+    const TableEntry* hmtx() const { return hmtxTable; }
+    const TableEntry* cmap() const { return cmapTable; }
+
+    // Empty (with the reason in getLocaStatus()) if 'head' or 'loca' is unusable
+    const LocaTable& getLoca() const { return loca; }
+    ReaderStatus getLocaStatus() const { return locaStatus; }
+
+    // Widens 'loca' to native offsets once, for faces whose readers will
+    // visit every glyph. Not thread-safe: call it before sharing the face.
+    bool widenLoca();
+    const std::vector<uint32_t>& getGlyphOffsets() const { return glyphOffsets; }   // Empty until widened
+};
+
+#endif
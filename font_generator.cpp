@@ -0,0 +1,555 @@
+#include "font_generator.h"
+#include "ttf_reader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+// splitmix64: tiny, and identical output on every platform (unlike the
+// std:: distributions)
+class SeededRandom {
+private:
+    uint64_t state;
+
+public:
+    explicit SeededRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // Uniform in [0, 1)
+    double unit() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
+    // Uniform in [0, count)
+    uint32_t below(uint32_t count) { return count ? static_cast<uint32_t>(next() % count) : 0; }
+};
+
+// Appends big-endian values
+class ByteWriter {
+private:
+    std::vector<uint8_t>& out;
+
+public:
+    explicit ByteWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    size_t size() const { return out.size(); }
+    void u8(uint8_t v) { out.push_back(v); }
+    void u16(uint16_t v) {
+        out.push_back(static_cast<uint8_t>(v >> 8));
+        out.push_back(static_cast<uint8_t>(v));
+    }
+    void i16(int16_t v) { u16(static_cast<uint16_t>(v)); }
+    void u32(uint32_t v) {
+        u16(static_cast<uint16_t>(v >> 16));
+        u16(static_cast<uint16_t>(v));
+    }
+    void zeros(size_t count) { out.insert(out.end(), count, 0); }
+    void padTo4() { while (out.size() % 4) out.push_back(0); }
+    void append(const std::vector<uint8_t>& bytes) { out.insert(out.end(), bytes.begin(), bytes.end()); }
+
+    void patchU32(size_t offset, uint32_t v) {
+        out[offset] = static_cast<uint8_t>(v >> 24);
+        out[offset + 1] = static_cast<uint8_t>(v >> 16);
+        out[offset + 2] = static_cast<uint8_t>(v >> 8);
+        out[offset + 3] = static_cast<uint8_t>(v);
+    }
+};
+
+uint32_t tableChecksum(const std::vector<uint8_t>& data, size_t offset, size_t length) {
+    uint32_t sum = 0;
+    for (size_t i = 0; i < length; i += 4) {
+        uint32_t word = 0;
+        for (size_t b = 0; b < 4; b++) {
+            word = (word << 8) | (i + b < length ? data[offset + i + b] : 0);
+        }
+        sum += word;
+    }
+    return sum;
+}
+
+struct Bounds {
+    int xMin = 0, yMin = 0, xMax = 0, yMax = 0;
+};
+
+// What later glyphs need to know about an earlier one
+struct GlyphSummary {
+    Bounds bounds;
+    size_t points = 0;
+    size_t contours = 0;
+    int level = 0;          // 0 = simple, N = composite nesting depth
+};
+
+const uint8_t FLAG_ON_CURVE = 0x01;
+const uint8_t FLAG_X_SHORT = 0x02;
+const uint8_t FLAG_Y_SHORT = 0x04;
+const uint8_t FLAG_REPEAT = 0x08;
+const uint8_t FLAG_X_SAME_OR_POSITIVE = 0x10;
+const uint8_t FLAG_Y_SAME_OR_POSITIVE = 0x20;
+
+// Encodes one delta, returns its flag bits
+uint8_t encodeDelta(int delta, uint8_t shortBit, uint8_t sameBit, std::vector<uint8_t>& stream) {
+    if (delta == 0) return sameBit;
+    if (delta > -256 && delta < 256) {
+        stream.push_back(static_cast<uint8_t>(std::abs(delta)));
+        return shortBit | (delta > 0 ? sameBit : 0);
+    }
+    stream.push_back(static_cast<uint8_t>(static_cast<uint16_t>(delta) >> 8));
+    stream.push_back(static_cast<uint8_t>(delta));
+    return 0;
+}
+
+void encodeSimpleGlyph(const std::vector<std::vector<Point>>& contours, Bounds& bounds,
+                       std::vector<uint8_t>& glyph) {
+    glyph.clear();
+    ByteWriter w(glyph);
+
+    bool first = true;
+    for (const std::vector<Point>& contour : contours) {
+        for (const Point& p : contour) {
+            if (first) {
+                bounds = Bounds{p.x, p.y, p.x, p.y};
+                first = false;
+            }
+            bounds.xMin = std::min<int>(bounds.xMin, p.x);
+            bounds.yMin = std::min<int>(bounds.yMin, p.y);
+            bounds.xMax = std::max<int>(bounds.xMax, p.x);
+            bounds.yMax = std::max<int>(bounds.yMax, p.y);
+        }
+    }
+
+    w.i16(static_cast<int16_t>(contours.size()));
+    w.i16(static_cast<int16_t>(bounds.xMin));
+    w.i16(static_cast<int16_t>(bounds.yMin));
+    w.i16(static_cast<int16_t>(bounds.xMax));
+    w.i16(static_cast<int16_t>(bounds.yMax));
+
+    size_t endPt = 0;
+    for (const std::vector<Point>& contour : contours) {
+        endPt += contour.size();
+        w.u16(static_cast<uint16_t>(endPt - 1));
+    }
+    w.u16(0); // No instructions
+
+    std::vector<uint8_t> flags, xs, ys;
+    int lastX = 0, lastY = 0;
+    for (const std::vector<Point>& contour : contours) {
+        for (const Point& p : contour) {
+            uint8_t flag = p.onCurve ? FLAG_ON_CURVE : 0;
+            flag |= encodeDelta(p.x - lastX, FLAG_X_SHORT, FLAG_X_SAME_OR_POSITIVE, xs);
+            flag |= encodeDelta(p.y - lastY, FLAG_Y_SHORT, FLAG_Y_SAME_OR_POSITIVE, ys);
+            flags.push_back(flag);
+            lastX = p.x;
+            lastY = p.y;
+        }
+    }
+
+    // Runs of equal flags use the repeat count
+    for (size_t i = 0; i < flags.size(); ) {
+        size_t run = 1;
+        while (i + run < flags.size() && flags[i + run] == flags[i] && run < 256) run++;
+        if (run > 1) {
+            w.u8(flags[i] | FLAG_REPEAT);
+            w.u8(static_cast<uint8_t>(run - 1));
+        } else {
+            w.u8(flags[i]);
+        }
+        i += run;
+    }
+    w.append(xs);
+    w.append(ys);
+}
+
+// Concentric rings around the glyph centre, alternating direction so inner
+// rings cut holes under the non-zero rule
+void makeRingContours(const SyntheticFontOptions& options, int advance, SeededRandom& random,
+                      std::vector<std::vector<Point>>& contours) {
+    contours.assign(options.contoursPerGlyph, std::vector<Point>());
+    double cx = advance / 2.0;
+    double cy = options.unitsPerEm * 0.35;
+    double outer = std::min(advance, static_cast<int>(options.unitsPerEm)) * 0.42;
+    const double pi = 3.14159265358979323846;
+
+    for (int c = 0; c < options.contoursPerGlyph; c++) {
+        double radius = outer * (options.contoursPerGlyph - c) / (options.contoursPerGlyph + 0.5);
+        double direction = (c % 2 == 0) ? -1.0 : 1.0; // Outer ring clockwise, as TrueType expects
+        double phase = random.unit() * 2.0 * pi;
+
+        std::vector<Point>& contour = contours[c];
+        contour.resize(options.pointsPerContour);
+        for (int i = 0; i < options.pointsPerContour; i++) {
+            double angle = phase + direction * 2.0 * pi * i / options.pointsPerContour;
+            double r = radius * (0.9 + 0.2 * random.unit());
+            contour[i].x = static_cast<int16_t>(std::lround(cx + r * std::cos(angle)));
+            contour[i].y = static_cast<int16_t>(std::lround(cy + r * std::sin(angle)));
+            contour[i].onCurve = random.unit() >= options.offCurveRatio;
+        }
+    }
+}
+
+// Composite: a lower-level glyph at an offset, plus a half-size simple glyph
+void encodeCompositeGlyph(uint16_t mainComponent, const GlyphSummary& mainInfo,
+                          uint16_t scaledComponent, const GlyphSummary& scaledInfo,
+                          int16_t dx, int16_t dy, Bounds& bounds, std::vector<uint8_t>& glyph) {
+    glyph.clear();
+    ByteWriter w(glyph);
+
+    const Bounds& a = mainInfo.bounds;
+    const Bounds& b = scaledInfo.bounds;
+    bounds.xMin = std::min(a.xMin, static_cast<int>(std::floor(b.xMin * 0.5)) + dx);
+    bounds.yMin = std::min(a.yMin, static_cast<int>(std::floor(b.yMin * 0.5)) + dy);
+    bounds.xMax = std::max(a.xMax, static_cast<int>(std::ceil(b.xMax * 0.5)) + dx);
+    bounds.yMax = std::max(a.yMax, static_cast<int>(std::ceil(b.yMax * 0.5)) + dy);
+
+    w.i16(-1);
+    w.i16(static_cast<int16_t>(bounds.xMin));
+    w.i16(static_cast<int16_t>(bounds.yMin));
+    w.i16(static_cast<int16_t>(bounds.xMax));
+    w.i16(static_cast<int16_t>(bounds.yMax));
+
+    w.u16(ARG_1_AND_2_ARE_WORDS | ARGS_ARE_XY_VALUES | MORE_COMPONENTS);
+    w.u16(mainComponent);
+    w.i16(0);
+    w.i16(0);
+
+    w.u16(ARG_1_AND_2_ARE_WORDS | ARGS_ARE_XY_VALUES | WE_HAVE_A_SCALE);
+    w.u16(scaledComponent);
+    w.i16(dx);
+    w.i16(dy);
+    w.u16(0x2000); // 0.5 in F2DOT14
+}
+
+void writeHead(const SyntheticFontOptions& options, const Bounds& bounds, bool longLoca, std::vector<uint8_t>& table) {
+    ByteWriter w(table);
+    w.u32(0x00010000);      // version
+    w.u32(0x00010000);      // fontRevision
+    w.u32(0);               // checkSumAdjustment, patched last
+    w.u32(0x5F0F3CF5);      // magicNumber
+    w.u16(0x0003);          // flags: baseline at y=0, lsb at x=0
+    w.u16(options.unitsPerEm);
+    w.zeros(16);            // created, modified - fixed for reproducible output
+    w.i16(static_cast<int16_t>(bounds.xMin));
+    w.i16(static_cast<int16_t>(bounds.yMin));
+    w.i16(static_cast<int16_t>(bounds.xMax));
+    w.i16(static_cast<int16_t>(bounds.yMax));
+    w.u16(0);               // macStyle
+    w.u16(8);               // lowestRecPPEM
+    w.i16(2);               // fontDirectionHint
+    w.i16(longLoca ? 1 : 0);
+    w.i16(0);               // glyphDataFormat
+}
+
+void writeHhea(const SyntheticFontOptions& options, int advance, const Bounds& bounds, int glyphCount,
+               std::vector<uint8_t>& table) {
+    ByteWriter w(table);
+    w.u32(0x00010000);
+    w.i16(static_cast<int16_t>(options.unitsPerEm * 4 / 5));     // ascender
+    w.i16(static_cast<int16_t>(-(options.unitsPerEm / 5)));      // descender
+    w.i16(0);                                                    // lineGap
+    w.u16(static_cast<uint16_t>(advance));                       // advanceWidthMax
+    w.i16(static_cast<int16_t>(bounds.xMin));                    // minLeftSideBearing
+    w.i16(static_cast<int16_t>(advance - bounds.xMax));          // minRightSideBearing
+    w.i16(static_cast<int16_t>(bounds.xMax));                    // xMaxExtent
+    w.i16(1);                                                    // caretSlopeRise
+    w.i16(0);                                                    // caretSlopeRun
+    w.i16(0);                                                    // caretOffset
+    w.zeros(8);                                                  // reserved
+    w.i16(0);                                                    // metricDataFormat
+    w.u16(static_cast<uint16_t>(glyphCount));                    // numberOfHMetrics
+}
+
+void writeMaxp(int glyphCount, const std::vector<GlyphSummary>& glyphs, int compositeDepth,
+               std::vector<uint8_t>& table) {
+    size_t maxPoints = 0, maxContours = 0, maxCompositePoints = 0, maxCompositeContours = 0;
+    for (const GlyphSummary& g : glyphs) {
+        if (g.level == 0) {
+            maxPoints = std::max(maxPoints, g.points);
+            maxContours = std::max(maxContours, g.contours);
+        } else {
+            maxCompositePoints = std::max(maxCompositePoints, g.points);
+            maxCompositeContours = std::max(maxCompositeContours, g.contours);
+        }
+    }
+
+    ByteWriter w(table);
+    w.u32(0x00010000);
+    w.u16(static_cast<uint16_t>(glyphCount));
+    w.u16(static_cast<uint16_t>(std::min<size_t>(maxPoints, 0xFFFF)));
+    w.u16(static_cast<uint16_t>(std::min<size_t>(maxContours, 0xFFFF)));
+    w.u16(static_cast<uint16_t>(std::min<size_t>(maxCompositePoints, 0xFFFF)));
+    w.u16(static_cast<uint16_t>(std::min<size_t>(maxCompositeContours, 0xFFFF)));
+    w.u16(2);               // maxZones
+    w.zeros(12);            // twilight points, storage, function/instruction defs, stack, instruction size
+    w.u16(compositeDepth > 0 ? 2 : 0);                  // maxComponentElements
+    w.u16(static_cast<uint16_t>(compositeDepth));       // maxComponentDepth
+}
+
+// One contiguous codepoint range -> glyphs 1..count
+int writeCmap(uint32_t firstCodepoint, uint32_t count, std::vector<uint8_t>& table) {
+    ByteWriter w(table);
+    uint32_t lastCodepoint = count ? firstCodepoint + count - 1 : 0;
+    bool bmp = count == 0 || lastCodepoint < 0xFFFF;
+
+    w.u16(0);   // version
+    w.u16(1);   // numTables
+    w.u16(3);   // platform: Windows
+    w.u16(bmp ? 1 : 10);
+    w.u32(12);  // Subtable right after the single record
+
+    if (bmp) {
+        uint16_t segCount = count ? 2 : 1;
+        uint16_t searchRange = 2;
+        uint16_t entrySelector = 0;
+        while (searchRange * 2 <= segCount * 2) {
+            searchRange *= 2;
+            entrySelector++;
+        }
+        w.u16(4);
+        w.u16(static_cast<uint16_t>(16 + segCount * 8));   // length
+        w.u16(0);                                           // language
+        w.u16(static_cast<uint16_t>(segCount * 2));
+        w.u16(searchRange);
+        w.u16(entrySelector);
+        w.u16(static_cast<uint16_t>(segCount * 2 - searchRange));
+        if (count) w.u16(static_cast<uint16_t>(lastCodepoint));    // endCode
+        w.u16(0xFFFF);
+        w.u16(0);                                                   // reservedPad
+        if (count) w.u16(static_cast<uint16_t>(firstCodepoint));   // startCode
+        w.u16(0xFFFF);
+        if (count) w.u16(static_cast<uint16_t>(1 - firstCodepoint)); // idDelta (mod 65536)
+        w.u16(1);
+        if (count) w.u16(0);                                        // idRangeOffset
+        w.u16(0);
+        return 4;
+    }
+
+    w.u16(12);
+    w.u16(0);       // reserved
+    w.u32(28);      // length
+    w.u32(0);       // language
+    w.u32(1);       // numGroups
+    w.u32(firstCodepoint);
+    w.u32(lastCodepoint);
+    w.u32(1);
+    return 12;
+}
+
+} // namespace
+
+bool generateSyntheticFont(const SyntheticFontOptions& options, std::vector<uint8_t>& font,
+                           SyntheticFontInfo* info) {
+    if (options.glyphCount < 1 || options.glyphCount > 0xFFFF) return false;
+    if (options.contoursPerGlyph < 1 || options.pointsPerContour < 3) return false;
+    if (static_cast<long>(options.contoursPerGlyph) * options.pointsPerContour > 0xFFFF) return false;
+    if (options.offCurveRatio < 0.0f || options.offCurveRatio > 1.0f) return false;
+    if (options.compositeDepth < 0 || options.compositeDepth > 64) return false;
+    if (options.unitsPerEm < 16) return false;
+    if (options.firstCodepoint + static_cast<uint32_t>(options.glyphCount) > 0x110000) return false;
+
+    SyntheticFontInfo summary;
+    SeededRandom random(options.seed);
+    int glyphCount = options.glyphCount;
+    int advance = options.unitsPerEm * 3 / 4;
+
+    // Glyph 0 is .notdef, then simple glyphs, then composites ordered by level
+    int compositeCount = 0;
+    if (options.compositeDepth > 0 && glyphCount >= 3) {
+        compositeCount = static_cast<int>(std::lround(options.compositeRatio * (glyphCount - 1)));
+        compositeCount = std::max(compositeCount, options.compositeDepth);
+        compositeCount = std::min(compositeCount, glyphCount - 2); // Keep at least one simple glyph
+    }
+    int depth = std::min(options.compositeDepth, compositeCount);
+    int simpleEnd = glyphCount - compositeCount;    // Simple glyphs are [1, simpleEnd)
+
+    std::vector<GlyphSummary> glyphs(glyphCount);
+    std::vector<uint32_t> glyphOffsets(glyphCount + 1, 0);
+    std::vector<uint8_t> glyf, glyph;
+    std::vector<std::vector<Point>> contours;
+    std::vector<int> firstOfLevel(depth + 1, -1);
+    firstOfLevel[0] = 1;
+    Bounds fontBounds;
+    bool haveBounds = false;
+
+    for (int g = 0; g < glyphCount; g++) {
+        GlyphSummary& summaryOf = glyphs[g];
+
+        if (g == 0) {
+            // .notdef: a box with a hole
+            int w = advance - 100, h = options.unitsPerEm * 7 / 10;
+            contours.assign(2, std::vector<Point>());
+            contours[0] = {{50, 0, true}, {50, static_cast<int16_t>(h), true},
+                           {static_cast<int16_t>(50 + w), static_cast<int16_t>(h), true},
+                           {static_cast<int16_t>(50 + w), 0, true}};
+            contours[1] = {{100, 50, true}, {static_cast<int16_t>(w), 50, true},
+                           {static_cast<int16_t>(w), static_cast<int16_t>(h - 50), true},
+                           {100, static_cast<int16_t>(h - 50), true}};
+            encodeSimpleGlyph(contours, summaryOf.bounds, glyph);
+            summaryOf.points = 8;
+            summaryOf.contours = 2;
+        } else if (g < simpleEnd) {
+            makeRingContours(options, advance, random, contours);
+            encodeSimpleGlyph(contours, summaryOf.bounds, glyph);
+            summaryOf.points = static_cast<size_t>(options.contoursPerGlyph) * options.pointsPerContour;
+            summaryOf.contours = options.contoursPerGlyph;
+            summary.simpleGlyphs++;
+            summary.totalPoints += summaryOf.points;
+        } else {
+            int index = g - simpleEnd;
+            int level = 1 + static_cast<int>(static_cast<long>(index) * depth / compositeCount);
+            if (firstOfLevel[level] < 0) firstOfLevel[level] = g;
+            summaryOf.level = level;
+
+            // Chains always go through the first glyph of each level, so the
+            // cyclic variant is guaranteed to loop
+            int mainComponent = firstOfLevel[level - 1];
+            if (options.cyclicComposites && g == simpleEnd) mainComponent = glyphCount - 1;
+            int scaledComponent = 1 + static_cast<int>(random.below(simpleEnd - 1));
+            int16_t dx = static_cast<int16_t>(advance / 4);
+            int16_t dy = static_cast<int16_t>(options.unitsPerEm / 4);
+
+            // A forward (cyclic) reference has no summary yet; borrow the scaled one's
+            const GlyphSummary& mainInfo = mainComponent < g ? glyphs[mainComponent] : glyphs[scaledComponent];
+            encodeCompositeGlyph(static_cast<uint16_t>(mainComponent), mainInfo,
+                                 static_cast<uint16_t>(scaledComponent), glyphs[scaledComponent],
+                                 dx, dy, summaryOf.bounds, glyph);
+            summaryOf.points = mainInfo.points + glyphs[scaledComponent].points;
+            summaryOf.contours = mainInfo.contours + glyphs[scaledComponent].contours;
+            summary.compositeGlyphs++;
+        }
+
+        const Bounds& b = summaryOf.bounds;
+        if (!haveBounds) {
+            fontBounds = b;
+            haveBounds = true;
+        }
+        fontBounds.xMin = std::min(fontBounds.xMin, b.xMin);
+        fontBounds.yMin = std::min(fontBounds.yMin, b.yMin);
+        fontBounds.xMax = std::max(fontBounds.xMax, b.xMax);
+        fontBounds.yMax = std::max(fontBounds.yMax, b.yMax);
+
+        glyphOffsets[g] = static_cast<uint32_t>(glyf.size());
+        glyf.insert(glyf.end(), glyph.begin(), glyph.end());
+        while (glyf.size() % 4) glyf.push_back(0);
+    }
+    glyphOffsets[glyphCount] = static_cast<uint32_t>(glyf.size());
+
+    // Short offsets store offset / 2 in 16 bits
+    bool longLoca = options.longLoca || glyf.size() > 0x1FFFE;
+    summary.longLoca = longLoca;
+    summary.glyfBytes = glyf.size();
+
+    std::vector<uint8_t> loca;
+    ByteWriter locaWriter(loca);
+    for (uint32_t offset : glyphOffsets) {
+        if (longLoca) locaWriter.u32(offset);
+        else locaWriter.u16(static_cast<uint16_t>(offset / 2));
+    }
+
+    std::vector<uint8_t> head, hhea, maxp, hmtx, cmap;
+    writeHead(options, fontBounds, longLoca, head);
+    writeHhea(options, advance, fontBounds, glyphCount, hhea);
+    writeMaxp(glyphCount, glyphs, depth, maxp);
+    ByteWriter hmtxWriter(hmtx);
+    for (const GlyphSummary& g : glyphs) {
+        hmtxWriter.u16(static_cast<uint16_t>(advance));
+        hmtxWriter.i16(static_cast<int16_t>(g.bounds.xMin));
+    }
+    summary.cmapFormat = writeCmap(options.firstCodepoint, static_cast<uint32_t>(glyphCount - 1), cmap);
+
+    // Table directory, sorted by tag
+    struct TableBlob {
+        uint32_t tag;
+        const std::vector<uint8_t>* data;
+    };
+    const TableBlob tables[] = {
+        {TAG_CMAP, &cmap}, {TAG_GLYF, &glyf}, {TAG_HEAD, &head}, {TAG_HHEA, &hhea},
+        {TAG_HMTX, &hmtx}, {TAG_LOCA, &loca}, {TAG_MAXP, &maxp},
+    };
+    const uint16_t numTables = sizeof(tables) / sizeof(tables[0]);
+
+    font.clear();
+    ByteWriter w(font);
+    uint16_t searchRange = 16, entrySelector = 0;
+    while (searchRange * 2 <= numTables * 16) {
+        searchRange *= 2;
+        entrySelector++;
+    }
+    w.u32(0x00010000);
+    w.u16(numTables);
+    w.u16(searchRange);
+    w.u16(entrySelector);
+    w.u16(static_cast<uint16_t>(numTables * 16 - searchRange));
+
+    size_t directory = font.size();
+    w.zeros(static_cast<size_t>(numTables) * 16);
+
+    size_t headOffset = 0;
+    for (uint16_t i = 0; i < numTables; i++) {
+        size_t offset = font.size();
+        w.append(*tables[i].data);
+        size_t length = tables[i].data->size();
+        w.padTo4();
+        if (tables[i].tag == TAG_HEAD) headOffset = offset;
+
+        size_t record = directory + static_cast<size_t>(i) * 16;
+        w.patchU32(record, tables[i].tag);
+        w.patchU32(record + 4, tableChecksum(font, offset, length));
+        w.patchU32(record + 8, static_cast<uint32_t>(offset));
+        w.patchU32(record + 12, static_cast<uint32_t>(length));
+    }
+
+    // Whole-file checksum goes into head.checkSumAdjustment
+    w.patchU32(headOffset + 8, 0xB1B0AFBAu - tableChecksum(font, 0, font.size()));
+
+    if (info) *info = summary;
+    return true;
+}
+
+bool writeSyntheticFont(const SyntheticFontOptions& options, const std::string& filename,
+                        SyntheticFontInfo* info) {
+    std::vector<uint8_t> font;
+    if (!generateSyntheticFont(options, font, info)) return false;
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(font.data()), static_cast<std::streamsize>(font.size()));
+    return static_cast<bool>(file);
+}
+
+bool parseSyntheticFontSpec(const std::string& spec, SyntheticFontOptions& options) {
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) continue;
+
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        char* parseEnd = nullptr;
+        double number = std::strtod(value.c_str(), &parseEnd);
+        if (value.empty() || *parseEnd != '\0') return false;
+
+        if (key == "seed") options.seed = static_cast<uint32_t>(number);
+        else if (key == "glyphs") options.glyphCount = static_cast<int>(number);
+        else if (key == "contours") options.contoursPerGlyph = static_cast<int>(number);
+        else if (key == "points") options.pointsPerContour = static_cast<int>(number);
+        else if (key == "offcurve") options.offCurveRatio = static_cast<float>(number);
+        else if (key == "depth") options.compositeDepth = static_cast<int>(number);
+        else if (key == "composites") options.compositeRatio = static_cast<float>(number);
+        else if (key == "cyclic") options.cyclicComposites = number != 0;
+        else if (key == "longloca") options.longLoca = number != 0;
+        else if (key == "upem") options.unitsPerEm = static_cast<uint16_t>(number);
+        else if (key == "first") options.firstCodepoint = static_cast<uint32_t>(number);
+        else return false;
+    }
+    return true;
+}
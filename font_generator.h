@@ -0,0 +1,49 @@
+#ifndef FONT_GENERATOR_H
+#define FONT_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Shape of a generated font. The same options and seed always produce the
+// same bytes, so generated files can stand in for real fonts in benchmarks
+// and load tests.
+struct SyntheticFontOptions {
+    uint32_t seed = 1;
+    int glyphCount = 256;           // Including .notdef; at most 65535
+    int contoursPerGlyph = 2;
+    int pointsPerContour = 16;      // At least 3
+    float offCurveRatio = 0.5f;     // Share of points that are quadratic controls
+    int compositeDepth = 0;         // 0 = simple glyphs only; N = composites nested N deep
+    float compositeRatio = 0.1f;    // Share of glyphs that are composites (when depth > 0)
+    bool cyclicComposites = false;  // Make the composite chain loop back on itself (malformed)
+    bool longLoca = false;          // Long 'loca' offsets; forced when 'glyf' outgrows short ones
+    uint16_t unitsPerEm = 1000;
+    uint32_t firstCodepoint = 0x4E00; // Glyph i >= 1 maps to firstCodepoint + i - 1
+};
+
+// What was generated, for sanity checks and benchmark labels
+struct SyntheticFontInfo {
+    int simpleGlyphs = 0;
+    int compositeGlyphs = 0;
+    size_t totalPoints = 0;         // Simple glyph points only
+    size_t glyfBytes = 0;
+    bool longLoca = false;
+    int cmapFormat = 0;
+};
+
+// Builds a TrueType file with the tables this reader uses: head, hhea, maxp,
+// hmtx, cmap (format 4, or 12 past the BMP), loca and glyf. Contours are
+// concentric rings with alternating direction, so glyphs also rasterize to
+// sensible shapes. Returns false if the options are out of range.
+bool generateSyntheticFont(const SyntheticFontOptions& options, std::vector<uint8_t>& font,
+                           SyntheticFontInfo* info = nullptr);
+bool writeSyntheticFont(const SyntheticFontOptions& options, const std::string& filename,
+                        SyntheticFontInfo* info = nullptr);
+
+// Parses "glyphs=5000,contours=3,points=40,offcurve=0.5,depth=2,..." into
+// options (unset keys keep their values). Keys: seed, glyphs, contours,
+// points, offcurve, depth, composites, cyclic, longloca, upem, first.
+bool parseSyntheticFontSpec(const std::string& spec, SyntheticFontOptions& options);
+
+#endif
@@ -0,0 +1,334 @@
+#include "font_pack.h"
+#include "ttf_reader.h"
+#include "batch_raster.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+// The records are read in place, so their layout is part of the format
+static_assert(sizeof(FontPackHeader) == 88, "FontPackHeader layout");
+static_assert(sizeof(FontPackTable) == 16, "FontPackTable layout");
+static_assert(sizeof(FontPackGlyph) == 32, "FontPackGlyph layout");
+static_assert(sizeof(FontPackBitmapSize) == 16, "FontPackBitmapSize layout");
+static_assert(sizeof(FontPackBitmap) == 24, "FontPackBitmap layout");
+
+static const char FONT_PACK_MAGIC[8] = {'T', 'R', 'F', 'P', 'A', 'C', 'K', '\0'};
+static const uint32_t FONT_PACK_BYTE_ORDER = 0x01020304;
+static const size_t FONT_PACK_SECTION_ALIGN = 64;
+
+uint64_t hashFontBytes(ByteSpan bytes) {
+    // Eight bytes per step, multiply-xorshift mixing
+    const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t hash = 0xCBF29CE484222325ull ^ (bytes.size * multiplier);
+    size_t i = 0;
+    for (; i + 8 <= bytes.size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data + i, 8);
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 29;
+    }
+    for (; i < bytes.size; i++) {
+        hash = (hash ^ bytes.data[i]) * multiplier;
+    }
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ull;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Appends count bytes at the next multiple of alignment, returns their offset
+static uint64_t appendAligned(std::vector<uint8_t>& out, const void* data, size_t count, size_t alignment) {
+    size_t offset = (out.size() + alignment - 1) / alignment * alignment;
+    out.resize(offset + count);
+    if (count) std::memcpy(out.data() + offset, data, count);
+    return offset;
+}
+
+bool buildFontPack(const std::string& fontPath, const std::string& packPath, const FontPackOptions& options) {
+    // One face for the outline pass, the bitmap pass and the source hash
+    std::shared_ptr<FontFace> face = std::make_shared<FontFace>();
+    if (!face->open(fontPath)) return false;
+    face->widenLoca();
+
+    TTFReader reader;
+    if (!reader.attachFace(face)) return false;
+
+    uint16_t numGlyphs = reader.getNumGlyphs();
+    const std::vector<uint32_t>& loca = reader.getGlyphOffsets();
+    if (numGlyphs == 0 || loca.empty()) return false;
+
+    FontPackHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, FONT_PACK_MAGIC, sizeof(header.magic));
+    header.version = FONT_PACK_VERSION;
+    header.byteOrder = FONT_PACK_BYTE_ORDER;
+    header.sourceHash = hashFontBytes(face->bytes());
+    header.sourceSize = face->bytes().size;
+    header.unitsPerEm = reader.getUnitsPerEm();
+    header.numGlyphs = numGlyphs;
+    header.indexToLocFormat = reader.hasLongLoca() ? 1 : 0;
+
+    std::vector<uint8_t> pack(sizeof(FontPackHeader), 0);
+
+    // Table directory (already sorted by tag)
+    std::vector<FontPackTable> tables;
+    for (const TableEntry& entry : reader.getTableEntries()) {
+        FontPackTable table;
+        table.tag = makeTag(entry.tag[0], entry.tag[1], entry.tag[2], entry.tag[3]);
+        table.checksum = entry.checksum;
+        table.offset = entry.offset;
+        table.length = entry.length;
+        tables.push_back(table);
+    }
+    header.tableCount = static_cast<uint16_t>(tables.size());
+    header.tablesOffset = appendAligned(pack, tables.data(), tables.size() * sizeof(FontPackTable),
+                                        FONT_PACK_SECTION_ALIGN);
+
+    // 'loca', exactly numGlyphs + 1 entries; a short table pads with empty glyphs
+    std::vector<uint32_t> offsets(loca.begin(), loca.begin() + std::min<size_t>(loca.size(), numGlyphs + 1));
+    offsets.resize(numGlyphs + 1, offsets.back());
+    header.locaOffset = appendAligned(pack, offsets.data(), offsets.size() * sizeof(uint32_t),
+                                      FONT_PACK_SECTION_ALIGN);
+
+    // Glyph records first (patched below), then the outline arrays
+    std::vector<FontPackGlyph> glyphs(numGlyphs);
+    std::memset(glyphs.data(), 0, glyphs.size() * sizeof(FontPackGlyph));
+    header.glyphsOffset = appendAligned(pack, glyphs.data(), glyphs.size() * sizeof(FontPackGlyph),
+                                        FONT_PACK_SECTION_ALIGN);
+
+    OutlineArena arena;
+    for (uint16_t i = 0; i < numGlyphs; i++) {
+        arena.reset();
+        GlyphOutline outline;
+        FontPackGlyph& record = glyphs[i];
+        if (!reader.loadOutline(i, arena, outline)) continue;
+
+        record.header = outline.header;
+        record.contourCount = outline.contourCount;
+        record.pointCount = outline.pointCount;
+        record.flags = FONT_PACK_GLYPH_DECODED;
+
+        // Same layout as StoredOutline: 16-bit arrays first, then the bitset
+        StoredOutline stored(outline);
+        record.dataOffset = appendAligned(pack, stored.endPts, stored.getStorageBytes(), 8);
+    }
+    std::memcpy(pack.data() + header.glyphsOffset, glyphs.data(), glyphs.size() * sizeof(FontPackGlyph));
+
+    // Optional pre-rendered bitmaps, rendered on the batch path. Every glyph x
+    // size slot is written by exactly one worker, so the visitor needs no lock.
+    if (!options.bitmapSizes.empty()) {
+        size_t sizeCount = options.bitmapSizes.size();
+        std::vector<FontPackBitmap> bitmaps(sizeCount * numGlyphs);
+        std::memset(bitmaps.data(), 0, bitmaps.size() * sizeof(FontPackBitmap));
+        std::vector<std::vector<uint8_t>> pixels(bitmaps.size());
+
+        BatchRasterOptions batch;
+        batch.pixelSizes = options.bitmapSizes;
+        batch.threads = options.threads;
+        BatchRasterResult result;
+        bool rendered = rasterizeFontParallel(face, batch, result,
+            [&](unsigned, int glyphIndex, float pixelSize, const RasterPlacement& placement, const GlyphBitmap& bitmap) {
+                size_t sizeIndex = std::find(options.bitmapSizes.begin(), options.bitmapSizes.end(), pixelSize) -
+                                   options.bitmapSizes.begin();
+                size_t slot = sizeIndex * numGlyphs + glyphIndex;
+                FontPackBitmap& record = bitmaps[slot];
+                record.left = static_cast<int16_t>(placement.left);
+                record.top = static_cast<int16_t>(placement.top);
+                record.width = static_cast<uint16_t>(bitmap.width);
+                record.height = static_cast<uint16_t>(bitmap.height);
+
+                std::vector<uint8_t>& copy = pixels[slot];
+                copy.resize(static_cast<size_t>(bitmap.width) * bitmap.height);
+                for (int y = 0; y < bitmap.height; y++) {
+                    std::memcpy(copy.data() + static_cast<size_t>(y) * bitmap.width,
+                                bitmap.pixels + static_cast<size_t>(y) * bitmap.stride, bitmap.width);
+                }
+            });
+        if (!rendered) return false;
+
+        std::vector<FontPackBitmapSize> sizes(sizeCount);
+        std::memset(sizes.data(), 0, sizes.size() * sizeof(FontPackBitmapSize));
+        header.bitmapSizeCount = static_cast<uint16_t>(sizeCount);
+        header.bitmapSizesOffset = appendAligned(pack, sizes.data(), sizes.size() * sizeof(FontPackBitmapSize),
+                                                 FONT_PACK_SECTION_ALIGN);
+        for (size_t s = 0; s < sizeCount; s++) {
+            sizes[s].pixelSize = options.bitmapSizes[s];
+            sizes[s].bitmapsOffset = appendAligned(pack, bitmaps.data() + s * numGlyphs,
+                                                   numGlyphs * sizeof(FontPackBitmap), FONT_PACK_SECTION_ALIGN);
+        }
+        for (size_t slot = 0; slot < bitmaps.size(); slot++) {
+            if (pixels[slot].empty()) continue;
+            uint64_t offset = appendAligned(pack, pixels[slot].data(), pixels[slot].size(), 8);
+            size_t s = slot / numGlyphs;
+            FontPackBitmap* records = reinterpret_cast<FontPackBitmap*>(pack.data() + sizes[s].bitmapsOffset);
+            records[slot % numGlyphs].pixelsOffset = offset;
+        }
+        std::memcpy(pack.data() + header.bitmapSizesOffset, sizes.data(), sizes.size() * sizeof(FontPackBitmapSize));
+    }
+
+    header.fileSize = pack.size();
+    std::memcpy(pack.data(), &header, sizeof(header));
+
+    // Write beside the target and rename over it, so a pack is never seen half-written
+    uint64_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+                      static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::string tempPath = packPath + ".tmp" + std::to_string(unique);
+    {
+        std::ofstream out(tempPath, std::ios::binary);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(pack.data()), static_cast<std::streamsize>(pack.size()));
+        if (!out) {
+            out.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tempPath.c_str(), packPath.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool FontPack::open(const std::string& packPath) {
+    close();
+    if (!file.open(packPath)) return false;
+    bytes = file.bytes();
+
+    if (!bytes.contains(0, sizeof(FontPackHeader))) {
+        close();
+        return false;
+    }
+    const FontPackHeader* h = reinterpret_cast<const FontPackHeader*>(bytes.data);
+    if (std::memcmp(h->magic, FONT_PACK_MAGIC, sizeof(h->magic)) != 0 || h->version != FONT_PACK_VERSION ||
+        h->byteOrder != FONT_PACK_BYTE_ORDER || h->fileSize != bytes.size || h->numGlyphs == 0) {
+        close();
+        return false;
+    }
+
+    // Every fixed-size section must lie inside the file and be aligned
+    auto section = [this](uint64_t offset, size_t count, size_t itemSize) {
+        return offset % 8 == 0 && bytes.contains(offset, count * itemSize);
+    };
+    if (!section(h->tablesOffset, h->tableCount, sizeof(FontPackTable)) ||
+        !section(h->locaOffset, h->numGlyphs + 1u, sizeof(uint32_t)) ||
+        !section(h->glyphsOffset, h->numGlyphs, sizeof(FontPackGlyph)) ||
+        !section(h->bitmapSizesOffset, h->bitmapSizeCount, sizeof(FontPackBitmapSize))) {
+        close();
+        return false;
+    }
+    const FontPackBitmapSize* sizes = reinterpret_cast<const FontPackBitmapSize*>(bytes.data + h->bitmapSizesOffset);
+    for (uint16_t s = 0; s < h->bitmapSizeCount; s++) {
+        if (!section(sizes[s].bitmapsOffset, h->numGlyphs, sizeof(FontPackBitmap))) {
+            close();
+            return false;
+        }
+    }
+
+    header = h;
+    tables = reinterpret_cast<const FontPackTable*>(bytes.data + h->tablesOffset);
+    glyphOffsets = reinterpret_cast<const uint32_t*>(bytes.data + h->locaOffset);
+    glyphs = reinterpret_cast<const FontPackGlyph*>(bytes.data + h->glyphsOffset);
+    bitmapSizes = sizes;
+    return true;
+}
+
+void FontPack::close() {
+    file.close();
+    bytes = ByteSpan();
+    header = nullptr;
+    tables = nullptr;
+    glyphOffsets = nullptr;
+    glyphs = nullptr;
+    bitmapSizes = nullptr;
+}
+
+bool FontPack::matchesSource(ByteSpan sourceFont) const {
+    if (!header || header->sourceSize != sourceFont.size) return false;
+    return header->sourceHash == hashFontBytes(sourceFont);
+}
+
+bool FontPack::findTable(uint32_t tag, FontPackTable& table) const {
+    if (!header) return false;
+    const FontPackTable* end = tables + header->tableCount;
+    const FontPackTable* it = std::lower_bound(tables, end, tag,
+                                               [](const FontPackTable& t, uint32_t value) { return t.tag < value; });
+    if (it == end || it->tag != tag) return false;
+    table = *it;
+    return true;
+}
+
+bool FontPack::getOutline(int glyphIndex, GlyphOutline& outline) const {
+    if (!header || glyphIndex < 0 || glyphIndex >= header->numGlyphs) return false;
+    const FontPackGlyph& record = glyphs[glyphIndex];
+    if (!(record.flags & FONT_PACK_GLYPH_DECODED)) return false;
+
+    outline = GlyphOutline();
+    outline.header = record.header;
+    if (record.pointCount == 0 && record.contourCount == 0) return true;
+
+    size_t storage = outlineStorageBytes(record.pointCount, record.contourCount);
+    if (record.dataOffset % 2 != 0 || !bytes.contains(record.dataOffset, storage)) return false;
+
+    const uint8_t* data = bytes.data + record.dataOffset;
+    outline.contourCount = record.contourCount;
+    outline.pointCount = record.pointCount;
+    outline.endPts = reinterpret_cast<const uint16_t*>(data);
+    outline.xs = reinterpret_cast<const int16_t*>(data + record.contourCount * sizeof(uint16_t));
+    outline.ys = outline.xs + record.pointCount;
+    outline.onCurveBits = reinterpret_cast<const uint8_t*>(outline.ys + record.pointCount);
+    return true;
+}
+
+float FontPack::getBitmapSize(int sizeIndex) const {
+    if (!header || sizeIndex < 0 || sizeIndex >= header->bitmapSizeCount) return 0.0f;
+    return bitmapSizes[sizeIndex].pixelSize;
+}
+
+int FontPack::findBitmapSize(float pixelSize) const {
+    for (int s = 0; s < getBitmapSizeCount(); s++) {
+        if (bitmapSizes[s].pixelSize == pixelSize) return s;
+    }
+    return -1;
+}
+
+bool FontPack::getBitmap(int sizeIndex, int glyphIndex, PackedBitmap& bitmap) const {
+    if (!header || sizeIndex < 0 || sizeIndex >= header->bitmapSizeCount) return false;
+    if (glyphIndex < 0 || glyphIndex >= header->numGlyphs) return false;
+
+    const FontPackBitmap& record =
+        reinterpret_cast<const FontPackBitmap*>(bytes.data + bitmapSizes[sizeIndex].bitmapsOffset)[glyphIndex];
+    bitmap = PackedBitmap();
+    bitmap.left = record.left;
+    bitmap.top = record.top;
+    if (record.width == 0 || record.height == 0) return true; // Nothing drawn (empty or undecodable glyph)
+
+    if (!bytes.contains(record.pixelsOffset, static_cast<size_t>(record.width) * record.height)) return false;
+    bitmap.pixels = bytes.data + record.pixelsOffset;
+    bitmap.width = record.width;
+    bitmap.height = record.height;
+    return true;
+}
+
+bool openFontPack(const std::string& fontPath, const std::string& packPath,
+                  const FontPackOptions& options, FontPack& pack) {
+    MappedFile source;
+    if (!source.open(fontPath)) return false;
+
+    auto usable = [&]() {
+        if (!pack.open(packPath) || !pack.matchesSource(source.bytes())) return false;
+        for (float size : options.bitmapSizes) {
+            if (pack.findBitmapSize(size) < 0) return false;
+        }
+        return true;
+    };
+    if (usable()) return true;
+
+    pack.close();
+    return buildFontPack(fontPath, packPath, options) && usable();
+}
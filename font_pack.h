@@ -0,0 +1,145 @@
+#ifndef FONT_PACK_H
+#define FONT_PACK_H
+
+#include "font_source.h"
+#include "glyph_outline.h"
+
+// Font pack: a sidecar file holding everything the reader otherwise works
+// out at startup - the table directory, the 'loca' offsets, every glyph
+// decoded to SoA outline arrays and optionally pre-rendered bitmaps. It is
+// laid out as fixed-size records and aligned arrays addressed by file
+// offsets, so opening it is one mmap plus a header check; outlines and
+// bitmaps are used in place. Forked workers share the mapped pages.
+//
+// Packs are written in host byte order and rejected on a host with a
+// different one. The source font's size and content hash are recorded so a
+// pack left over from another version of the font is detected.
+
+const uint32_t FONT_PACK_VERSION = 1;
+
+struct FontPackHeader {
+    char magic[8];                  // "TRFPACK\0"
+    uint32_t version;
+    uint32_t byteOrder;             // 0x01020304 as the writing host stored it
+    uint64_t sourceHash;            // hashFontBytes() of the source font
+    uint64_t sourceSize;
+    uint64_t fileSize;
+    uint16_t unitsPerEm;
+    uint16_t numGlyphs;
+    uint16_t tableCount;
+    uint16_t bitmapSizeCount;
+    uint32_t indexToLocFormat;
+    uint32_t reserved;
+    uint64_t tablesOffset;          // FontPackTable[tableCount], sorted by tag
+    uint64_t locaOffset;            // uint32_t[numGlyphs + 1], byte offsets into 'glyf'
+    uint64_t glyphsOffset;          // FontPackGlyph[numGlyphs]
+    uint64_t bitmapSizesOffset;     // FontPackBitmapSize[bitmapSizeCount]
+};
+
+// A table directory entry of the source font
+struct FontPackTable {
+    uint32_t tag;
+    uint32_t checksum;
+    uint32_t offset;
+    uint32_t length;
+};
+
+const uint32_t FONT_PACK_GLYPH_DECODED = 1;     // Clear if the source glyph is malformed
+
+// One decoded outline: endPts, xs, ys and the on-curve bits back to back at
+// dataOffset, in the layout StoredOutline uses
+struct FontPackGlyph {
+    GlyphHeader header;
+    uint16_t contourCount;
+    uint32_t pointCount;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t dataOffset;
+};
+
+struct FontPackBitmapSize {
+    float pixelSize;
+    uint32_t reserved;
+    uint64_t bitmapsOffset;         // FontPackBitmap[numGlyphs]
+};
+
+// 8-bit coverage, rows top to bottom with stride == width. Placement as in
+// RasterPlacement (left/top relative to the pen, y up); width 0 = nothing drawn.
+struct FontPackBitmap {
+    int16_t left, top;
+    uint16_t width, height;
+    uint32_t reserved;
+    uint32_t reserved2;
+    uint64_t pixelsOffset;
+};
+
+// A bitmap served from a pack; pixels point into the read-only mapping
+struct PackedBitmap {
+    const uint8_t* pixels = nullptr;
+    int left = 0, top = 0;
+    int width = 0, height = 0;
+};
+
+struct FontPackOptions {
+    std::vector<float> bitmapSizes;     // Pixel sizes to pre-render; empty = outlines only
+    unsigned threads = 0;               // For pre-rendering; 0 = one per hardware thread
+};
+
+// 64-bit content hash for staleness checks (fast, not cryptographic)
+uint64_t hashFontBytes(ByteSpan bytes);
+
+// Compiles fontPath into a pack at packPath. The file is written under a
+// temporary name and renamed into place, so concurrent readers only ever
+// see a complete pack.
+bool buildFontPack(const std::string& fontPath, const std::string& packPath,
+                   const FontPackOptions& options = FontPackOptions());
+
+class FontPack {
+private:
+    MappedFile file;
+    ByteSpan bytes;
+    const FontPackHeader* header = nullptr;
+    const FontPackTable* tables = nullptr;
+    const uint32_t* glyphOffsets = nullptr;
+    const FontPackGlyph* glyphs = nullptr;
+    const FontPackBitmapSize* bitmapSizes = nullptr;
+
+public:
+    FontPack() = default;
+
+    FontPack(const FontPack&) = delete;
+    FontPack& operator=(const FontPack&) = delete;
+
+    // Maps the pack and checks its header and section bounds. Doesn't look
+    // at the source font - see matchesSource().
+    bool open(const std::string& packPath);
+    void close();
+    bool isOpen() const { return header != nullptr; }
+
+    // True if the pack was built from exactly these bytes
+    bool matchesSource(ByteSpan sourceFont) const;
+
+    uint16_t getNumGlyphs() const { return header ? header->numGlyphs : 0; }
+    uint16_t getUnitsPerEm() const { return header ? header->unitsPerEm : 0; }
+    uint64_t getSourceHash() const { return header ? header->sourceHash : 0; }
+    bool hasLongLoca() const { return header && header->indexToLocFormat == 1; }
+
+    bool findTable(uint32_t tag, FontPackTable& table) const;
+    const uint32_t* getGlyphOffsets() const { return glyphOffsets; }   // numGlyphs + 1 entries
+
+    // Zero-copy view into the mapping, valid while the pack is open. Fails
+    // for glyphs the source font couldn't decode, like loadOutline.
+    bool getOutline(int glyphIndex, GlyphOutline& outline) const;
+
+    int getBitmapSizeCount() const { return header ? header->bitmapSizeCount : 0; }
+    float getBitmapSize(int sizeIndex) const;
+    int findBitmapSize(float pixelSize) const;      // -1 if not pre-rendered
+    bool getBitmap(int sizeIndex, int glyphIndex, PackedBitmap& bitmap) const;
+};
+
+// Opens packPath if it matches fontPath, otherwise (missing, stale, corrupt
+// or foreign) rebuilds it first
+bool openFontPack(const std::string& fontPath, const std::string& packPath,
+                  const FontPackOptions& options, FontPack& pack);
+
+#endif
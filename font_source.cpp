@@ -0,0 +1,71 @@
+#include "font_source.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define FONT_SOURCE_HAS_MMAP 1
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+
+#ifdef FONT_SOURCE_HAS_MMAP
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference to the file
+
+    if (addr != MAP_FAILED) {
+        mappedData = static_cast<const uint8_t*>(addr);
+        mappedSize = static_cast<size_t>(st.st_size);
+        isMapped = true;
+        return true;
+    }
+    // mmap can fail on some filesystems - fall through to a plain read
+#endif
+
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+
+    std::streamsize length = file.tellg();
+    if (length <= 0) return false;
+
+    heapCopy.resize(static_cast<size_t>(length));
+    file.seekg(0, std::ios::beg);
+    if (!file.read(reinterpret_cast<char*>(heapCopy.data()), length)) {
+        heapCopy.clear();
+        return false;
+    }
+
+    mappedData = heapCopy.data();
+    mappedSize = heapCopy.size();
+    isMapped = false;
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef FONT_SOURCE_HAS_MMAP
+    if (isMapped && mappedData) {
+        munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+    }
+#endif
+    heapCopy.clear();
+    heapCopy.shrink_to_fit();
+    mappedData = nullptr;
+    mappedSize = 0;
+    isMapped = false;
+}
@@ -0,0 +1,93 @@
+#ifndef FONT_SOURCE_H
+#define FONT_SOURCE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only view over a range of font bytes.
+// TrueType data is big-endian, so values are assembled byte by byte straight
+// from memory - no stream, no byte swapping, same result on any host.
+struct ByteSpan {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+
+    ByteSpan() = default;
+    ByteSpan(const uint8_t* data, size_t size) : data(data), size(size) {}
+
+    bool empty() const { return size == 0; }
+
+    // True if [offset, offset + count) lies inside the span (overflow safe)
+    bool contains(size_t offset, size_t count) const {
+        return offset <= size && count <= size - offset;
+    }
+
+    // Sub-range of this span, or an empty span if it would run past the end
+    ByteSpan subspan(size_t offset, size_t count) const {
+        if (!contains(offset, count)) return ByteSpan();
+        return ByteSpan(data + offset, count);
+    }
+
+    // Unchecked loads - only call after contains() has validated the range
+    uint8_t u8(size_t offset) const { return data[offset]; }
+    uint16_t u16(size_t offset) const {
+        return static_cast<uint16_t>((data[offset] << 8) | data[offset + 1]);
+    }
+    int16_t i16(size_t offset) const { return static_cast<int16_t>(u16(offset)); }
+    uint32_t u32(size_t offset) const {
+        return (static_cast<uint32_t>(data[offset]) << 24) |
+               (static_cast<uint32_t>(data[offset + 1]) << 16) |
+               (static_cast<uint32_t>(data[offset + 2]) << 8) |
+               static_cast<uint32_t>(data[offset + 3]);
+    }
+
+    // Bounds-checked loads
+    bool readU8(size_t offset, uint8_t& out) const {
+        if (!contains(offset, 1)) return false;
+        out = u8(offset);
+        return true;
+    }
+    bool readU16(size_t offset, uint16_t& out) const {
+        if (!contains(offset, 2)) return false;
+        out = u16(offset);
+        return true;
+    }
+    bool readI16(size_t offset, int16_t& out) const {
+        if (!contains(offset, 2)) return false;
+        out = i16(offset);
+        return true;
+    }
+    bool readU32(size_t offset, uint32_t& out) const {
+        if (!contains(offset, 4)) return false;
+        out = u32(offset);
+        return true;
+    }
+};
+
+// A font file mapped read-only into memory.
+// Uses mmap where available; otherwise the file is read into a heap buffer
+// once so callers always see one contiguous ByteSpan.
+class MappedFile {
+private:
+    const uint8_t* mappedData = nullptr;
+    size_t mappedSize = 0;
+    bool isMapped = false;             // true = munmap on close, false = heap copy
+    std::vector<uint8_t> heapCopy;
+
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const { return mappedData != nullptr; }
+
+    ByteSpan bytes() const { return ByteSpan(mappedData, mappedSize); }
+    size_t size() const { return mappedSize; }
+};
+
+#endif
@@ -0,0 +1,653 @@
+#include "font_variations.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+// No runtime dispatch here: the kernels are built only when SSE2 is part of
+// the target ISA (always on x86-64, -msse2 or later on 32-bit x86)
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <immintrin.h>
+#define FONT_VARIATIONS_X86 1
+#endif
+
+namespace {
+
+// TupleVariationHeader.tupleIndex flags
+const uint16_t EMBEDDED_PEAK_TUPLE = 0x8000;
+const uint16_t INTERMEDIATE_REGION = 0x4000;
+const uint16_t PRIVATE_POINT_NUMBERS = 0x2000;
+const uint16_t TUPLE_INDEX_MASK = 0x0FFF;
+
+// GlyphVariationData.tupleVariationCount flags
+const uint16_t SHARED_POINT_NUMBERS = 0x8000;
+const uint16_t COUNT_MASK = 0x0FFF;
+
+// Packed point number and packed delta run headers
+const uint8_t POINTS_ARE_WORDS = 0x80;
+const uint8_t POINT_RUN_COUNT_MASK = 0x7F;
+const uint8_t DELTAS_ARE_ZERO = 0x80;
+const uint8_t DELTAS_ARE_WORDS = 0x40;
+const uint8_t DELTA_RUN_COUNT_MASK = 0x3F;
+
+std::atomic<uint32_t> nextInstanceSerial{1};
+
+float fixedToFloat(uint32_t value) {
+    return static_cast<int32_t>(value) / 65536.0f;
+}
+
+float f2dot14ToFloat(int16_t value) {
+    return value / 16384.0f;
+}
+
+int16_t floatToF2Dot14(float value) {
+    float clamped = std::max(-2.0f, std::min(value, 32767.0f / 16384.0f));
+    return static_cast<int16_t>(std::floor(clamped * 16384.0f + 0.5f));
+}
+
+// 'avar' segment map: piecewise linear through the (from, to) pairs, shifted
+// by the nearest pair's offset outside them
+float mapAxisValue(const std::vector<std::pair<float, float>>& map, float value) {
+    if (map.empty()) return value;
+    if (value <= map.front().first) return value + map.front().second - map.front().first;
+    if (value >= map.back().first) return value + map.back().second - map.back().first;
+    for (size_t i = 1; i < map.size(); i++) {
+        const auto& a = map[i - 1];
+        const auto& b = map[i];
+        if (value == b.first) return b.second;
+        if (value < b.first) {
+            return a.second + (b.second - a.second) * (value - a.first) / (b.first - a.first);
+        }
+    }
+    return value;
+}
+
+// Packed point numbers at data[offset]; offset is advanced past them. An
+// empty list with all set means every point, phantoms included.
+bool readPackedPoints(ByteSpan data, size_t& offset, std::vector<uint16_t>& points, bool& all) {
+    points.clear();
+    all = false;
+    uint8_t first;
+    if (!data.readU8(offset++, first)) return false;
+    size_t count = first;
+    if (first == 0) {
+        all = true;
+        return true;
+    }
+    if (first & POINTS_ARE_WORDS) {
+        uint8_t low;
+        if (!data.readU8(offset++, low)) return false;
+        count = (static_cast<size_t>(first & POINT_RUN_COUNT_MASK) << 8) | low;
+    }
+
+    points.reserve(count);
+    uint32_t point = 0;
+    while (points.size() < count) {
+        uint8_t control;
+        if (!data.readU8(offset++, control)) return false;
+        size_t run = (control & POINT_RUN_COUNT_MASK) + 1;
+        bool words = (control & POINTS_ARE_WORDS) != 0;
+        if (!data.contains(offset, run * (words ? 2 : 1))) return false;
+        for (size_t i = 0; i < run && points.size() < count; i++) {
+            point += words ? data.u16(offset + i * 2) : data.u8(offset + i);
+            points.push_back(static_cast<uint16_t>(point));
+        }
+        offset += run * (words ? 2 : 1);
+    }
+    return true;
+}
+
+// count packed deltas at data[offset] into out; offset is advanced past them
+bool readPackedDeltas(ByteSpan data, size_t& offset, size_t count, float* out) {
+    size_t produced = 0;
+    while (produced < count) {
+        uint8_t control;
+        if (!data.readU8(offset++, control)) return false;
+        size_t run = std::min<size_t>((control & DELTA_RUN_COUNT_MASK) + 1, count - produced);
+        size_t skipped = (control & DELTA_RUN_COUNT_MASK) + 1 - run;
+        if ((control & DELTAS_ARE_ZERO) && (control & DELTAS_ARE_WORDS)) {
+            if (!data.contains(offset, run * 4)) return false;
+            for (size_t i = 0; i < run; i++) {
+                out[produced + i] = static_cast<float>(static_cast<int32_t>(data.u32(offset + i * 4)));
+            }
+            offset += (run + skipped) * 4;
+        } else if (control & DELTAS_ARE_ZERO) {
+            std::fill(out + produced, out + produced + run, 0.0f);
+        } else if (control & DELTAS_ARE_WORDS) {
+            if (!data.contains(offset, run * 2)) return false;
+            for (size_t i = 0; i < run; i++) {
+                out[produced + i] = data.i16(offset + i * 2);
+            }
+            offset += (run + skipped) * 2;
+        } else {
+            if (!data.contains(offset, run)) return false;
+            for (size_t i = 0; i < run; i++) {
+                out[produced + i] = static_cast<int8_t>(data.u8(offset + i));
+            }
+            offset += run + skipped;
+        }
+        produced += run;
+    }
+    return true;
+}
+
+// Infers the deltas of untouched points in one contour from the touched
+// points on either side, along one axis (IUP in the 'gvar' spec)
+void inferSegment(const int16_t* coords, float* deltas, size_t from, size_t to, size_t start, size_t end,
+                  size_t before, size_t after) {
+    float c1 = coords[before], c2 = coords[after];
+    float d1 = deltas[before], d2 = deltas[after];
+    if (c1 > c2) {
+        std::swap(c1, c2);
+        std::swap(d1, d2);
+    }
+    for (size_t i = from; i != to; i = (i + 1 > end) ? start : i + 1) {
+        float c = coords[i];
+        if (c1 == c2) {
+            deltas[i] = (d1 == d2) ? d1 : 0.0f;
+        } else if (c <= c1) {
+            deltas[i] = d1;
+        } else if (c >= c2) {
+            deltas[i] = d2;
+        } else {
+            deltas[i] = d1 + (c - c1) * (d2 - d1) / (c2 - c1);
+        }
+    }
+}
+
+} // namespace
+
+float tupleScalar(const int16_t* coords, const int16_t* peak, const int16_t* start, const int16_t* end,
+                  size_t axisCount) {
+    float scalar = 1.0f;
+    for (size_t axis = 0; axis < axisCount; axis++) {
+        int p = peak[axis];
+        if (p == 0) continue;
+        int c = coords[axis];
+        if (c == p) continue;
+
+        int lower = start ? start[axis] : std::min(p, 0);
+        int upper = end ? end[axis] : std::max(p, 0);
+        if (lower > p || p > upper) continue;      // Invalid region: the axis is ignored
+        if (lower < 0 && upper > 0) continue;
+
+        if (c <= lower || c >= upper) return 0.0f;
+        if (c < p) {
+            scalar *= static_cast<float>(c - lower) / (p - lower);
+        } else {
+            scalar *= static_cast<float>(upper - c) / (upper - p);
+        }
+    }
+    return scalar;
+}
+
+bool FontVariations::load(const FontFace& face) {
+    clear();
+    ByteSpan fvar = face.tableData(face.lookupTable(TAG_FVAR));
+    if (fvar.empty()) return false;
+    if (!parseAxes(fvar)) {
+        clear();
+        return false;
+    }
+
+    const TableEntry* avarTable = face.lookupTable(TAG_AVAR);
+    if (avarTable && !parseAxisMaps(face.tableData(avarTable))) {
+        clear();
+        return false;
+    }
+
+    const TableEntry* gvarTable = face.lookupTable(TAG_GVAR);
+    if (gvarTable && !parseGlyphVariations(face.tableData(gvarTable))) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void FontVariations::clear() {
+    axes.clear();
+    namedInstances.clear();
+    axisMaps.clear();
+    sharedTuples.clear();
+    gvar = ByteSpan();
+    glyphCount = 0;
+    dataArrayOffset = 0;
+    longOffsets = false;
+}
+
+bool FontVariations::parseAxes(ByteSpan fvar) {
+    uint16_t axesOffset, axisCount, axisSize, instanceCount, instanceSize;
+    if (!fvar.readU16(4, axesOffset) || !fvar.readU16(8, axisCount) || !fvar.readU16(10, axisSize) ||
+        !fvar.readU16(12, instanceCount) || !fvar.readU16(14, instanceSize)) {
+        return false;
+    }
+    if (axisCount == 0 || axisSize < 20 || instanceSize < 4 + axisCount * 4) return false;
+    if (!fvar.contains(axesOffset, static_cast<size_t>(axisCount) * axisSize)) return false;
+
+    axes.resize(axisCount);
+    for (size_t i = 0; i < axisCount; i++) {
+        size_t record = axesOffset + i * axisSize;
+        VariationAxis& axis = axes[i];
+        for (int c = 0; c < 4; c++) {
+            axis.tag[c] = static_cast<char>(fvar.u8(record + c));
+        }
+        axis.tag[4] = '\0';
+        axis.minValue = fixedToFloat(fvar.u32(record + 4));
+        axis.defaultValue = fixedToFloat(fvar.u32(record + 8));
+        axis.maxValue = fixedToFloat(fvar.u32(record + 12));
+        axis.flags = fvar.u16(record + 16);
+        axis.nameId = fvar.u16(record + 18);
+        // Out-of-order ranges are clamped to the default rather than rejected
+        axis.minValue = std::min(axis.minValue, axis.defaultValue);
+        axis.maxValue = std::max(axis.maxValue, axis.defaultValue);
+    }
+
+    // Instances follow the axes; a truncated list just ends early
+    size_t instancesOffset = axesOffset + static_cast<size_t>(axisCount) * axisSize;
+    for (size_t i = 0; i < instanceCount; i++) {
+        size_t record = instancesOffset + i * instanceSize;
+        if (!fvar.contains(record, instanceSize)) break;
+        NamedInstance instance;
+        instance.subfamilyNameId = fvar.u16(record);
+        instance.coordinates.resize(axisCount);
+        for (size_t a = 0; a < axisCount; a++) {
+            instance.coordinates[a] = fixedToFloat(fvar.u32(record + 4 + a * 4));
+        }
+        namedInstances.push_back(std::move(instance));
+    }
+    return true;
+}
+
+bool FontVariations::parseAxisMaps(ByteSpan avar) {
+    uint16_t axisCount;
+    if (!avar.readU16(6, axisCount) || axisCount != axes.size()) return false;
+
+    axisMaps.assign(axisCount, {});
+    size_t offset = 8;
+    for (size_t axis = 0; axis < axisCount; axis++) {
+        uint16_t pairCount;
+        if (!avar.readU16(offset, pairCount) || !avar.contains(offset + 2, pairCount * 4u)) return false;
+        offset += 2;
+        auto& map = axisMaps[axis];
+        for (size_t i = 0; i < pairCount; i++, offset += 4) {
+            map.emplace_back(f2dot14ToFloat(avar.i16(offset)), f2dot14ToFloat(avar.i16(offset + 2)));
+        }
+        // The identity-only map {-1:-1, 0:0, 1:1} is the same as no map
+        bool identity = std::all_of(map.begin(), map.end(), [](const auto& p) { return p.first == p.second; });
+        if (identity) map.clear();
+    }
+    return true;
+}
+
+bool FontVariations::parseGlyphVariations(ByteSpan table) {
+    uint16_t axisCount, sharedCount, glyphs, flags;
+    uint32_t sharedOffset, arrayOffset;
+    if (!table.readU16(4, axisCount) || !table.readU16(6, sharedCount) || !table.readU32(8, sharedOffset) ||
+        !table.readU16(12, glyphs) || !table.readU16(14, flags) || !table.readU32(16, arrayOffset)) {
+        return false;
+    }
+    if (axisCount != axes.size()) return false;
+
+    longOffsets = (flags & 1) != 0;
+    size_t offsetsSize = (static_cast<size_t>(glyphs) + 1) * (longOffsets ? 4 : 2);
+    if (!table.contains(20, offsetsSize)) return false;
+
+    size_t sharedSize = static_cast<size_t>(sharedCount) * axisCount * 2;
+    if (!table.contains(sharedOffset, sharedSize)) return false;
+    sharedTuples.resize(static_cast<size_t>(sharedCount) * axisCount);
+    for (size_t i = 0; i < sharedTuples.size(); i++) {
+        sharedTuples[i] = table.i16(sharedOffset + i * 2);
+    }
+
+    gvar = table;
+    glyphCount = glyphs;
+    dataArrayOffset = arrayOffset;
+    return true;
+}
+
+int FontVariations::findAxis(const char* tag) const {
+    for (size_t i = 0; i < axes.size(); i++) {
+        if (std::equal(axes[i].tag, axes[i].tag + 4, tag)) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+void FontVariations::normalize(const std::vector<float>& userCoords, std::vector<float>& normalized) const {
+    normalized.assign(axes.size(), 0.0f);
+    for (size_t i = 0; i < axes.size() && i < userCoords.size(); i++) {
+        const VariationAxis& axis = axes[i];
+        float value = std::max(axis.minValue, std::min(userCoords[i], axis.maxValue));
+        float n = 0.0f;
+        if (value < axis.defaultValue) {
+            n = (value - axis.defaultValue) / (axis.defaultValue - axis.minValue);
+        } else if (value > axis.defaultValue) {
+            n = (value - axis.defaultValue) / (axis.maxValue - axis.defaultValue);
+        }
+        // Mapped at full precision and quantized once, as FreeType and fontTools do
+        if (i < axisMaps.size()) {
+            n = mapAxisValue(axisMaps[i], n);
+        }
+        normalized[i] = f2dot14ToFloat(floatToF2Dot14(n));
+    }
+}
+
+std::shared_ptr<const VariationInstance> FontVariations::createInstance(
+        const std::vector<float>& normalizedCoords) const {
+    auto instance = std::make_shared<VariationInstance>();
+    instance->variations = this;
+    instance->coords.assign(axes.size(), 0);
+    for (size_t i = 0; i < axes.size() && i < normalizedCoords.size(); i++) {
+        float n = std::max(-1.0f, std::min(normalizedCoords[i], 1.0f));
+        instance->coords[i] = floatToF2Dot14(n);
+        if (instance->coords[i] != 0) instance->atDefault = false;
+    }
+
+    size_t sharedCount = getSharedTupleCount();
+    instance->sharedScalars.resize(sharedCount);
+    for (size_t i = 0; i < sharedCount; i++) {
+        instance->sharedScalars[i] =
+            tupleScalar(instance->coords.data(), getSharedTuple(i), nullptr, nullptr, axes.size());
+    }
+
+    uint32_t serial = nextInstanceSerial.fetch_add(1, std::memory_order_relaxed);
+    if (serial == 0) serial = nextInstanceSerial.fetch_add(1, std::memory_order_relaxed);
+    instance->serial = serial;
+    return instance;
+}
+
+ByteSpan FontVariations::glyphVariationData(int glyphIndex) const {
+    if (gvar.empty() || glyphIndex < 0 || static_cast<size_t>(glyphIndex) >= glyphCount) return ByteSpan();
+    size_t start, end;
+    if (longOffsets) {
+        start = gvar.u32(20 + glyphIndex * 4);
+        end = gvar.u32(20 + (glyphIndex + 1) * 4);
+    } else {
+        start = gvar.u16(20 + glyphIndex * 2) * 2u;
+        end = gvar.u16(20 + (glyphIndex + 1) * 2) * 2u;
+    }
+    if (end <= start) return ByteSpan();
+    return gvar.subspan(dataArrayOffset + start, end - start);
+}
+
+VariationInstanceCache::VariationInstanceCache(const FontVariations& variations, size_t capacity)
+    : variations(variations), capacity(std::max<size_t>(capacity, 1)) {}
+
+std::shared_ptr<const VariationInstance> VariationInstanceCache::acquire(
+        const std::vector<float>& normalizedCoords) {
+    // Keyed by the quantized location, so nearby floats share an instance
+    std::vector<int16_t> key(variations.getAxes().size(), 0);
+    for (size_t i = 0; i < key.size() && i < normalizedCoords.size(); i++) {
+        key[i] = floatToF2Dot14(std::max(-1.0f, std::min(normalizedCoords[i], 1.0f)));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        it->second.lastUse = ++useClock;
+        return it->second.instance;
+    }
+
+    if (entries.size() >= capacity) {
+        auto oldest = std::min_element(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            return a.second.lastUse < b.second.lastUse;
+        });
+        entries.erase(oldest);
+    }
+
+    std::vector<float> coords(key.size());
+    for (size_t i = 0; i < key.size(); i++) {
+        coords[i] = f2dot14ToFloat(key[i]);
+    }
+    auto instance = variations.createInstance(coords);
+    entries.emplace(std::move(key), Entry{instance, ++useClock});
+    return instance;
+}
+
+size_t VariationInstanceCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void VariationInstanceCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+bool GlyphVariator::compute(const VariationInstance& instance, int glyphIndex, size_t points,
+                            const int16_t* xs, const int16_t* ys, const uint16_t* endPts, size_t contourCount) {
+    varied = false;
+    pointCount = points;
+    const FontVariations* variations = instance.getVariations();
+    if (!variations || instance.isDefault()) return true;
+
+    ByteSpan data = variations->glyphVariationData(glyphIndex);
+    if (data.empty()) return true;
+
+    uint16_t tupleCount, dataOffset;
+    if (!data.readU16(0, tupleCount) || !data.readU16(2, dataOffset)) return false;
+
+    const size_t axisCount = variations->getAxes().size();
+    const size_t total = points + 4;    // Phantom points: left/right side bearing, top/bottom
+    const int16_t* coords = instance.getCoordinates().data();
+
+    sumX.assign(total, 0.0f);
+    sumY.assign(total, 0.0f);
+    tupleX.resize(total);
+    tupleY.resize(total);
+
+    size_t serialized = dataOffset;
+    bool sharedAll = true;
+    sharedPoints.clear();
+    if (tupleCount & SHARED_POINT_NUMBERS) {
+        if (!readPackedPoints(data, serialized, sharedPoints, sharedAll)) return false;
+    }
+
+    size_t header = 4;
+    for (size_t t = 0; t < (tupleCount & COUNT_MASK); t++) {
+        uint16_t dataSize, tupleIndex;
+        if (!data.readU16(header, dataSize) || !data.readU16(header + 2, tupleIndex)) return false;
+        size_t headerSize = 4;
+        size_t regionBytes = axisCount * 2;
+
+        const int16_t* peak = nullptr;
+        ByteSpan embedded;
+        if (tupleIndex & EMBEDDED_PEAK_TUPLE) {
+            if (!data.contains(header + headerSize, regionBytes)) return false;
+            embedded = data.subspan(header + headerSize, regionBytes);
+            headerSize += regionBytes;
+        } else {
+            size_t shared = tupleIndex & TUPLE_INDEX_MASK;
+            if (shared >= variations->getSharedTupleCount()) return false;
+            peak = variations->getSharedTuple(shared);
+        }
+        size_t intermediateOffset = header + headerSize;
+        if (tupleIndex & INTERMEDIATE_REGION) {
+            if (!data.contains(intermediateOffset, regionBytes * 2)) return false;
+            headerSize += regionBytes * 2;
+        }
+
+        // Scalar: precomputed for plain shared tuples, decoded otherwise
+        float scalar;
+        if (!(tupleIndex & (EMBEDDED_PEAK_TUPLE | INTERMEDIATE_REGION))) {
+            scalar = instance.getSharedScalar(tupleIndex & TUPLE_INDEX_MASK);
+        } else {
+            int16_t region[3 * 64];
+            if (axisCount > 64) return false;
+            int16_t* peakValues = region;
+            int16_t* startValues = region + axisCount;
+            int16_t* endValues = region + axisCount * 2;
+            for (size_t a = 0; a < axisCount; a++) {
+                peakValues[a] = peak ? peak[a] : embedded.i16(a * 2);
+                if (tupleIndex & INTERMEDIATE_REGION) {
+                    startValues[a] = data.i16(intermediateOffset + a * 2);
+                    endValues[a] = data.i16(intermediateOffset + regionBytes + a * 2);
+                }
+            }
+            bool intermediate = (tupleIndex & INTERMEDIATE_REGION) != 0;
+            scalar = tupleScalar(coords, peakValues, intermediate ? startValues : nullptr,
+                                 intermediate ? endValues : nullptr, axisCount);
+        }
+
+        size_t tupleData = serialized;
+        serialized += dataSize;
+        header += headerSize;
+        if (scalar == 0.0f) continue;
+
+        ByteSpan tupleSpan = data.subspan(tupleData, dataSize);
+        if (tupleSpan.size != dataSize) return false;
+        size_t offset = 0;
+
+        const std::vector<uint16_t>* pointList = &sharedPoints;
+        bool all = sharedAll;
+        if (tupleIndex & PRIVATE_POINT_NUMBERS) {
+            if (!readPackedPoints(tupleSpan, offset, tuplePoints, all)) return false;
+            pointList = &tuplePoints;
+        }
+
+        if (all) {
+            if (!readPackedDeltas(tupleSpan, offset, total, tupleX.data()) ||
+                !readPackedDeltas(tupleSpan, offset, total, tupleY.data())) {
+                return false;
+            }
+        } else {
+            // Sparse: decode the listed points, scatter them, then infer the rest
+            size_t listed = pointList->size();
+            listedX.resize(listed);
+            listedY.resize(listed);
+            if (!readPackedDeltas(tupleSpan, offset, listed, listedX.data()) ||
+                !readPackedDeltas(tupleSpan, offset, listed, listedY.data())) {
+                return false;
+            }
+            std::fill(tupleX.begin(), tupleX.end(), 0.0f);
+            std::fill(tupleY.begin(), tupleY.end(), 0.0f);
+            touched.assign(total, 0);
+            for (size_t i = 0; i < listed; i++) {
+                uint16_t point = (*pointList)[i];
+                if (point >= total) continue;
+                tupleX[point] = listedX[i];
+                tupleY[point] = listedY[i];
+                touched[point] = 1;
+            }
+            if (xs && contourCount > 0) {
+                inferDeltas(xs, ys, endPts, contourCount);
+            }
+        }
+
+        accumulateScaledDeltas(sumX.data(), tupleX.data(), scalar, total);
+        accumulateScaledDeltas(sumY.data(), tupleY.data(), scalar, total);
+        varied = true;
+    }
+    return true;
+}
+
+void GlyphVariator::inferDeltas(const int16_t* xs, const int16_t* ys, const uint16_t* endPts,
+                                size_t contourCount) {
+    size_t start = 0;
+    for (size_t c = 0; c < contourCount; c++) {
+        size_t end = endPts[c];
+        if (end < start || end >= pointCount) break;
+
+        anchors.clear();
+        for (size_t i = start; i <= end; i++) {
+            if (touched[i]) anchors.push_back(static_cast<uint32_t>(i));
+        }
+
+        if (anchors.size() == 1) {
+            for (size_t i = start; i <= end; i++) {
+                tupleX[i] = tupleX[anchors[0]];
+                tupleY[i] = tupleY[anchors[0]];
+            }
+        } else if (anchors.size() > 1 && anchors.size() < end - start + 1) {
+            // Each run of untouched points lies between two touched ones, wrapping around
+            for (size_t k = 0; k < anchors.size(); k++) {
+                size_t before = anchors[k];
+                size_t after = anchors[(k + 1) % anchors.size()];
+                size_t from = (before == end) ? start : before + 1;
+                if (from == after) continue;
+                inferSegment(xs, tupleX.data(), from, after, start, end, before, after);
+                inferSegment(ys, tupleY.data(), from, after, start, end, before, after);
+            }
+        }
+        start = end + 1;
+    }
+}
+
+void GlyphVariator::apply(int16_t* xs, int16_t* ys, size_t count) const {
+    if (!varied) return;
+    count = std::min(count, pointCount + 4);
+    applyRoundedDeltas(xs, sumX.data(), count);
+    applyRoundedDeltas(ys, sumY.data(), count);
+}
+
+static void accumulateScaledDeltasScalar(float* sum, const float* deltas, float scalar, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        sum[i] += scalar * deltas[i];
+    }
+}
+
+static int16_t roundDelta(int16_t coord, float delta) {
+    float moved = std::floor(coord + delta + 0.5f);
+    return static_cast<int16_t>(std::max(-32768.0f, std::min(moved, 32767.0f)));
+}
+
+void applyRoundedDeltasScalar(int16_t* coords, const float* deltas, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        coords[i] = roundDelta(coords[i], deltas[i]);
+    }
+}
+
+bool deltaKernelsVectorized() {
+#ifdef FONT_VARIATIONS_X86
+    return true;
+#else
+    return false;
+#endif
+}
+
+void accumulateScaledDeltas(float* sum, const float* deltas, float scalar, size_t count) {
+    size_t i = 0;
+#ifdef FONT_VARIATIONS_X86
+    // Four points per step
+    const __m128 s = _mm_set1_ps(scalar);
+    for (; i + 4 <= count; i += 4) {
+        __m128 d = _mm_loadu_ps(deltas + i);
+        _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(s, d)));
+    }
+#endif
+    accumulateScaledDeltasScalar(sum + i, deltas + i, scalar, count - i);
+}
+
+void applyRoundedDeltas(int16_t* coords, const float* deltas, size_t count) {
+    size_t i = 0;
+#ifdef FONT_VARIATIONS_X86
+    // Eight points per step: sign-extend to 32 bits, floor(coord + delta + 0.5)
+    // via truncation fixed up for negatives, then pack back with saturation
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 lowest = _mm_set1_ps(-32769.0f);
+    const __m128 highest = _mm_set1_ps(32768.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(coords + i));
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+
+        __m128 movedLow = _mm_add_ps(_mm_add_ps(_mm_cvtepi32_ps(low), _mm_loadu_ps(deltas + i)), half);
+        __m128 movedHigh = _mm_add_ps(_mm_add_ps(_mm_cvtepi32_ps(high), _mm_loadu_ps(deltas + i + 4)), half);
+        // Clamp first: past the int32 range the conversion returns INT_MIN
+        // whatever the sign. A NaN passes through (min/max return the second
+        // operand) and lands on -32768, as the scalar code does.
+        movedLow = _mm_max_ps(lowest, _mm_min_ps(highest, movedLow));
+        movedHigh = _mm_max_ps(lowest, _mm_min_ps(highest, movedHigh));
+
+        __m128i truncLow = _mm_cvttps_epi32(movedLow);
+        __m128i truncHigh = _mm_cvttps_epi32(movedHigh);
+        // Truncation rounds negatives up; subtract 1 where that overshot
+        truncLow = _mm_add_epi32(truncLow,
+                                 _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(truncLow), movedLow)));
+        truncHigh = _mm_add_epi32(truncHigh,
+                                  _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(truncHigh), movedHigh)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(coords + i), _mm_packs_epi32(truncLow, truncHigh));
+    }
+#endif
+    applyRoundedDeltasScalar(coords + i, deltas + i, count - i);
+}
+
@@ -0,0 +1,182 @@
+#ifndef FONT_VARIATIONS_H
+#define FONT_VARIATIONS_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "font_face.h"
+
+// TrueType variable fonts: 'fvar' axes, 'avar' axis remapping and 'gvar'
+// per-glyph tuple variations. A location is a set of normalized coordinates,
+// one per axis, in [-1, 1] with 0 at the default master; each tuple variation
+// contributes its point deltas scaled by how strongly its region applies there.
+
+const uint32_t TAG_FVAR = makeTag('f', 'v', 'a', 'r');
+const uint32_t TAG_AVAR = makeTag('a', 'v', 'a', 'r');
+const uint32_t TAG_GVAR = makeTag('g', 'v', 'a', 'r');
+
+struct VariationAxis {
+    char tag[5];            // e.g. "wght"
+    float minValue;         // User-space range
+    float defaultValue;
+    float maxValue;
+    uint16_t flags;         // 0x0001 = hidden from user interfaces
+    uint16_t nameId;        // Axis name in the 'name' table
+};
+
+// Named instance from 'fvar' (e.g. "Bold"), in user-space coordinates
+struct NamedInstance {
+    uint16_t subfamilyNameId;
+    std::vector<float> coordinates;
+};
+
+class FontVariations;
+
+// One location, ready to apply: its coordinates in F2DOT14 (the precision
+// 'gvar' is defined in) and the scalar of every shared tuple there, computed
+// once instead of for every glyph. Immutable; create through
+// FontVariations::createInstance and share freely between threads.
+class VariationInstance {
+private:
+    friend class FontVariations;
+    const FontVariations* variations = nullptr;
+    std::vector<int16_t> coords;
+    std::vector<float> sharedScalars;
+    uint32_t serial = 0;
+    bool atDefault = true;
+
+public:
+    const FontVariations* getVariations() const { return variations; }
+    const std::vector<int16_t>& getCoordinates() const { return coords; }
+    float getSharedScalar(size_t index) const { return sharedScalars[index]; }
+    bool isDefault() const { return atDefault; }     // Every coordinate 0: outlines are unchanged
+    uint32_t getSerial() const { return serial; }    // Unique per instance and never 0; keys cached outlines
+};
+
+// Scalar of a tuple's region at coords (all F2DOT14, axisCount entries each).
+// start/end may be null for a tuple with no intermediate region.
+float tupleScalar(const int16_t* coords, const int16_t* peak, const int16_t* start, const int16_t* end,
+                  size_t axisCount);
+
+// Parsed 'fvar', 'avar' and the 'gvar' index of a face. Glyph variation data
+// stays in the mapping and is decoded per glyph. Immutable after load(); the
+// face must stay open while this is used.
+class FontVariations {
+private:
+    std::vector<VariationAxis> axes;
+    std::vector<NamedInstance> namedInstances;
+    std::vector<std::vector<std::pair<float, float>>> axisMaps;    // 'avar' segment maps, empty = identity
+    std::vector<int16_t> sharedTuples;  // sharedTupleCount x axisCount
+    ByteSpan gvar;
+    size_t glyphCount = 0;
+    size_t dataArrayOffset = 0;
+    bool longOffsets = false;
+
+    bool parseAxes(ByteSpan fvar);
+    bool parseAxisMaps(ByteSpan avar);
+    bool parseGlyphVariations(ByteSpan table);
+
+public:
+    // False for static fonts (no 'fvar') or malformed variation tables. A
+    // font with 'fvar' but no 'gvar' loads; its outlines just don't vary.
+    bool load(const FontFace& face);
+    void clear();
+    bool isLoaded() const { return !axes.empty(); }
+
+    const std::vector<VariationAxis>& getAxes() const { return axes; }
+    const std::vector<NamedInstance>& getNamedInstances() const { return namedInstances; }
+    int findAxis(const char* tag) const;    // -1 if the font has no such axis
+
+    // User-space values (one per axis; missing ones take the default) to
+    // normalized coordinates: clamped to the axis range, mapped to [-1, 1]
+    // around the default, then through 'avar'
+    void normalize(const std::vector<float>& userCoords, std::vector<float>& normalized) const;
+
+    // Instance at normalized coordinates (rounded to F2DOT14), with the
+    // shared tuple scalars precomputed
+    std::shared_ptr<const VariationInstance> createInstance(const std::vector<float>& normalizedCoords) const;
+
+    size_t getSharedTupleCount() const { return axes.empty() ? 0 : sharedTuples.size() / axes.size(); }
+    const int16_t* getSharedTuple(size_t index) const { return &sharedTuples[index * axes.size()]; }
+
+    // The glyph's GlyphVariationData, or an empty span if it doesn't vary
+    ByteSpan glyphVariationData(int glyphIndex) const;
+};
+
+// Instances by location. An animation that keeps revisiting the same
+// weights gets back the same instance - same scalars, same serial, so the
+// outlines a GlyphCache holds for it keep hitting. Least recently used
+// locations are dropped past capacity. Thread-safe.
+class VariationInstanceCache {
+private:
+    struct Entry {
+        std::shared_ptr<const VariationInstance> instance;
+        uint64_t lastUse;
+    };
+
+    const FontVariations& variations;
+    size_t capacity;
+    mutable std::mutex mutex;
+    std::map<std::vector<int16_t>, Entry> entries;
+    uint64_t useClock = 0;
+
+public:
+    explicit VariationInstanceCache(const FontVariations& variations, size_t capacity = 16);
+
+    VariationInstanceCache(const VariationInstanceCache&) = delete;
+    VariationInstanceCache& operator=(const VariationInstanceCache&) = delete;
+
+    std::shared_ptr<const VariationInstance> acquire(const std::vector<float>& normalizedCoords);
+    size_t size() const;
+    void clear();
+};
+
+// Scratch for turning a glyph's tuple variations into summed point deltas.
+// Not thread-safe; TTFReader keeps one per reader.
+class GlyphVariator {
+private:
+    std::vector<float> sumX, sumY;          // Scaled deltas summed over tuples
+    std::vector<float> tupleX, tupleY;      // One tuple's deltas, before scaling
+    std::vector<float> listedX, listedY;    // Deltas of a sparse tuple, in point list order
+    std::vector<uint8_t> touched;           // Points the tuple lists explicitly
+    std::vector<uint32_t> anchors;          // Touched points of the contour being inferred
+    std::vector<uint16_t> sharedPoints, tuplePoints;
+    size_t pointCount = 0;
+    bool varied = false;
+
+    void inferDeltas(const int16_t* xs, const int16_t* ys, const uint16_t* endPts, size_t contourCount);
+
+public:
+    // Sums the deltas of every tuple of glyphIndex that applies at instance.
+    // pointCount excludes the four phantom points. For a simple glyph, xs/ys
+    // and endPts are its default outline and deltas of points a tuple leaves
+    // out are inferred from their neighbours (IUP). For a composite, pass
+    // null/0: "points" are the components' offsets and nothing is inferred.
+    // False on malformed data; true with hasDeltas() false if nothing applies.
+    bool compute(const VariationInstance& instance, int glyphIndex, size_t pointCount,
+                 const int16_t* xs, const int16_t* ys, const uint16_t* endPts, size_t contourCount);
+
+    bool hasDeltas() const { return varied; }
+    float deltaX(size_t point) const { return sumX[point]; }
+    float deltaY(size_t point) const { return sumY[point]; }
+
+    // xs[i] += deltaX(i), ys[i] += deltaY(i), rounded half up, for the first count points
+    void apply(int16_t* xs, int16_t* ys, size_t count) const;
+};
+
+// Dense delta kernels: sum += scalar * delta, and coords = round(coords + sum)
+// (half up, saturated). SSE2 when the build targets it, scalar otherwise;
+// identical results.
+void accumulateScaledDeltas(float* sum, const float* deltas, float scalar, size_t count);
+void applyRoundedDeltas(int16_t* coords, const float* deltas, size_t count);
+
+// Scalar reference for applyRoundedDeltas, for differential testing
+void applyRoundedDeltasScalar(int16_t* coords, const float* deltas, size_t count);
+
+// True if this build has the SSE2 kernels; otherwise the two above are the
+// scalar loops and there is nothing to compare
+bool deltaKernelsVectorized();
+
+#endif
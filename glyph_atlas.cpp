@@ -0,0 +1,294 @@
+#include "glyph_atlas.h"
+#include "glyph_cache.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+SkylinePacker::SkylinePacker(int width, int height) {
+    reset(width, height);
+}
+
+void SkylinePacker::reset(int newWidth, int newHeight) {
+    width = std::max(newWidth, 0);
+    height = std::max(newHeight, 0);
+    usedArea = 0;
+    skyline.clear();
+    if (width > 0) skyline.push_back(Segment{0, 0, width});
+}
+
+int SkylinePacker::fitAt(size_t index, int w, int h) const {
+    if (skyline[index].x + w > width) return -1;
+
+    // The rectangle rests on the highest segment it spans
+    int y = 0;
+    int remaining = w;
+    for (size_t i = index; remaining > 0; i++) {
+        if (i >= skyline.size()) return -1;
+        y = std::max(y, skyline[i].y);
+        if (y + h > height) return -1;
+        remaining -= skyline[i].width;
+    }
+    return y;
+}
+
+bool SkylinePacker::insert(int w, int h, AtlasRect& placed) {
+    if (w <= 0 || h <= 0) return false;
+
+    size_t best = SIZE_MAX;
+    int bestY = 0;
+    int bestBottom = INT_MAX;
+    int bestWidth = INT_MAX;
+    for (size_t i = 0; i < skyline.size(); i++) {
+        int y = fitAt(i, w, h);
+        if (y < 0) continue;
+        if (y + h < bestBottom || (y + h == bestBottom && skyline[i].width < bestWidth)) {
+            best = i;
+            bestY = y;
+            bestBottom = y + h;
+            bestWidth = skyline[i].width;
+        }
+    }
+    if (best == SIZE_MAX) return false;
+
+    placed.x = skyline[best].x;
+    placed.y = bestY;
+    placed.width = w;
+    placed.height = h;
+
+    // New segment on top of the rectangle; trim the ones it now covers
+    skyline.insert(skyline.begin() + best, Segment{placed.x, bestY + h, w});
+    for (size_t i = best + 1; i < skyline.size();) {
+        int covered = skyline[i - 1].x + skyline[i - 1].width - skyline[i].x;
+        if (covered <= 0) break;
+        if (covered < skyline[i].width) {
+            skyline[i].x += covered;
+            skyline[i].width -= covered;
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Neighbours at the same height become one segment
+    for (size_t i = 0; i + 1 < skyline.size();) {
+        if (skyline[i].y == skyline[i + 1].y) {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+
+    usedArea += static_cast<size_t>(w) * h;
+    return true;
+}
+
+float SkylinePacker::occupancy() const {
+    size_t area = static_cast<size_t>(width) * height;
+    return area ? static_cast<float>(usedArea) / area : 0.0f;
+}
+
+size_t GlyphAtlas::KeyHash::operator()(const Key& key) const {
+    uint32_t sizeBits;
+    std::memcpy(&sizeBits, &key.pixelSize, sizeof(sizeBits));
+    return std::hash<uint64_t>()(key.glyph ^ (static_cast<uint64_t>(sizeBits) * 0x9E3779B97F4A7C15ull));
+}
+
+GlyphAtlas::GlyphAtlas(TTFReader& reader, const GlyphAtlasOptions& options) : reader(reader), options(options) {
+    this->options.pageWidth = std::max(this->options.pageWidth, 1);
+    this->options.pageHeight = std::max(this->options.pageHeight, 1);
+    this->options.padding = std::max(this->options.padding, 0);
+    this->options.maxPages = std::max(this->options.maxPages, 1);
+    this->options.maxDirtyRects = std::max<size_t>(this->options.maxDirtyRects, 1);
+}
+
+GlyphAtlas::Key GlyphAtlas::makeKey(uint16_t glyphIndex, float pixelSize) const {
+    const auto& instance = reader.getVariationInstance();
+    uint32_t serial = (instance && !instance->isDefault()) ? instance->getSerial() : 0;
+    return Key{glyphCacheKey(glyphIndex, serial), pixelSize};
+}
+
+bool GlyphAtlas::contains(uint16_t glyphIndex, float pixelSize) const {
+    return entries.count(makeKey(glyphIndex, pixelSize)) != 0;
+}
+
+bool GlyphAtlas::acquire(uint16_t glyphIndex, float pixelSize, AtlasEntry& entry) {
+    Key key = makeKey(glyphIndex, pixelSize);
+    auto found = entries.find(key);
+    if (found != entries.end()) {
+        stats.hits++;
+        if (found->second.page >= 0) pages[found->second.page].lastUse = ++useClock;
+        entry = found->second;
+        return true;
+    }
+    stats.misses++;
+
+    std::shared_ptr<const StoredOutline> glyph = reader.acquireGlyph(glyphIndex);
+    if (!glyph) return false;
+
+    AtlasEntry added;
+    added.glyphIndex = glyphIndex;
+    added.pixelSize = pixelSize;
+
+    RasterPlacement placement = computeRasterPlacement(glyph->header, pixelSize, reader.getUnitsPerEm());
+    if (glyph->contourCount == 0 || placement.width <= 0 || placement.height <= 0) {
+        // Nothing to draw, but layout still wants to know the glyph is there
+        entries.emplace(key, added);
+        entry = added;
+        return true;
+    }
+
+    int pageIndex;
+    AtlasRect rect;
+    if (!allocate(placement.width + options.padding, placement.height + options.padding, pageIndex, rect)) {
+        return false;
+    }
+    rect.width = placement.width;
+    rect.height = placement.height;
+
+    // Rendered in place: the page is the output bitmap, offset to the slot
+    Page& page = pages[pageIndex];
+    size_t cells = rasterScratchCells(placement);
+    if (scratch.size() < cells) scratch.resize(cells);
+    GlyphBitmap slot;
+    slot.pixels = page.pixels.data() + static_cast<size_t>(rect.y) * options.pageWidth + rect.x;
+    slot.width = rect.width;
+    slot.height = rect.height;
+    slot.stride = options.pageWidth;
+    if (!rasterizeGlyph(*glyph, placement, scratch.data(), scratch.size(), slot)) return false;
+
+    added.page = pageIndex;
+    added.rect = rect;
+    added.u0 = static_cast<float>(rect.x) / options.pageWidth;
+    added.v0 = static_cast<float>(rect.y) / options.pageHeight;
+    added.u1 = static_cast<float>(rect.x + rect.width) / options.pageWidth;
+    added.v1 = static_cast<float>(rect.y + rect.height) / options.pageHeight;
+    added.left = placement.left;
+    added.top = placement.top;
+
+    page.keys.push_back(key);
+    markDirty(page, rect);
+    entries.emplace(key, added);
+    entry = added;
+    return true;
+}
+
+bool GlyphAtlas::allocate(int width, int height, int& pageIndex, AtlasRect& rect) {
+    if (width > options.pageWidth || height > options.pageHeight) return false;
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (pages[i].packer.insert(width, height, rect)) {
+            pageIndex = static_cast<int>(i);
+            pages[i].lastUse = ++useClock;
+            return true;
+        }
+    }
+
+    if (static_cast<int>(pages.size()) < options.maxPages) {
+        pages.emplace_back();
+        Page& page = pages.back();
+        page.pixels.assign(static_cast<size_t>(options.pageWidth) * options.pageHeight, 0);
+        page.packer.reset(options.pageWidth, options.pageHeight);
+        page.dirty.push_back(AtlasRect{0, 0, options.pageWidth, options.pageHeight});    // Never uploaded yet
+        pageIndex = static_cast<int>(pages.size()) - 1;
+    } else {
+        auto oldest = std::min_element(pages.begin(), pages.end(),
+                                       [](const Page& a, const Page& b) { return a.lastUse < b.lastUse; });
+        pageIndex = static_cast<int>(oldest - pages.begin());
+        evictPage(pageIndex);
+    }
+
+    pages[pageIndex].lastUse = ++useClock;
+    return pages[pageIndex].packer.insert(width, height, rect);
+}
+
+void GlyphAtlas::evictPage(int pageIndex) {
+    Page& page = pages[pageIndex];
+    for (const Key& key : page.keys) {
+        entries.erase(key);
+    }
+    page.keys.clear();
+    std::fill(page.pixels.begin(), page.pixels.end(), 0);
+    page.packer.reset();
+    page.generation++;
+    stats.pageEvictions++;
+
+    // Everything on the page changed; earlier rectangles are covered by this one
+    page.dirty.clear();
+    page.dirty.push_back(AtlasRect{0, 0, options.pageWidth, options.pageHeight});
+}
+
+void GlyphAtlas::markDirty(Page& page, const AtlasRect& rect) {
+    // Already covered by a whole-page upload (new or emptied page)
+    if (page.dirty.size() == 1 && page.dirty[0].width == options.pageWidth &&
+        page.dirty[0].height == options.pageHeight) {
+        return;
+    }
+    page.dirty.push_back(rect);
+    if (page.dirty.size() <= options.maxDirtyRects) return;
+
+    // Too many small uploads: one covering rectangle is cheaper
+    int x0 = INT_MAX, y0 = INT_MAX, x1 = 0, y1 = 0;
+    for (const AtlasRect& r : page.dirty) {
+        x0 = std::min(x0, r.x);
+        y0 = std::min(y0, r.y);
+        x1 = std::max(x1, r.x + r.width);
+        y1 = std::max(y1, r.y + r.height);
+    }
+    page.dirty.clear();
+    page.dirty.push_back(AtlasRect{x0, y0, x1 - x0, y1 - y0});
+}
+
+bool GlyphAtlas::getPage(int pageIndex, GlyphBitmap& bitmap) {
+    if (pageIndex < 0 || pageIndex >= getPageCount()) return false;
+    bitmap.pixels = pages[pageIndex].pixels.data();
+    bitmap.width = options.pageWidth;
+    bitmap.height = options.pageHeight;
+    bitmap.stride = options.pageWidth;
+    return true;
+}
+
+uint32_t GlyphAtlas::getPageGeneration(int pageIndex) const {
+    if (pageIndex < 0 || pageIndex >= getPageCount()) return 0;
+    return pages[pageIndex].generation;
+}
+
+bool GlyphAtlas::takeDirtyRects(int pageIndex, std::vector<AtlasRect>& rects) {
+    rects.clear();
+    if (pageIndex < 0 || pageIndex >= getPageCount()) return false;
+    rects.swap(pages[pageIndex].dirty);
+    return true;
+}
+
+void GlyphAtlas::clear() {
+    pages.clear();
+    entries.clear();
+    useClock = 0;
+}
+
+GlyphAtlasStats GlyphAtlas::getStats() const {
+    GlyphAtlasStats current = stats;
+    current.entries = entries.size();
+    current.pages = getPageCount();
+    return current;
+}
+
+bool GlyphAtlas::writePageRaw(int pageIndex, const std::string& filename) const {
+    if (pageIndex < 0 || pageIndex >= getPageCount()) return false;
+    std::ofstream raw(filename, std::ios::binary);
+    if (!raw.is_open()) return false;
+    const std::vector<uint8_t>& pixels = pages[pageIndex].pixels;
+    raw.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+    return raw.good();
+}
+
+bool GlyphAtlas::writePagePGM(int pageIndex, const std::string& filename) const {
+    if (pageIndex < 0 || pageIndex >= getPageCount()) return false;
+    GlyphBitmap bitmap;
+    bitmap.pixels = const_cast<uint8_t*>(pages[pageIndex].pixels.data());     // Only read
+    bitmap.width = options.pageWidth;
+    bitmap.height = options.pageHeight;
+    bitmap.stride = options.pageWidth;
+    return writeBitmapPGM(bitmap, filename);
+}
@@ -0,0 +1,152 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "rasterizer.h"
+
+// Pixel rectangle in an atlas page; x/y is the top-left corner
+struct AtlasRect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Skyline bin packer for one page. The skyline is the top edge of everything
+// placed so far, stored as horizontal segments left to right; a rectangle goes
+// where its bottom edge ends up lowest (bottom-left rule), ties going to the
+// narrower segment so wide gaps stay free for wide glyphs. Rectangles are
+// never removed individually - reset() empties the whole page.
+class SkylinePacker {
+private:
+    struct Segment {
+        int x, y, width;
+    };
+
+    std::vector<Segment> skyline;
+    int width = 0;
+    int height = 0;
+    size_t usedArea = 0;
+
+    // Lowest y where a w x h rectangle fits starting at segment index; -1 if it doesn't
+    int fitAt(size_t index, int w, int h) const;
+
+public:
+    SkylinePacker(int width = 0, int height = 0);
+
+    void reset(int newWidth, int newHeight);
+    void reset() { reset(width, height); }
+
+    // Places a w x h rectangle; false if the page has no room for it
+    bool insert(int w, int h, AtlasRect& placed);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    float occupancy() const;    // Fraction of the page covered by placed rectangles
+};
+
+// One glyph at one pixel size in the atlas. The bitmap's top-left corner sits
+// at (pen x + left, baseline - top), as with RasterPlacement; empty glyphs
+// (spaces) have a zero-sized rect and page -1 but are still valid entries.
+struct AtlasEntry {
+    uint16_t glyphIndex = 0;
+    float pixelSize = 0;
+    int page = -1;
+    AtlasRect rect;
+    float u0 = 0, v0 = 0, u1 = 0, v1 = 0;     // rect in normalized page coordinates
+    int left = 0;
+    int top = 0;
+};
+
+struct GlyphAtlasOptions {
+    int pageWidth = 1024;
+    int pageHeight = 1024;
+    int padding = 1;        // Empty pixels between glyphs, so filtered sampling doesn't bleed
+    int maxPages = 4;       // Past this, the least recently used page is emptied and reused
+    size_t maxDirtyRects = 64;  // Per page; more than this collapse into their bounding box
+};
+
+struct GlyphAtlasStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;        // Lookups that had to rasterize
+    uint64_t pageEvictions = 0;
+    size_t entries = 0;
+    int pages = 0;
+};
+
+// Glyph bitmaps packed into fixed-size 8-bit pages, so a compositor draws a
+// page with one texture or one blit instead of a copy per glyph. Glyphs are
+// added on first request (glyph index + pixel size) and rendered straight
+// into their page; each page keeps a list of the rectangles written since the
+// consumer last took it, so uploads only cover what changed. When every page
+// is full, the least recently used one is emptied - its entries disappear and
+// its next dirty list covers the whole page.
+//
+// Outlines come from reader.acquireGlyph, so an attached GlyphCache (and the
+// reader's variation instance) apply. Use one atlas per reader and thread;
+// switching variation instances keeps both locations' glyphs apart.
+class GlyphAtlas {
+private:
+    struct Key {
+        uint64_t glyph;     // Glyph index, plus the variation instance serial in the high half
+        float pixelSize;
+        bool operator==(const Key& other) const { return glyph == other.glyph && pixelSize == other.pixelSize; }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Page {
+        std::vector<uint8_t> pixels;
+        SkylinePacker packer;
+        std::vector<Key> keys;          // Entries living on this page, for eviction
+        std::vector<AtlasRect> dirty;
+        uint64_t lastUse = 0;
+        uint32_t generation = 0;        // Bumped whenever the page is emptied
+    };
+
+    TTFReader& reader;
+    GlyphAtlasOptions options;
+    std::vector<Page> pages;
+    std::unordered_map<Key, AtlasEntry, KeyHash> entries;
+    std::vector<int32_t> scratch;
+    uint64_t useClock = 0;
+    GlyphAtlasStats stats;
+
+    Key makeKey(uint16_t glyphIndex, float pixelSize) const;
+    bool allocate(int width, int height, int& pageIndex, AtlasRect& rect);
+    void evictPage(int pageIndex);
+    void markDirty(Page& page, const AtlasRect& rect);
+
+public:
+    GlyphAtlas(TTFReader& reader, const GlyphAtlasOptions& options = GlyphAtlasOptions());
+
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    // Finds the glyph, or rasterizes and inserts it. False if it can't be
+    // decoded or is larger than a page. A later insertion may evict the
+    // page, so look entries up again each frame rather than keeping them.
+    bool acquire(uint16_t glyphIndex, float pixelSize, AtlasEntry& entry);
+    bool contains(uint16_t glyphIndex, float pixelSize) const;
+
+    int getPageCount() const { return static_cast<int>(pages.size()); }
+    bool getPage(int pageIndex, GlyphBitmap& bitmap);    // View of the page's pixels
+    uint32_t getPageGeneration(int pageIndex) const;
+
+    // Rectangles written since the last call, then forgets them. A new or
+    // emptied page reports a single rectangle covering all of it.
+    bool takeDirtyRects(int pageIndex, std::vector<AtlasRect>& rects);
+
+    void clear();
+    GlyphAtlasStats getStats() const;
+    const GlyphAtlasOptions& getOptions() const { return options; }
+
+    // Raw: pageWidth * pageHeight bytes, rows top to bottom, no header
+    bool writePageRaw(int pageIndex, const std::string& filename) const;
+    bool writePagePGM(int pageIndex, const std::string& filename) const;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include "glyph_bounds.h"
+#include "ttf_reader.h"
+#include "thread_pool.h"
+#include <algorithm>
+
+bool GlyphBoundsTable::build(const FontFace& face, WorkStealingPool* pool, size_t glyphsPerTask) {
+    clear();
+    if (!face.isOpen() || face.getLoca().empty() || !face.glyf()) return false;
+
+    glyf = face.tableData(face.glyf());
+    loca = face.getLoca();
+    size_t count = loca.glyphCount();
+    contourCounts.resize(count);
+    xMins.resize(count);
+    yMins.resize(count);
+    xMaxs.resize(count);
+    yMaxs.resize(count);
+    states.reset(new std::atomic<uint8_t>[count]);
+
+    size_t chunk = std::max<size_t>(glyphsPerTask, 1);
+    if (pool && count > chunk) {
+        for (size_t begin = 0; begin < count; begin += chunk) {
+            size_t end = std::min(count, begin + chunk);
+            pool->submit([this, begin, end](unsigned) { scanRange(begin, end); });
+        }
+        pool->wait();
+    } else {
+        scanRange(0, count);
+    }
+
+    compositeCount = static_cast<size_t>(std::count_if(contourCounts.begin(), contourCounts.end(),
+                                                       [](int16_t contours) { return contours < 0; }));
+    return true;
+}
+
+void GlyphBoundsTable::scanRange(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        states[i].store(UNRESOLVED, std::memory_order_relaxed);
+        uint32_t offset = loca.offset(i);
+        uint32_t next = loca.offset(i + 1);
+
+        // Empty glyphs, and entries that don't leave room for a header, draw nothing
+        if (next < offset || next > glyf.size || next - offset < 10) {
+            contourCounts[i] = 0;
+            xMins[i] = yMins[i] = xMaxs[i] = yMaxs[i] = 0;
+            continue;
+        }
+        contourCounts[i] = glyf.i16(offset);
+        xMins[i] = glyf.i16(offset + 2);
+        yMins[i] = glyf.i16(offset + 4);
+        xMaxs[i] = glyf.i16(offset + 6);
+        yMaxs[i] = glyf.i16(offset + 8);
+    }
+}
+
+void GlyphBoundsTable::clear() {
+    glyf = ByteSpan();
+    loca = LocaTable();
+    contourCounts.clear();
+    xMins.clear();
+    yMins.clear();
+    xMaxs.clear();
+    yMaxs.clear();
+    states.reset();
+    compositeCount = 0;
+}
+
+void GlyphBoundsTable::resolve(uint16_t glyph) const {
+    std::lock_guard<std::mutex> lock(resolveMutex);
+    if (states[glyph].load(std::memory_order_relaxed) < RESOLVED) resolveLocked(glyph, 0);
+}
+
+// Unions the component boxes into the composite's entry. False if it can't
+// (point matching, bad data, a cycle); the entry then keeps its stored box.
+bool GlyphBoundsTable::resolveLocked(uint16_t glyph, int depth) const {
+    uint8_t state = states[glyph].load(std::memory_order_relaxed);
+    if (state >= RESOLVED) return true;
+    if (state == RESOLVING || depth >= MAX_COMPOSITE_DEPTH) return false;   // Cycle, or nested too deep
+    states[glyph].store(RESOLVING, std::memory_order_relaxed);
+
+    ByteSpan data = glyf.subspan(loca.offset(glyph), loca.offset(glyph + 1) - loca.offset(glyph));
+    int32_t x0 = INT32_MAX, y0 = INT32_MAX, x1 = INT32_MIN, y1 = INT32_MIN;
+    bool ok = true;
+    size_t pos = 10;
+    size_t components = 0;
+    uint16_t flags = 0;
+    do {
+        if (!data.contains(pos, 4) || ++components > MAX_COMPOSITE_POINTS) {
+            ok = false;
+            break;
+        }
+        flags = data.u16(pos);
+        uint16_t component = data.u16(pos + 2);
+        pos += 4;
+
+        size_t argBytes = (flags & ARG_1_AND_2_ARE_WORDS) ? 4 : 2;
+        if (!(flags & ARGS_ARE_XY_VALUES) || !data.contains(pos, argBytes) || component >= contourCounts.size()) {
+            ok = false;     // Point matching needs the points themselves
+            break;
+        }
+        float dx, dy;
+        if (flags & ARG_1_AND_2_ARE_WORDS) {
+            dx = data.i16(pos);
+            dy = data.i16(pos + 2);
+        } else {
+            dx = static_cast<int8_t>(data.u8(pos));
+            dy = static_cast<int8_t>(data.u8(pos + 1));
+        }
+        pos += argBytes;
+
+        // Transform: x' = xx*x + yx*y, y' = xy*x + yy*y
+        float xx = 1.0f, xy = 0.0f, yx = 0.0f, yy = 1.0f;
+        size_t transformBytes = (flags & WE_HAVE_A_SCALE) ? 2 : (flags & WE_HAVE_AN_X_AND_Y_SCALE) ? 4 :
+                                (flags & WE_HAVE_A_TWO_BY_TWO) ? 8 : 0;
+        if (!data.contains(pos, transformBytes)) {
+            ok = false;
+            break;
+        }
+        if (flags & WE_HAVE_A_SCALE) {
+            xx = yy = data.i16(pos) / 16384.0f;
+        } else if (flags & WE_HAVE_AN_X_AND_Y_SCALE) {
+            xx = data.i16(pos) / 16384.0f;
+            yy = data.i16(pos + 2) / 16384.0f;
+        } else if (flags & WE_HAVE_A_TWO_BY_TWO) {
+            xx = data.i16(pos) / 16384.0f;
+            xy = data.i16(pos + 2) / 16384.0f;
+            yx = data.i16(pos + 4) / 16384.0f;
+            yy = data.i16(pos + 6) / 16384.0f;
+        }
+        pos += transformBytes;
+
+        if (contourCounts[component] < 0) {
+            if (!resolveLocked(component, depth + 1)) {
+                ok = false;
+                break;
+            }
+            if (states[component].load(std::memory_order_relaxed) == RESOLVED_EMPTY) continue;
+        } else if (contourCounts[component] == 0) {
+            continue;
+        }
+
+        if ((flags & SCALED_COMPONENT_OFFSET) && !(flags & UNSCALED_COMPONENT_OFFSET)) {
+            float sx = xx * dx + yx * dy;
+            float sy = xy * dx + yy * dy;
+            dx = sx;
+            dy = sy;
+        }
+        int16_t offsetX = roundToInt16(dx);
+        int16_t offsetY = roundToInt16(dy);
+
+        // The component box's corners through the transform; exact for
+        // scales, and a box around the rotated outline otherwise
+        const float cornerXs[2] = {static_cast<float>(xMins[component]), static_cast<float>(xMaxs[component])};
+        const float cornerYs[2] = {static_cast<float>(yMins[component]), static_cast<float>(yMaxs[component])};
+        for (float cx : cornerXs) {
+            for (float cy : cornerYs) {
+                int16_t px = roundToInt16(static_cast<float>(roundToInt16(xx * cx + yx * cy)) + offsetX);
+                int16_t py = roundToInt16(static_cast<float>(roundToInt16(xy * cx + yy * cy)) + offsetY);
+                x0 = std::min<int32_t>(x0, px);
+                y0 = std::min<int32_t>(y0, py);
+                x1 = std::max<int32_t>(x1, px);
+                y1 = std::max<int32_t>(y1, py);
+            }
+        }
+    } while (flags & MORE_COMPONENTS);
+
+    if (!ok) {
+        states[glyph].store(RESOLVED, std::memory_order_release);
+        return false;
+    }
+    if (x0 > x1) {
+        // Every component was empty
+        xMins[glyph] = yMins[glyph] = xMaxs[glyph] = yMaxs[glyph] = 0;
+        states[glyph].store(RESOLVED_EMPTY, std::memory_order_release);
+        return true;
+    }
+    xMins[glyph] = static_cast<int16_t>(x0);
+    yMins[glyph] = static_cast<int16_t>(y0);
+    xMaxs[glyph] = static_cast<int16_t>(x1);
+    yMaxs[glyph] = static_cast<int16_t>(y1);
+    states[glyph].store(RESOLVED, std::memory_order_release);
+    return true;
+}
+
+bool GlyphBoundsTable::isEmpty(uint16_t glyph) const {
+    if (glyph >= contourCounts.size()) return true;
+    if (contourCounts[glyph] >= 0) return contourCounts[glyph] == 0;
+    GlyphHeader header;
+    getBounds(glyph, header);
+    return states[glyph].load(std::memory_order_acquire) == RESOLVED_EMPTY;
+}
+
+void GlyphBoundsTable::resolveComposites() {
+    for (size_t i = 0; i < contourCounts.size(); i++) {
+        if (contourCounts[i] < 0 && states[i].load(std::memory_order_acquire) < RESOLVED) {
+            resolve(static_cast<uint16_t>(i));
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef GLYPH_BOUNDS_H
+#define GLYPH_BOUNDS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "font_face.h"
+#include "glyph_outline.h"
+
+class WorkStealingPool;
+
+// Every glyph's contour count and bounding box, read from the 10-byte 'glyf'
+// headers alone - no flags, points or components are decoded - and kept as
+// one int16_t array per field, so measuring text touches a few cache lines
+// per glyph instead of its outline.
+//
+// Composite boxes are resolved on first use from the component records and
+// the components' own boxes (transformed corners, then the offset), so they
+// match what the decoder assembles even when a font tool left the stored
+// header stale. Components placed by point matching would need the points;
+// those composites keep their stored box, as do malformed or cyclic ones.
+// Boxes are for the default instance of a variable font.
+//
+// Queries are thread-safe; composites resolve under a lock the first time.
+// The face must stay open while the table is used.
+class GlyphBoundsTable {
+private:
+    enum : uint8_t { UNRESOLVED, RESOLVING, RESOLVED, RESOLVED_EMPTY };
+
+    ByteSpan glyf;
+    LocaTable loca;
+    std::vector<int16_t> contourCounts;     // As stored: -1 for composites, 0 for empty glyphs
+    mutable std::vector<int16_t> xMins, yMins, xMaxs, yMaxs;   // Composites filled in as they resolve
+    std::unique_ptr<std::atomic<uint8_t>[]> states;            // Resolution state per glyph (composites only)
+    mutable std::mutex resolveMutex;
+    size_t compositeCount = 0;
+
+    void scanRange(size_t begin, size_t end);
+    bool resolveLocked(uint16_t glyph, int depth) const;
+    void resolve(uint16_t glyph) const;
+
+public:
+    GlyphBoundsTable() = default;
+
+    GlyphBoundsTable(const GlyphBoundsTable&) = delete;
+    GlyphBoundsTable& operator=(const GlyphBoundsTable&) = delete;
+
+    // Scans every header, spread over pool in chunks of glyphsPerTask if one
+    // is given. Don't pass a pool from inside one of that pool's tasks.
+    bool build(const FontFace& face, WorkStealingPool* pool = nullptr, size_t glyphsPerTask = 4096);
+    void clear();
+
+    size_t glyphCount() const { return contourCounts.size(); }
+    size_t getCompositeCount() const { return compositeCount; }
+
+    // Contour count as stored (-1 for a composite) and the glyph's box; an
+    // empty glyph is all zero. False past the last glyph.
+    bool getBounds(uint16_t glyph, GlyphHeader& header) const {
+        if (glyph >= contourCounts.size()) return false;
+        if (contourCounts[glyph] < 0 && states[glyph].load(std::memory_order_acquire) < RESOLVED) resolve(glyph);
+        header.numberOfContours = contourCounts[glyph];
+        header.xMin = xMins[glyph];
+        header.yMin = yMins[glyph];
+        header.xMax = xMaxs[glyph];
+        header.yMax = yMaxs[glyph];
+        return true;
+    }
+
+    // True if the glyph draws nothing (empty, or a composite of empty parts)
+    bool isEmpty(uint16_t glyph) const;
+
+    // Resolves every composite now, e.g. before reading the arrays directly
+    void resolveComposites();
+
+    // Whole columns, glyphCount() entries each. Composites hold their stored
+    // box until resolved (getBounds or resolveComposites).
+    const std::vector<int16_t>& getContourCounts() const { return contourCounts; }
+    const std::vector<int16_t>& getXMins() const { return xMins; }
+    const std::vector<int16_t>& getYMins() const { return yMins; }
+    const std::vector<int16_t>& getXMaxs() const { return xMaxs; }
+    const std::vector<int16_t>& getYMaxs() const { return yMaxs; }
+};
+
+#endif
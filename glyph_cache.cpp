@@ -0,0 +1,92 @@
+#include "glyph_cache.h"
+
+GlyphCache::GlyphCache(size_t memoryBudgetBytes, size_t shardCount) {
+    if (shardCount == 0) shardCount = 1;
+    memoryBudget = memoryBudgetBytes;
+    shardBudget = memoryBudgetBytes / shardCount;
+
+    shards.reserve(shardCount);
+    for (size_t i = 0; i < shardCount; i++) {
+        shards.push_back(std::unique_ptr<Shard>(new Shard()));
+    }
+}
+
+size_t GlyphCache::glyphFootprint(const StoredOutline& glyph) {
+    // Outline storage plus shared_ptr control block, map node and list node
+    const size_t bookkeeping = 96;
+    return sizeof(StoredOutline) + bookkeeping + glyph.getStorageBytes();
+}
+
+GlyphHandle GlyphCache::find(GlyphKey key) {
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
+        shard.misses++;
+        return nullptr;
+    }
+
+    shard.hits++;
+    // Move to the front; splice doesn't invalidate the stored iterator
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruPosition);
+    return it->second.glyph;
+}
+
+GlyphHandle GlyphCache::insert(GlyphKey key, const GlyphOutline& glyph) {
+    // Build the handle outside the lock - it's the only allocation-heavy part
+    GlyphHandle handle = std::make_shared<const StoredOutline>(glyph);
+    size_t bytes = glyphFootprint(*handle);
+
+    Shard& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    auto it = shard.entries.find(key);
+    if (it != shard.entries.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lruPosition);
+        return it->second.glyph;
+    }
+
+    shard.lru.push_front(key);
+    shard.entries.emplace(key, Entry{handle, bytes, shard.lru.begin()});
+    shard.bytes += bytes;
+    shard.insertions++;
+
+    evictToBudget(shard);
+    return handle;
+}
+
+void GlyphCache::evictToBudget(Shard& shard) {
+    // Always keep the newest entry, even if it alone is over budget
+    while (shard.bytes > shardBudget && shard.lru.size() > 1) {
+        GlyphKey victim = shard.lru.back();
+        auto it = shard.entries.find(victim);
+        shard.bytes -= it->second.bytes;
+        shard.entries.erase(it);
+        shard.lru.pop_back();
+        shard.evictions++;
+    }
+}
+
+void GlyphCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->entries.clear();
+        shard->lru.clear();
+        shard->bytes = 0;
+    }
+}
+
+GlyphCacheStats GlyphCache::getStats() const {
+    GlyphCacheStats stats;
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        stats.hits += shard->hits;
+        stats.misses += shard->misses;
+        stats.insertions += shard->insertions;
+        stats.evictions += shard->evictions;
+        stats.entries += shard->entries.size();
+        stats.bytes += shard->bytes;
+    }
+    return stats;
+}
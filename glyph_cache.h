@@ -0,0 +1,85 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "ttf_reader.h"
+
+// Decoded outlines are handed out as immutable shared handles; a glyph stays
+// alive while anyone holds one, even after the cache evicts it.
+typedef std::shared_ptr<const StoredOutline> GlyphHandle;
+
+// Cache key: the glyph index, plus the serial of the variation instance it
+// was decoded at in the high half (0 for the default outlines)
+typedef uint64_t GlyphKey;
+
+inline GlyphKey glyphCacheKey(uint32_t glyphIndex, uint32_t instanceSerial = 0) {
+    return (static_cast<uint64_t>(instanceSerial) << 32) | glyphIndex;
+}
+
+struct GlyphCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;       // Estimated footprint of cached outlines
+};
+
+// Bounded cache of decoded glyph outlines keyed by glyph index and variation
+// instance (one cache per font). Split into independently locked shards so concurrent lookups of
+// different glyphs rarely contend; each shard evicts least-recently-used
+// entries to stay within its share of the memory budget.
+class GlyphCache {
+private:
+    struct Entry {
+        GlyphHandle glyph;
+        size_t bytes;
+        std::list<GlyphKey>::iterator lruPosition;
+    };
+
+    // Own cache line per shard so neighbouring locks don't false-share
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::list<GlyphKey> lru;                    // Front = most recently used
+        std::unordered_map<GlyphKey, Entry> entries;
+        size_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t insertions = 0;
+        uint64_t evictions = 0;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t memoryBudget;
+    size_t shardBudget;
+
+    // Folded so every instance of a glyph doesn't land in the same shard
+    Shard& shardFor(GlyphKey key) { return *shards[(key ^ (key >> 32)) % shards.size()]; }
+    void evictToBudget(Shard& shard);
+
+public:
+    explicit GlyphCache(size_t memoryBudgetBytes = 8 * 1024 * 1024, size_t shardCount = 16);
+
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    // Returns the cached outline (and marks it recently used), or nullptr
+    GlyphHandle find(GlyphKey key);
+
+    // Copies a decoded outline into one owned block and adds it. If another
+    // thread cached the same glyph first, that copy wins and is returned instead.
+    GlyphHandle insert(GlyphKey key, const GlyphOutline& glyph);
+
+    void clear();
+    GlyphCacheStats getStats() const;
+    size_t getMemoryBudget() const { return memoryBudget; }
+
+    // Approximate bytes one cached outline costs, including bookkeeping
+    static size_t glyphFootprint(const StoredOutline& glyph);
+};
+
+#endif
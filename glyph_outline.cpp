@@ -0,0 +1,127 @@
+#include "glyph_outline.h"
+#include <algorithm>
+#include <cstring>
+
+OutlineArena::OutlineArena(size_t blockSize) : blockSize(blockSize > 0 ? blockSize : 1) {
+}
+
+void* OutlineArena::allocate(size_t bytes, size_t alignment) {
+    if (bytes == 0) bytes = 1;  // Distinct, non-null pointers for empty arrays
+
+    // Alignment is relative to the block start; blocks come from new[] so
+    // they're aligned for any fundamental type
+    if (current < blocks.size()) {
+        size_t offset = (used + alignment - 1) & ~(alignment - 1);
+        if (offset + bytes <= blocks[current].size) {
+            used = offset + bytes;
+            return blocks[current].data.get() + offset;
+        }
+    }
+
+    // Move on to the next kept block if it's big enough, otherwise add one there
+    size_t next = blocks.empty() ? 0 : current + 1;
+    if (next >= blocks.size() || blocks[next].size < bytes) {
+        Block block;
+        block.size = std::max(blockSize, bytes);
+        block.data.reset(new uint8_t[block.size]);
+        blocks.insert(blocks.begin() + next, std::move(block));
+    }
+    current = next;
+    used = bytes;
+    return blocks[current].data.get();
+}
+
+void OutlineArena::rewind(const Marker& marker) {
+    if (marker.block > current || (marker.block == current && marker.used > used)) return; // Not behind us
+    current = marker.block;
+    used = marker.used;
+}
+
+size_t OutlineArena::bytesReserved() const {
+    size_t total = 0;
+    for (const Block& block : blocks) total += block.size;
+    return total;
+}
+
+size_t outlineStorageBytes(uint32_t pointCount, uint16_t contourCount) {
+    return static_cast<size_t>(contourCount) * sizeof(uint16_t) +
+           static_cast<size_t>(pointCount) * 2 * sizeof(int16_t) +
+           (pointCount + 7) / 8;
+}
+
+OutlineArrays allocateOutline(OutlineArena& arena, uint32_t pointCount, uint16_t contourCount,
+                              GlyphOutline& outline) {
+    OutlineArrays arrays;
+    arrays.endPts = arena.allocateArray<uint16_t>(contourCount);
+    arrays.xs = arena.allocateArray<int16_t>(pointCount);
+    arrays.ys = arena.allocateArray<int16_t>(pointCount);
+    arrays.onCurveBits = arena.allocateArray<uint8_t>((pointCount + 7) / 8);
+    std::memset(arrays.onCurveBits, 0, (pointCount + 7) / 8);
+
+    outline.contourCount = contourCount;
+    outline.pointCount = pointCount;
+    outline.endPts = arrays.endPts;
+    outline.xs = arrays.xs;
+    outline.ys = arrays.ys;
+    outline.onCurveBits = arrays.onCurveBits;
+    return arrays;
+}
+
+bool outlineFromGlyph(const SimpleGlyph& glyph, OutlineArena& arena, GlyphOutline& outline) {
+    if (glyph.points.size() > UINT32_MAX || glyph.endPtsOfContours.size() > UINT16_MAX) return false;
+
+    uint32_t pointCount = static_cast<uint32_t>(glyph.points.size());
+    uint16_t contourCount = static_cast<uint16_t>(glyph.endPtsOfContours.size());
+    OutlineArrays arrays = allocateOutline(arena, pointCount, contourCount, outline);
+    outline.header = glyph.header;
+
+    std::copy(glyph.endPtsOfContours.begin(), glyph.endPtsOfContours.end(), arrays.endPts);
+    for (uint32_t i = 0; i < pointCount; i++) {
+        const Point& p = glyph.points[i];
+        arrays.xs[i] = p.x;
+        arrays.ys[i] = p.y;
+        arrays.onCurveBits[i >> 3] |= static_cast<uint8_t>(p.onCurve) << (i & 7);
+    }
+    return true;
+}
+
+void glyphFromOutline(const GlyphOutline& outline, SimpleGlyph& glyph) {
+    glyph.header = outline.header;
+    glyph.endPtsOfContours.assign(outline.endPts, outline.endPts + outline.contourCount);
+    glyph.points.resize(outline.pointCount);
+    for (uint32_t i = 0; i < outline.pointCount; i++) {
+        glyph.points[i].x = outline.xs[i];
+        glyph.points[i].y = outline.ys[i];
+        glyph.points[i].onCurve = outline.onCurve(i);
+    }
+}
+
+StoredOutline::StoredOutline(const GlyphOutline& source) {
+    header = source.header;
+    contourCount = source.contourCount;
+    pointCount = source.pointCount;
+    storageBytes = outlineStorageBytes(pointCount, contourCount);
+    storage.reset(new uint8_t[storageBytes > 0 ? storageBytes : 1]);
+
+    // 16-bit arrays first so everything stays aligned, then the bitset
+    uint8_t* cursor = storage.get();
+    uint16_t* endPtsCopy = reinterpret_cast<uint16_t*>(cursor);
+    cursor += contourCount * sizeof(uint16_t);
+    int16_t* xsCopy = reinterpret_cast<int16_t*>(cursor);
+    cursor += pointCount * sizeof(int16_t);
+    int16_t* ysCopy = reinterpret_cast<int16_t*>(cursor);
+    cursor += pointCount * sizeof(int16_t);
+    uint8_t* bitsCopy = cursor;
+
+    if (contourCount) std::memcpy(endPtsCopy, source.endPts, contourCount * sizeof(uint16_t));
+    if (pointCount) {
+        std::memcpy(xsCopy, source.xs, pointCount * sizeof(int16_t));
+        std::memcpy(ysCopy, source.ys, pointCount * sizeof(int16_t));
+        std::memcpy(bitsCopy, source.onCurveBits, (pointCount + 7) / 8);
+    }
+
+    endPts = endPtsCopy;
+    xs = xsCopy;
+    ys = ysCopy;
+    onCurveBits = bitsCopy;
+}
@@ -0,0 +1,135 @@
+#ifndef GLYPH_OUTLINE_H
+#define GLYPH_OUTLINE_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct GlyphHeader {
+    int16_t numberOfContours;
+    int16_t xMin, yMin, xMax, yMax;
+};
+
+struct Point {
+    int16_t x, y;
+    bool onCurve;
+};
+
+// Rounds half away from zero and clamps to the int16_t range. Composite
+// assembly and the bounds table both place points with it, so they agree.
+inline int16_t roundToInt16(float value) {
+    float rounded = std::round(value);
+    if (rounded > 32767.0f) return 32767;
+    if (rounded < -32768.0f) return -32768;
+    return static_cast<int16_t>(rounded);
+}
+
+// Owning, array-of-structs glyph. Used by the sequential read* API and while
+// assembling composites; everything that draws or exports takes GlyphOutline.
+struct SimpleGlyph {
+    GlyphHeader header;
+    std::vector<uint16_t> endPtsOfContours;
+    std::vector<Point> points;
+};
+
+// Bump allocator for decoded outlines. Memory comes in large blocks that are
+// kept across reset(), so decoding a whole font costs a handful of block
+// allocations instead of several vectors per glyph. Not thread-safe - give
+// each thread (or each batch) its own arena.
+class OutlineArena {
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;         // Block being carved
+    size_t used = 0;            // Bytes used in the current block
+    size_t blockSize;
+
+public:
+    // Position to rewind to; allocations made after it are released together
+    struct Marker {
+        size_t block;
+        size_t used;
+    };
+
+    explicit OutlineArena(size_t blockSize = 64 * 1024);
+
+    OutlineArena(const OutlineArena&) = delete;
+    OutlineArena& operator=(const OutlineArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment);
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    Marker mark() const { return Marker{current, used}; }
+    void rewind(const Marker& marker);
+
+    // Releases everything but keeps the blocks for reuse
+    void reset() { current = 0; used = 0; }
+
+    size_t blockCount() const { return blocks.size(); }
+    size_t bytesReserved() const;
+};
+
+// Structure-of-arrays view of a decoded outline: coordinates in separate x/y
+// arrays and on-curve flags packed one bit per point (bit i & 7 of byte i >> 3).
+// The arrays belong to an OutlineArena or a StoredOutline; the view is only
+// valid while its owner is. Composite glyphs are already resolved, so every
+// outline is a flat list of contours.
+struct GlyphOutline {
+    GlyphHeader header = {0, 0, 0, 0, 0};
+    uint16_t contourCount = 0;
+    uint32_t pointCount = 0;
+    const uint16_t* endPts = nullptr;       // Last point index of each contour
+    const int16_t* xs = nullptr;
+    const int16_t* ys = nullptr;
+    const uint8_t* onCurveBits = nullptr;
+
+    bool empty() const { return pointCount == 0; }
+    bool onCurve(size_t i) const { return (onCurveBits[i >> 3] >> (i & 7)) & 1; }
+};
+
+// Bytes of array storage an outline needs (excluding the view itself)
+size_t outlineStorageBytes(uint32_t pointCount, uint16_t contourCount);
+
+// Carves the arrays for an outline out of arena and points outline at them.
+// The returned pointers are the writable versions of the view's arrays.
+struct OutlineArrays {
+    uint16_t* endPts;
+    int16_t* xs;
+    int16_t* ys;
+    uint8_t* onCurveBits;   // Zeroed
+};
+OutlineArrays allocateOutline(OutlineArena& arena, uint32_t pointCount, uint16_t contourCount,
+                              GlyphOutline& outline);
+
+// Conversions between the owning AoS glyph and the SoA view
+bool outlineFromGlyph(const SimpleGlyph& glyph, OutlineArena& arena, GlyphOutline& outline);
+void glyphFromOutline(const GlyphOutline& outline, SimpleGlyph& glyph);
+
+// An outline that owns its arrays in a single heap block, for outlines that
+// outlive any arena (e.g. cache entries). Non-copyable: the view points into
+// the block.
+class StoredOutline : public GlyphOutline {
+private:
+    std::unique_ptr<uint8_t[]> storage;
+    size_t storageBytes = 0;
+
+public:
+    explicit StoredOutline(const GlyphOutline& source);
+
+    StoredOutline(const StoredOutline&) = delete;
+    StoredOutline& operator=(const StoredOutline&) = delete;
+
+    size_t getStorageBytes() const { return storageBytes; }
+};
+
+#endif
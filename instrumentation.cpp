@@ -0,0 +1,176 @@
+#include "instrumentation.h"
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+const char* const COUNTER_NAMES[INSTRUMENTATION_COUNTERS] = {
+    "bytes_read", "seeks", "table_lookups", "simple_glyphs", "composite_glyphs", "empty_glyphs",
+    "points_decoded", "bezier_segments"
+};
+
+const char* const STAGE_NAMES[INSTRUMENTATION_STAGES] = {
+    "open", "loca_load", "glyph_decode", "outline_generation", "export"
+};
+
+#ifdef TTF_INSTRUMENTATION
+
+struct Registry {
+    std::mutex mutex;       // Guards blocks and baseline; never taken on the recording path
+    std::vector<std::unique_ptr<InstrumentationBlock>> blocks;
+    InstrumentationSnapshot baseline;
+};
+
+// Leaked on purpose: threads may still record while static destructors run
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+// Gives the block back when its thread exits, so the next thread reuses it
+struct BlockReleaser {
+    InstrumentationBlock* block = nullptr;
+    ~BlockReleaser() {
+        if (block) block->inUse.store(false, std::memory_order_release);
+    }
+};
+
+thread_local BlockReleaser releaser;
+
+void sumBlocks(Registry& reg, InstrumentationSnapshot& snapshot) {
+    snapshot = InstrumentationSnapshot();
+    snapshot.enabled = true;
+    snapshot.threads = static_cast<unsigned>(reg.blocks.size());
+    for (const auto& block : reg.blocks) {
+        for (int i = 0; i < INSTRUMENTATION_COUNTERS; i++) {
+            snapshot.counters[i] += block->counters[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < INSTRUMENTATION_STAGES; i++) {
+            snapshot.stageCalls[i] += block->stageCalls[i].load(std::memory_order_relaxed);
+            snapshot.stageNanoseconds[i] += block->stageNanoseconds[i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+#endif
+
+void appendFormat(std::string& out, const char* format, const char* name, unsigned long long value) {
+    char line[160];
+    int length = std::snprintf(line, sizeof(line), format, name, value);
+    if (length > 0) out.append(line, static_cast<size_t>(length) < sizeof(line) ? length : sizeof(line) - 1);
+}
+
+void appendFormat(std::string& out, const char* format, const char* name, double value) {
+    char line[160];
+    int length = std::snprintf(line, sizeof(line), format, name, value);
+    if (length > 0) out.append(line, static_cast<size_t>(length) < sizeof(line) ? length : sizeof(line) - 1);
+}
+
+} // namespace
+
+#ifdef TTF_INSTRUMENTATION
+
+InstrumentationBlock* acquireInstrumentationBlock() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    InstrumentationBlock* block = nullptr;
+    for (const auto& candidate : reg.blocks) {
+        bool expected = false;
+        if (candidate->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            block = candidate.get();
+            break;
+        }
+    }
+    if (!block) {
+        reg.blocks.push_back(std::unique_ptr<InstrumentationBlock>(new InstrumentationBlock()));
+        block = reg.blocks.back().get();
+        block->inUse.store(true, std::memory_order_relaxed);
+    }
+    releaser.block = block;
+    return block;
+}
+
+#endif
+
+const char* instrumentationCounterName(InstrumentationCounter counter) {
+    int index = static_cast<int>(counter);
+    return index >= 0 && index < INSTRUMENTATION_COUNTERS ? COUNTER_NAMES[index] : "unknown";
+}
+
+const char* instrumentationStageName(InstrumentationStage stage) {
+    int index = static_cast<int>(stage);
+    return index >= 0 && index < INSTRUMENTATION_STAGES ? STAGE_NAMES[index] : "unknown";
+}
+
+void collectInstrumentation(InstrumentationSnapshot& snapshot) {
+    snapshot = InstrumentationSnapshot();
+#ifdef TTF_INSTRUMENTATION
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    sumBlocks(reg, snapshot);
+
+    // A racing reset can't make a total go backwards past zero
+    for (int i = 0; i < INSTRUMENTATION_COUNTERS; i++) {
+        uint64_t base = reg.baseline.counters[i];
+        snapshot.counters[i] = snapshot.counters[i] > base ? snapshot.counters[i] - base : 0;
+    }
+    for (int i = 0; i < INSTRUMENTATION_STAGES; i++) {
+        uint64_t calls = reg.baseline.stageCalls[i];
+        uint64_t nanos = reg.baseline.stageNanoseconds[i];
+        snapshot.stageCalls[i] = snapshot.stageCalls[i] > calls ? snapshot.stageCalls[i] - calls : 0;
+        snapshot.stageNanoseconds[i] = snapshot.stageNanoseconds[i] > nanos ? snapshot.stageNanoseconds[i] - nanos : 0;
+    }
+#endif
+}
+
+void resetInstrumentation() {
+#ifdef TTF_INSTRUMENTATION
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    sumBlocks(reg, reg.baseline);
+#endif
+}
+
+std::string formatInstrumentationJSON(const InstrumentationSnapshot& snapshot) {
+    std::string out = snapshot.enabled ? "{\n  \"enabled\": true,\n" : "{\n  \"enabled\": false,\n";
+    appendFormat(out, "  \"%s\": %llu,\n  \"counters\": {\n", "threads",
+                 static_cast<unsigned long long>(snapshot.threads));
+    for (int i = 0; i < INSTRUMENTATION_COUNTERS; i++) {
+        appendFormat(out, i + 1 < INSTRUMENTATION_COUNTERS ? "    \"%s\": %llu,\n" : "    \"%s\": %llu\n",
+                     COUNTER_NAMES[i], static_cast<unsigned long long>(snapshot.counters[i]));
+    }
+    out += "  },\n  \"stages\": {\n";
+    for (int i = 0; i < INSTRUMENTATION_STAGES; i++) {
+        appendFormat(out, "    \"%s\": {\"calls\": %llu, ", STAGE_NAMES[i],
+                     static_cast<unsigned long long>(snapshot.stageCalls[i]));
+        appendFormat(out, i + 1 < INSTRUMENTATION_STAGES ? "\"%s\": %.9f},\n" : "\"%s\": %.9f}\n", "seconds",
+                     snapshot.stageNanoseconds[i] * 1e-9);
+    }
+    out += "  }\n}\n";
+    return out;
+}
+
+std::string formatInstrumentationPrometheus(const InstrumentationSnapshot& snapshot) {
+    std::string out;
+    for (int i = 0; i < INSTRUMENTATION_COUNTERS; i++) {
+        out += "# TYPE ttf_reader_";
+        out += COUNTER_NAMES[i];
+        out += "_total counter\n";
+        appendFormat(out, "ttf_reader_%s_total %llu\n", COUNTER_NAMES[i],
+                     static_cast<unsigned long long>(snapshot.counters[i]));
+    }
+    out += "# TYPE ttf_reader_stage_calls_total counter\n";
+    for (int i = 0; i < INSTRUMENTATION_STAGES; i++) {
+        appendFormat(out, "ttf_reader_stage_calls_total{stage=\"%s\"} %llu\n", STAGE_NAMES[i],
+                     static_cast<unsigned long long>(snapshot.stageCalls[i]));
+    }
+    out += "# TYPE ttf_reader_stage_seconds_total counter\n";
+    for (int i = 0; i < INSTRUMENTATION_STAGES; i++) {
+        appendFormat(out, "ttf_reader_stage_seconds_total{stage=\"%s\"} %.9f\n", STAGE_NAMES[i],
+                     snapshot.stageNanoseconds[i] * 1e-9);
+    }
+    return out;
+}
@@ -0,0 +1,140 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstdint>
+#include <string>
+
+// Hot-path counters and stage timers for the reader. Built only with
+// -DTTF_INSTRUMENTATION; otherwise TTF_COUNT / TTF_TIME_STAGE expand to
+// nothing (their arguments aren't even evaluated) and snapshots are all zero.
+//
+// Each thread bumps its own block of counters with plain relaxed stores, so
+// recording never takes a lock or bounces a cache line between cores.
+// collectInstrumentation() sums every thread's block on demand. Blocks of
+// exited threads are handed to the next new thread, so their counts survive.
+
+enum class InstrumentationCounter {
+    BytesRead,          // Font bytes parsed: directory, 'loca', glyph data, raw reads
+    Seeks,              // Jumps to a table or a glyph
+    TableLookups,
+    SimpleGlyphs,       // Top-level glyphs decoded, by kind
+    CompositeGlyphs,
+    EmptyGlyphs,
+    PointsDecoded,      // Including points of composite components
+    BezierSegments,     // Segments emitted by curve generation and flattening
+    Count
+};
+
+enum class InstrumentationStage {
+    Open,
+    LocaLoad,
+    GlyphDecode,
+    OutlineGeneration,
+    Export,
+    Count
+};
+
+const int INSTRUMENTATION_COUNTERS = static_cast<int>(InstrumentationCounter::Count);
+const int INSTRUMENTATION_STAGES = static_cast<int>(InstrumentationStage::Count);
+
+const char* instrumentationCounterName(InstrumentationCounter counter);    // snake_case, e.g. "bytes_read"
+const char* instrumentationStageName(InstrumentationStage stage);
+
+struct InstrumentationSnapshot {
+    bool enabled = false;
+    unsigned threads = 0;                           // Threads that have recorded anything
+    uint64_t counters[INSTRUMENTATION_COUNTERS] = {};
+    uint64_t stageCalls[INSTRUMENTATION_STAGES] = {};
+    uint64_t stageNanoseconds[INSTRUMENTATION_STAGES] = {};   // Wall time inside the stage, all threads
+
+    uint64_t get(InstrumentationCounter counter) const { return counters[static_cast<int>(counter)]; }
+    double stageSeconds(InstrumentationStage stage) const {
+        return stageNanoseconds[static_cast<int>(stage)] * 1e-9;
+    }
+};
+
+constexpr bool instrumentationEnabled() {
+#ifdef TTF_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Totals since start-up or the last reset. Safe to call while other threads
+// record; counts still in flight land in the next snapshot.
+void collectInstrumentation(InstrumentationSnapshot& snapshot);
+
+// Makes later snapshots count from now. Doesn't touch the per-thread blocks -
+// it records a baseline that is subtracted - so it's safe at any time.
+void resetInstrumentation();
+
+std::string formatInstrumentationJSON(const InstrumentationSnapshot& snapshot);
+std::string formatInstrumentationPrometheus(const InstrumentationSnapshot& snapshot);   // Text exposition format
+
+#ifdef TTF_INSTRUMENTATION
+
+#include <atomic>
+#include <chrono>
+
+struct alignas(64) InstrumentationBlock {
+    std::atomic<uint64_t> counters[INSTRUMENTATION_COUNTERS] = {};
+    std::atomic<uint64_t> stageCalls[INSTRUMENTATION_STAGES] = {};
+    std::atomic<uint64_t> stageNanoseconds[INSTRUMENTATION_STAGES] = {};
+    std::atomic<bool> inUse{false};
+};
+
+InstrumentationBlock* acquireInstrumentationBlock();   // The calling thread's block, registered on first use
+
+inline InstrumentationBlock& localInstrumentationBlock() {
+    static thread_local InstrumentationBlock* block = nullptr;
+    if (!block) block = acquireInstrumentationBlock();
+    return *block;
+}
+
+// Only the owning thread writes its block, so load + store is enough
+inline void bumpInstrumentation(std::atomic<uint64_t>& value, uint64_t amount) {
+    value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+inline void countInstrumentation(InstrumentationCounter counter, uint64_t amount) {
+    bumpInstrumentation(localInstrumentationBlock().counters[static_cast<int>(counter)], amount);
+}
+
+class InstrumentationStageTimer {
+private:
+    int stage;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit InstrumentationStageTimer(InstrumentationStage stage)
+        : stage(static_cast<int>(stage)), start(std::chrono::steady_clock::now()) {}
+    ~InstrumentationStageTimer() {
+        uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        InstrumentationBlock& block = localInstrumentationBlock();
+        bumpInstrumentation(block.stageCalls[stage], 1);
+        bumpInstrumentation(block.stageNanoseconds[stage], elapsed);
+    }
+
+    InstrumentationStageTimer(const InstrumentationStageTimer&) = delete;
+    InstrumentationStageTimer& operator=(const InstrumentationStageTimer&) = delete;
+};
+
+#define TTF_INSTRUMENTATION_CONCAT2(a, b) a##b
+#define TTF_INSTRUMENTATION_CONCAT(a, b) TTF_INSTRUMENTATION_CONCAT2(a, b)
+
+// TTF_COUNT(BytesRead, n) adds n to a counter; TTF_TIME_STAGE(Open) times the rest of the scope
+#define TTF_COUNT(counter, amount) \
+    countInstrumentation(InstrumentationCounter::counter, static_cast<uint64_t>(amount))
+#define TTF_TIME_STAGE(stage) \
+    InstrumentationStageTimer TTF_INSTRUMENTATION_CONCAT(stageTimer, __LINE__)(InstrumentationStage::stage)
+
+#else
+
+#define TTF_COUNT(counter, amount) ((void)0)
+#define TTF_TIME_STAGE(stage) ((void)0)
+
+#endif
+
+#endif
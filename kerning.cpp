@@ -0,0 +1,408 @@
+#include "kerning.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+const uint32_t TAG_KERN_FEATURE = makeTag('k', 'e', 'r', 'n');
+
+const uint16_t GPOS_PAIR_ADJUSTMENT = 2;
+const uint16_t GPOS_EXTENSION = 9;
+
+// 'kern' subtable coverage bits
+const uint16_t KERN_HORIZONTAL = 0x0001;
+const uint16_t KERN_MINIMUM = 0x0002;
+const uint16_t KERN_CROSS_STREAM = 0x0004;
+const uint16_t KERN_OVERRIDE = 0x0008;
+
+uint32_t pairKey(uint16_t left, uint16_t right) {
+    return (static_cast<uint32_t>(left) << 16) | right;
+}
+
+int popCount(uint16_t bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+}
+
+// ValueRecord size in bytes; only the low 8 bits name fields
+size_t valueRecordSize(uint16_t valueFormat) {
+    return static_cast<size_t>(popCount(valueFormat & 0xFF)) * 2;
+}
+
+// XAdvance of a ValueRecord at offset, 0 if the format doesn't have one
+int16_t valueXAdvance(ByteSpan table, size_t offset, uint16_t valueFormat) {
+    if (!(valueFormat & 0x0004)) return 0;
+    return table.i16(offset + static_cast<size_t>(popCount(valueFormat & 0x0003)) * 2);
+}
+
+// Table at offset within a parent, running to the parent's end (offsets
+// only say where a table starts); empty if the offset is out of range
+ByteSpan tableAt(ByteSpan parent, size_t offset) {
+    if (offset >= parent.size) return ByteSpan();
+    return parent.subspan(offset, parent.size - offset);
+}
+
+// Calls visit(glyph, coverageIndex) for every glyph of a Coverage table
+template <typename Visit>
+bool forEachCovered(ByteSpan coverage, Visit visit) {
+    uint16_t format, count;
+    if (!coverage.readU16(0, format) || !coverage.readU16(2, count)) return false;
+
+    if (format == 1) {
+        if (!coverage.contains(4, static_cast<size_t>(count) * 2)) return false;
+        for (uint16_t i = 0; i < count; i++) {
+            visit(coverage.u16(4 + static_cast<size_t>(i) * 2), i);
+        }
+        return true;
+    }
+    if (format == 2) {
+        if (!coverage.contains(4, static_cast<size_t>(count) * 6)) return false;
+        for (uint16_t i = 0; i < count; i++) {
+            size_t record = 4 + static_cast<size_t>(i) * 6;
+            uint16_t start = coverage.u16(record);
+            uint16_t end = coverage.u16(record + 2);
+            uint16_t startIndex = coverage.u16(record + 4);
+            for (uint32_t glyph = start; glyph <= end; glyph++) {
+                visit(static_cast<uint16_t>(glyph), static_cast<uint32_t>(startIndex) + (glyph - start));
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// ClassDef table expanded to one class per glyph; unlisted glyphs are class 0
+bool expandClassDef(ByteSpan classDef, uint16_t numGlyphs, std::vector<uint16_t>& classes) {
+    classes.assign(numGlyphs, 0);
+    uint16_t format;
+    if (!classDef.readU16(0, format)) return false;
+
+    if (format == 1) {
+        uint16_t start, count;
+        if (!classDef.readU16(2, start) || !classDef.readU16(4, count)) return false;
+        if (!classDef.contains(6, static_cast<size_t>(count) * 2)) return false;
+        for (uint32_t i = 0; i < count && start + i < numGlyphs; i++) {
+            classes[start + i] = classDef.u16(6 + i * 2);
+        }
+        return true;
+    }
+    if (format == 2) {
+        uint16_t count;
+        if (!classDef.readU16(2, count)) return false;
+        if (!classDef.contains(4, static_cast<size_t>(count) * 6)) return false;
+        for (uint16_t i = 0; i < count; i++) {
+            size_t record = 4 + static_cast<size_t>(i) * 6;
+            uint32_t start = classDef.u16(record);
+            uint32_t end = std::min<uint32_t>(classDef.u16(record + 2), numGlyphs ? numGlyphs - 1u : 0u);
+            uint16_t value = classDef.u16(record + 4);
+            for (uint32_t glyph = start; glyph <= end && glyph < numGlyphs; glyph++) {
+                classes[glyph] = value;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// Type 2 subtable behind an Extension (type 9) wrapper, or the subtable itself
+ByteSpan resolveSubtable(ByteSpan subtable, uint16_t lookupType) {
+    if (lookupType != GPOS_EXTENSION) return subtable;
+    uint16_t format, extensionType;
+    uint32_t offset;
+    if (!subtable.readU16(0, format) || format != 1) return ByteSpan();
+    if (!subtable.readU16(2, extensionType) || extensionType != GPOS_PAIR_ADJUSTMENT) return ByteSpan();
+    if (!subtable.readU32(4, offset)) return ByteSpan();
+    return tableAt(subtable, offset);
+}
+
+} // namespace
+
+bool KerningTable::build(ByteSpan gpos, ByteSpan kern, uint16_t glyphCount) {
+    clear();
+    numGlyphs = glyphCount;
+
+    std::vector<std::pair<uint32_t, int32_t>> pairs;
+    if (!gpos.empty() && parseGpos(gpos, pairs)) {
+        source = static_cast<int>(TAG_GPOS);
+    } else {
+        classSubtables.clear();
+        pairs.clear();
+        if (!kern.empty() && parseKern(kern, pairs)) source = static_cast<int>(TAG_KERN);
+    }
+
+    buildHash(pairs);
+    if (empty()) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+void KerningTable::clear() {
+    slots.clear();
+    slotShift = 32;
+    pairCount = 0;
+    classSubtables.clear();
+    numGlyphs = 0;
+    source = 0;
+}
+
+void KerningTable::buildHash(std::vector<std::pair<uint32_t, int32_t>>& pairs) {
+    // Merge repeats (adding), and drop pairs that end up with nothing to add
+    std::sort(pairs.begin(), pairs.end(),
+              [](const std::pair<uint32_t, int32_t>& a, const std::pair<uint32_t, int32_t>& b) {
+                  return a.first < b.first;
+              });
+    size_t kept = 0;
+    for (size_t i = 0; i < pairs.size();) {
+        uint32_t key = pairs[i].first;
+        int32_t value = 0;
+        for (; i < pairs.size() && pairs[i].first == key; i++) value += pairs[i].second;
+        if (value != 0) pairs[kept++] = std::make_pair(key, value);
+    }
+    pairs.resize(kept);
+
+    pairCount = pairs.size();
+    if (pairCount == 0) return;
+
+    // At most half full, so a miss usually stops at the first or second slot
+    size_t capacity = 2;
+    slotShift = 31;
+    while (capacity < pairCount * 2) {
+        capacity <<= 1;
+        slotShift--;
+    }
+    slots.assign(capacity, PairSlot{EMPTY_KEY, 0});
+    size_t mask = capacity - 1;
+    for (const auto& pair : pairs) {
+        size_t slot = slotFor(pair.first);
+        while (slots[slot].key != EMPTY_KEY) slot = (slot + 1) & mask;
+        slots[slot] = PairSlot{pair.first, pair.second};
+    }
+}
+
+bool KerningTable::parseKern(ByteSpan kern, std::vector<std::pair<uint32_t, int32_t>>& pairs) {
+    // Version 0 (OpenType); Apple's version 1 starts with a 32-bit 1.0
+    uint16_t version, tableCount;
+    if (!kern.readU16(0, version) || version != 0) return false;
+    if (!kern.readU16(2, tableCount)) return false;
+
+    std::unordered_map<uint32_t, int32_t> values;
+    size_t start = 4;
+    for (uint16_t t = 0; t < tableCount; t++) {
+        uint16_t length, coverage, pairTotal;
+        if (!kern.readU16(start + 2, length) || !kern.readU16(start + 4, coverage)) break;
+        size_t next = start + std::max<size_t>(length, 6);
+
+        // Format 0 horizontal kerning only
+        bool usable = (coverage >> 8) == 0 &&
+                      (coverage & (KERN_HORIZONTAL | KERN_MINIMUM | KERN_CROSS_STREAM)) == KERN_HORIZONTAL;
+        if (!usable || !kern.readU16(start + 6, pairTotal)) {
+            start = next;
+            continue;
+        }
+
+        // 'length' is 16 bits and overflows in big subtables; nPairs is what counts
+        size_t recordBytes = static_cast<size_t>(pairTotal) * 6;
+        ByteSpan records = kern.subspan(start + 14, recordBytes);
+        next = std::max(next, start + 14 + recordBytes);
+        start = next;
+        if (records.empty()) continue;
+
+        bool replace = (coverage & KERN_OVERRIDE) != 0;
+        for (uint16_t i = 0; i < pairTotal; i++) {
+            size_t record = static_cast<size_t>(i) * 6;
+            uint32_t key = pairKey(records.u16(record), records.u16(record + 2));
+            int16_t value = records.i16(record + 4);
+            if (replace) {
+                values[key] = value;
+            } else {
+                values[key] += value;
+            }
+        }
+    }
+
+    pairs.reserve(values.size());
+    for (const auto& value : values) pairs.push_back(value);
+    return !pairs.empty();
+}
+
+bool KerningTable::parseGpos(ByteSpan gpos, std::vector<std::pair<uint32_t, int32_t>>& pairs) {
+    uint16_t majorVersion, featureListOffset, lookupListOffset;
+    if (!gpos.readU16(0, majorVersion) || majorVersion != 1) return false;
+    if (!gpos.readU16(6, featureListOffset) || !gpos.readU16(8, lookupListOffset)) return false;
+
+    // Lookups of every 'kern' feature, in lookup list order. Script and
+    // language systems aren't consulted; kerning fonts list the same lookups
+    // under each of them.
+    ByteSpan featureList = tableAt(gpos, featureListOffset);
+    ByteSpan lookupList = tableAt(gpos, lookupListOffset);
+    uint16_t featureCount, lookupCount;
+    if (!featureList.readU16(0, featureCount) || !featureList.contains(2, static_cast<size_t>(featureCount) * 6)) {
+        return false;
+    }
+    if (!lookupList.readU16(0, lookupCount) || !lookupList.contains(2, static_cast<size_t>(lookupCount) * 2)) {
+        return false;
+    }
+
+    std::vector<uint8_t> kernLookups(lookupCount, 0);
+    bool hasKernFeature = false;
+    for (uint16_t f = 0; f < featureCount; f++) {
+        size_t record = 2 + static_cast<size_t>(f) * 6;
+        if (featureList.u32(record) != TAG_KERN_FEATURE) continue;
+        ByteSpan feature = tableAt(featureList, featureList.u16(record + 4));
+        uint16_t indexCount;
+        if (!feature.readU16(2, indexCount) || !feature.contains(4, static_cast<size_t>(indexCount) * 2)) continue;
+        for (uint16_t i = 0; i < indexCount; i++) {
+            uint16_t lookupIndex = feature.u16(4 + static_cast<size_t>(i) * 2);
+            if (lookupIndex < lookupCount) {
+                kernLookups[lookupIndex] = 1;
+                hasKernFeature = true;
+            }
+        }
+    }
+    if (!hasKernFeature) return false;
+
+    // Per lookup: glyphs a class subtable has already claimed as left glyph,
+    // and the specific pairs placed so far - later subtables don't see them
+    std::vector<uint8_t> claimed;
+    std::unordered_map<uint32_t, int32_t> lookupPairs;
+
+    for (uint16_t l = 0; l < lookupCount; l++) {
+        if (!kernLookups[l]) continue;
+        uint16_t lookupOffset = lookupList.u16(2 + static_cast<size_t>(l) * 2);
+        ByteSpan lookup = tableAt(lookupList, lookupOffset);
+        uint16_t lookupType, subtableCount;
+        if (!lookup.readU16(0, lookupType) || !lookup.readU16(4, subtableCount)) continue;
+        if (lookupType != GPOS_PAIR_ADJUSTMENT && lookupType != GPOS_EXTENSION) continue;
+        if (!lookup.contains(6, static_cast<size_t>(subtableCount) * 2)) continue;
+
+        claimed.assign(numGlyphs, 0);
+        lookupPairs.clear();
+        size_t firstClassSubtable = classSubtables.size();
+
+        for (uint16_t s = 0; s < subtableCount; s++) {
+            uint16_t subtableOffset = lookup.u16(6 + static_cast<size_t>(s) * 2);
+            ByteSpan subtable = resolveSubtable(tableAt(lookup, subtableOffset), lookupType);
+
+            uint16_t format, coverageOffset, valueFormat1, valueFormat2;
+            if (!subtable.readU16(0, format) || !subtable.readU16(2, coverageOffset) ||
+                !subtable.readU16(4, valueFormat1) || !subtable.readU16(6, valueFormat2)) {
+                continue;
+            }
+            ByteSpan coverage = tableAt(subtable, coverageOffset);
+            size_t size1 = valueRecordSize(valueFormat1);
+            size_t size2 = valueRecordSize(valueFormat2);
+
+            if (format == 1) {
+                // Pair sets, one per covered left glyph
+                uint16_t pairSetCount;
+                if (!subtable.readU16(8, pairSetCount) || !subtable.contains(10, static_cast<size_t>(pairSetCount) * 2)) {
+                    continue;
+                }
+                size_t recordSize = 2 + size1 + size2;
+                forEachCovered(coverage, [&](uint16_t left, uint32_t index) {
+                    if (index >= pairSetCount) return;
+                    if (left < claimed.size() && claimed[left]) return;
+                    uint16_t setOffset = subtable.u16(10 + static_cast<size_t>(index) * 2);
+                    uint16_t valueCount;
+                    if (!subtable.readU16(setOffset, valueCount)) return;
+                    ByteSpan records = subtable.subspan(setOffset + 2u, static_cast<size_t>(valueCount) * recordSize);
+                    if (records.empty()) return;
+                    for (uint16_t i = 0; i < valueCount; i++) {
+                        size_t record = static_cast<size_t>(i) * recordSize;
+                        uint32_t key = pairKey(left, records.u16(record));
+                        lookupPairs.emplace(key, valueXAdvance(records, record + 2, valueFormat1));  // First wins
+                    }
+                });
+            } else if (format == 2) {
+                // Class pair matrix
+                if (classSubtables.size() >= MAX_CLASS_SUBTABLES) continue;
+                uint16_t classDef1Offset, classDef2Offset, class1Count, class2Count;
+                if (!subtable.readU16(8, classDef1Offset) || !subtable.readU16(10, classDef2Offset) ||
+                    !subtable.readU16(12, class1Count) || !subtable.readU16(14, class2Count)) {
+                    continue;
+                }
+                size_t recordSize = size1 + size2;
+                size_t cellCount = static_cast<size_t>(class1Count) * class2Count;
+                if (class2Count == 0 || !subtable.contains(16, cellCount * recordSize)) continue;
+
+                ClassSubtable table;
+                std::vector<uint16_t> firstClasses;
+                if (!expandClassDef(tableAt(subtable, classDef1Offset), numGlyphs, firstClasses) ||
+                    !expandClassDef(tableAt(subtable, classDef2Offset), numGlyphs, table.secondClasses)) {
+                    continue;
+                }
+
+                // Only covered glyphs take part, and only if no earlier
+                // class subtable of this lookup took them first
+                table.firstClasses.assign(numGlyphs, NOT_COVERED);
+                size_t coveredEnd = 0;
+                forEachCovered(coverage, [&](uint16_t left, uint32_t) {
+                    if (left >= numGlyphs || claimed[left]) return;
+                    if (firstClasses[left] >= class1Count) return;
+                    table.firstClasses[left] = firstClasses[left];
+                    claimed[left] = 1;
+                    coveredEnd = std::max<size_t>(coveredEnd, left + 1u);
+                });
+                if (coveredEnd == 0) continue;
+                table.firstClasses.resize(coveredEnd);     // The query bounds-checks
+
+                table.class2Count = class2Count;
+                table.values.resize(cellCount);
+                for (size_t cell = 0; cell < cellCount; cell++) {
+                    table.values[cell] = (recordSize == 0) ? 0 : valueXAdvance(subtable, 16 + cell * recordSize, valueFormat1);
+                }
+                for (uint16_t& secondClass : table.secondClasses) {
+                    if (secondClass >= class2Count) secondClass = 0;
+                }
+                classSubtables.push_back(std::move(table));
+            }
+        }
+
+        // A specific pair ahead of a class subtable that also covers its left
+        // glyph wins over it, so store it relative to that subtable's value
+        for (const auto& pair : lookupPairs) {
+            uint16_t left = static_cast<uint16_t>(pair.first >> 16);
+            uint16_t right = static_cast<uint16_t>(pair.first);
+            int32_t value = pair.second;
+            for (size_t c = firstClassSubtable; c < classSubtables.size(); c++) {
+                const ClassSubtable& table = classSubtables[c];
+                if (left >= table.firstClasses.size() || table.firstClasses[left] == NOT_COVERED) continue;
+                if (right < table.secondClasses.size()) {
+                    value -= table.values[static_cast<size_t>(table.firstClasses[left]) * table.class2Count +
+                                          table.secondClasses[right]];
+                }
+                break;
+            }
+            pairs.push_back(std::make_pair(pair.first, value));
+        }
+    }
+
+    // Class subtables that add nothing anywhere have done their job (shadowing
+    // and the pair deltas above) and can go
+    classSubtables.erase(std::remove_if(classSubtables.begin(), classSubtables.end(),
+                                        [](const ClassSubtable& table) {
+                                            return std::none_of(table.values.begin(), table.values.end(),
+                                                                [](int16_t v) { return v != 0; });
+                                        }),
+                         classSubtables.end());
+    return true;
+}
+
+int32_t KerningTable::kernRun(const uint16_t* glyphs, size_t count, int32_t* adjustments) const {
+    if (count == 0) return 0;
+    int32_t total = 0;
+    if (empty()) {
+        std::fill(adjustments, adjustments + count, 0);
+        return 0;
+    }
+    for (size_t i = 0; i + 1 < count; i++) {
+        int32_t value = pairValue(glyphs[i], glyphs[i + 1]);
+        adjustments[i] = value;
+        total += value;
+    }
+    adjustments[count - 1] = 0;
+    return total;
+}
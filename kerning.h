@@ -0,0 +1,93 @@
+#ifndef KERNING_H
+#define KERNING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "font_face.h"
+
+const uint32_t TAG_KERN = makeTag('k', 'e', 'r', 'n');
+const uint32_t TAG_GPOS = makeTag('G', 'P', 'O', 'S');
+
+// Horizontal pair kerning compiled from GPOS 'kern' feature lookups (type 2,
+// PairPos, including through type 9 extensions) or, for fonts without them,
+// the legacy 'kern' table (format 0).
+//
+// Glyph-pair records go into one open-addressing hash keyed by
+// (left << 16 | right), so a specific pair costs one probe. Class-based
+// subtables stay as dense tables: per-glyph class arrays plus a
+// class1 x class2 value matrix, so they cost three array loads each. GPOS
+// precedence (the first subtable of a lookup that covers the left glyph
+// wins) is resolved while compiling, and a pair's hash entry holds its
+// difference from the class value, so a query is the hash probe plus the
+// class lookups, summed. Immutable after build(); safe to share.
+class KerningTable {
+private:
+    struct PairSlot {
+        uint32_t key;       // EMPTY_KEY if unused; glyph ids stop at 0xFFFE, so it never collides
+        int32_t value;
+    };
+    static constexpr uint32_t EMPTY_KEY = 0xFFFFFFFF;
+
+    struct ClassSubtable {
+        std::vector<uint16_t> firstClasses;     // Per glyph; NOT_COVERED if this subtable doesn't apply
+        std::vector<uint16_t> secondClasses;    // Per glyph; unlisted glyphs are class 0
+        std::vector<int16_t> values;            // class1Count x class2Count
+        uint16_t class2Count = 0;
+    };
+    static constexpr uint16_t NOT_COVERED = 0xFFFF;
+    static constexpr size_t MAX_CLASS_SUBTABLES = 1024;    // Each holds two per-glyph arrays
+
+    std::vector<PairSlot> slots;        // Power-of-two size, at most half full
+    uint32_t slotShift = 32;
+    size_t pairCount = 0;
+    std::vector<ClassSubtable> classSubtables;
+    uint16_t numGlyphs = 0;
+    int source = 0;                     // TAG_GPOS, TAG_KERN or 0
+
+    size_t slotFor(uint32_t key) const {
+        return static_cast<size_t>((key * 0x9E3779B1u) >> slotShift);
+    }
+    void buildHash(std::vector<std::pair<uint32_t, int32_t>>& pairs);
+    bool parseKern(ByteSpan kern, std::vector<std::pair<uint32_t, int32_t>>& pairs);
+    bool parseGpos(ByteSpan gpos, std::vector<std::pair<uint32_t, int32_t>>& pairs);
+
+public:
+    KerningTable() = default;
+
+    // GPOS is used if it has 'kern' feature lookups, else 'kern'; either span
+    // may be empty. False if neither yields any kerning.
+    bool build(ByteSpan gpos, ByteSpan kern, uint16_t glyphCount);
+    void clear();
+
+    bool empty() const { return pairCount == 0 && classSubtables.empty(); }
+    uint32_t getSource() const { return static_cast<uint32_t>(source); }   // Table the kerning came from
+    size_t getPairCount() const { return pairCount; }
+    size_t getClassSubtableCount() const { return classSubtables.size(); }
+
+    // Adjustment to the left glyph's advance, in font units
+    int32_t pairValue(uint16_t left, uint16_t right) const {
+        int32_t value = 0;
+        for (const ClassSubtable& table : classSubtables) {
+            if (left >= table.firstClasses.size() || right >= table.secondClasses.size()) continue;
+            uint16_t firstClass = table.firstClasses[left];
+            if (firstClass == NOT_COVERED) continue;
+            value += table.values[static_cast<size_t>(firstClass) * table.class2Count + table.secondClasses[right]];
+        }
+        if (pairCount == 0) return value;
+
+        uint32_t key = (static_cast<uint32_t>(left) << 16) | right;
+        size_t mask = slots.size() - 1;
+        for (size_t slot = slotFor(key);; slot = (slot + 1) & mask) {
+            if (slots[slot].key == key) return value + slots[slot].value;
+            if (slots[slot].key == EMPTY_KEY) return value;
+        }
+    }
+
+    // adjustments[i] = pairValue(glyphs[i], glyphs[i + 1]) for the whole run,
+    // 0 for the last glyph. Returns the sum.
+    int32_t kernRun(const uint16_t* glyphs, size_t count, int32_t* adjustments) const;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#include "loca_table.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LOCA_TABLE_X86 1
+#endif
+
+void widenLocaOffsetsScalar(const uint8_t* data, size_t count, bool longFormat, uint32_t* out) {
+    LocaTable table;
+    table.data = data;
+    table.entries = count;
+    table.longFormat = longFormat;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = table.offset(i);
+    }
+}
+
+#ifdef LOCA_TABLE_X86
+
+// pshufb reverses each entry's bytes into little-endian 32-bit lanes; -1
+// lanes zero-fill the top half of short entries, which are then doubled.
+__attribute__((target("ssse3")))
+static void widenLocaOffsetsSSSE3Impl(const uint8_t* data, size_t count, bool longFormat, uint32_t* out) {
+    size_t i = 0;
+    if (longFormat) {
+        const __m128i swap32 = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        for (; i + 4 <= count; i += 4) {
+            __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 4));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_shuffle_epi8(raw, swap32));
+        }
+    } else {
+        const __m128i lowHalf = _mm_setr_epi8(1, 0, -1, -1, 3, 2, -1, -1, 5, 4, -1, -1, 7, 6, -1, -1);
+        const __m128i highHalf = _mm_setr_epi8(9, 8, -1, -1, 11, 10, -1, -1, 13, 12, -1, -1, 15, 14, -1, -1);
+        for (; i + 8 <= count; i += 8) {
+            __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+            __m128i low = _mm_slli_epi32(_mm_shuffle_epi8(raw, lowHalf), 1);
+            __m128i high = _mm_slli_epi32(_mm_shuffle_epi8(raw, highHalf), 1);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), high);
+        }
+    }
+    size_t entrySize = longFormat ? 4 : 2;
+    widenLocaOffsetsScalar(data + i * entrySize, count - i, longFormat, out + i);
+}
+
+#endif
+
+void widenLocaOffsetsSSSE3(const uint8_t* data, size_t count, bool longFormat, uint32_t* out) {
+#ifdef LOCA_TABLE_X86
+    widenLocaOffsetsSSSE3Impl(data, count, longFormat, out);
+#else
+    widenLocaOffsetsScalar(data, count, longFormat, out);
+#endif
+}
+
+bool locaWideningVectorized() {
+#ifdef LOCA_TABLE_X86
+    // Checked once; the table is widened at most once per reader anyway
+    static const bool haveSSSE3 = __builtin_cpu_supports("ssse3");
+    return haveSSSE3;
+#else
+    return false;
+#endif
+}
+
+void widenLocaOffsets(const uint8_t* data, size_t count, bool longFormat, uint32_t* out) {
+#ifdef LOCA_TABLE_X86
+    if (locaWideningVectorized()) {
+        widenLocaOffsetsSSSE3Impl(data, count, longFormat, out);
+        return;
+    }
+#endif
+    widenLocaOffsetsScalar(data, count, longFormat, out);
+}
@@ -0,0 +1,49 @@
+#ifndef LOCA_TABLE_H
+#define LOCA_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 'loca' read in place. Entries are big-endian: u16 halved offsets (short
+// format) or u32 byte offsets (long format), one per glyph plus an end
+// marker. offset() decodes a single entry straight from the mapped table, so
+// nothing is read or allocated up front and the first glyph costs O(1).
+//
+// Callers that will touch every glyph can widen the table once into native
+// uint32_t offsets; after that, offset() is a plain array load.
+struct LocaTable {
+    const uint8_t* data = nullptr;      // Raw entries inside the font mapping
+    const uint32_t* widened = nullptr;  // Native byte offsets, if available (not owned)
+    size_t entries = 0;                 // numGlyphs + 1 for a well-formed font
+    bool longFormat = false;
+
+    bool empty() const { return entries == 0; }
+    size_t glyphCount() const { return entries ? entries - 1 : 0; }
+
+    // Byte offset into 'glyf'; i must be < entries
+    uint32_t offset(size_t i) const {
+        if (widened) return widened[i];
+        if (longFormat) {
+            const uint8_t* p = data + i * 4;
+            return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+                   (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+        }
+        const uint8_t* p = data + i * 2;
+        return ((static_cast<uint32_t>(p[0]) << 8) | p[1]) * 2u;
+    }
+};
+
+// Converts count raw entries to native byte offsets (short entries doubled).
+// Uses the SSSE3 kernel when the CPU has it; all versions give identical output.
+void widenLocaOffsets(const uint8_t* data, size_t count, bool longFormat, uint32_t* out);
+
+// Direct entry points. The SSSE3 one byte-swaps 16 bytes per shuffle (four
+// long or eight short entries) and falls back to scalar on non-x86 builds.
+void widenLocaOffsetsScalar(const uint8_t* data, size_t count, bool longFormat, uint32_t* out);
+void widenLocaOffsetsSSSE3(const uint8_t* data, size_t count, bool longFormat, uint32_t* out);
+
+// True if widenLocaOffsetsSSSE3 runs the SSSE3 kernel: an x86 build on a CPU
+// that has it. Otherwise it is the scalar loop.
+bool locaWideningVectorized();
+
+#endif
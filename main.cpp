@@ -1,22 +1,46 @@
 #include "ttf_reader.h"
+#include "ttf_diagnostics.h"
+#include "rasterizer.h"
+#include "char_map.h"
+#include "text_layout.h"
+#include "kerning.h"
+#include "batch_raster.h"
+#include "font_generator.h"
+#include "distance_field.h"
+#include "font_pack.h"
+#include "svg_writer.h"
+#include "glyph_atlas.h"
+#include "glyph_bounds.h"
+#include "instrumentation.h"
+#include <iostream>
 
 int main() {
     TTFReader reader;
+    reader.setLogSink(consoleLogSink, nullptr, LogLevel::Debug);     // The demo narrates every step
+    std::string fontPath = "RobotoMono-VariableFont_wght.ttf";
     
-    if (!reader.openFont("RobotoMono-VariableFont_wght.ttf")) {
-        std::cout << "Failed to open font file" << std::endl;
-        return 1;
+    if (!reader.openFont(fontPath)) {
+        // No font next to the binary: generate one covering printable ASCII
+        SyntheticFontOptions synthetic;
+        synthetic.glyphCount = 96;
+        synthetic.firstCodepoint = 0x20;
+        fontPath = "synthetic.ttf";
+        std::cout << "Font not found, using generated " << fontPath << std::endl;
+        if (!writeSyntheticFont(synthetic, fontPath) || !reader.openFont(fontPath)) {
+            std::cout << "Failed to open font file" << std::endl;
+            return 1;
+        }
     }
     
     TTFHeader header;
     if (reader.readHeader(header)) {
-        reader.printHeader(header);
+        printHeader(header);
         
         std::cout << "\nTables:" << std::endl;
         for (int i = 0; i < header.numTables; i++) {
             TableEntry entry;
             if (reader.readTableEntry(entry)) {
-                reader.printTableEntry(entry);
+                printTableEntry(entry);
             }
         }
     }
@@ -31,47 +55,247 @@ int main() {
             std::cout << "\n--- Parsing first glyph ---" << std::endl;
             SimpleGlyph glyph;
             int glyphIndex = 3;
+            
+            // Look the glyph up by character through 'cmap' when the font has one
+            CharMap charMap;
+            if (reader.loadCharMap(charMap)) {
+                glyphIndex = charMap.glyphForCodepoint('a');
+                std::cout << "Character 'a' maps to glyph " << glyphIndex
+                          << " (cmap format " << charMap.getSubtableFormat() << ")" << std::endl;
+            }
             // SimpleGlyph glyph2;
             // SimpleGlyph glyph3;
             // if (reader.readSimpleGlyph(glyph)) {
-            //     reader.printGlyph(glyph);
-            //     reader.plotGlyph(glyph);
+            //     printGlyph(glyph);
+            //     plotGlyph(glyph);
             //     reader.exportGlyphSVG(glyph, "glyph.svg");
             // } else {
             //     std::cout << "Failed to parse glyph" << std::endl;
             // }
             // if (reader.readSimpleGlyph(glyph2)) {
-            //     reader.printGlyph(glyph2);
-            //     reader.plotGlyph(glyph2);
+            //     printGlyph(glyph2);
+            //     plotGlyph(glyph2);
             //     reader.exportGlyphSVG(glyph2, "glyph2.svg");
             // } else {
             //     std::cout << "Failed to parse glyph" << std::endl;
             // }
             // if (reader.readSimpleGlyph(glyph3)) {
-            //     reader.printGlyph(glyph3);
-            //     reader.plotGlyph(glyph3);
+            //     printGlyph(glyph3);
+            //     plotGlyph(glyph3);
             //     reader.exportGlyphSVG(glyph3, "glyph3.svg");
             // } else {
             //     std::cout << "Failed to parse glyph" << std::endl;
             // }
-            //  reader.readMultipleGlyphs(5);
+            //  printGlyphsSequential(reader, 5);
             std::cout << "\n=== Reading Glyphs by Index ===" << std::endl;
-            // reader.readMultipleGlyphsByIndex(1, 26);  // Read glyphs 1-10
-            if (reader.readGlyphByIndex(glyphIndex, glyph)) {
-                reader.printGlyph(glyph);
-                reader.plotGlyph(glyph);
+            // printGlyphsByIndex(reader, 1, 26);  // Read glyphs 1-10
+            OutlineArena arena;
+            GlyphOutline outline;
+            if (reader.readGlyphByIndex(glyphIndex, glyph) && outlineFromGlyph(glyph, arena, outline)) {
+                printGlyph(outline);
+                plotGlyph(outline);
 
                 // Export both versions
                 std::string basicFilename = "glyph_" + std::to_string(glyphIndex) + "_basic.svg";
                 std::string curveFilename = "glyph_" + std::to_string(glyphIndex) + "_curves.svg";
 
-                reader.exportGlyphSVG(glyph, basicFilename);           // Original (straight lines)
-                reader.exportGlyphWithCurves(glyph, curveFilename);    // With Bézier curves
+                if (reader.exportGlyphSVG(outline, basicFilename)) {           // Original (straight lines)
+                    std::cout << "SVG exported to: " << basicFilename << std::endl;
+                }
+                if (reader.exportGlyphWithCurves(outline, curveFilename)) {    // With Bézier curves
+                    std::cout << "Curve SVG exported to: " << curveFilename << std::endl;
+                }
+
+                // Compare fixed vs tolerance-driven curve flattening
+                size_t fixedVertices = reader.generateGlyphOutline(outline).size();
+                std::vector<BezierPoint> flattened;
+                FlattenStats stats = reader.flattenGlyphOutline(outline, 0.25f, 64.0f / reader.getUnitsPerEm(), flattened);
+                std::cout << "Outline vertices: fixed(20) = " << fixedVertices
+                          << ", adaptive(0.25px @ 64px) = " << stats.vertices
+                          << " (" << stats.lines << " lines, " << stats.curves << " curves)" << std::endl;
+                
+                // Rasterize to an anti-aliased coverage bitmap at 64px
+                RasterPlacement placement = computeRasterPlacement(outline.header, 64.0f, reader.getUnitsPerEm());
+                std::vector<int32_t> scratch(rasterScratchCells(placement));
+                std::vector<uint8_t> pixels(static_cast<size_t>(placement.width) * placement.height);
+                GlyphBitmap bitmap;
+                bitmap.pixels = pixels.data();
+                bitmap.width = placement.width;
+                bitmap.height = placement.height;
+                bitmap.stride = placement.width;
+                
+                std::cout << "Raster backend: " << rasterBackendName(getRasterBackend()) << std::endl;
+                std::string bitmapFilename = "glyph_" + std::to_string(glyphIndex) + "_64px.pgm";
+                if (rasterizeGlyph(outline, placement, scratch.data(), scratch.size(), bitmap) &&
+                    writeBitmapPGM(bitmap, bitmapFilename)) {
+                    std::cout << "Bitmap exported to: " << bitmapFilename << std::endl;
+                }
+
+                // Single- and multi-channel distance fields at the same size
+                DistanceFieldGenerator fieldGenerator;
+                DistanceFieldOptions fieldOptions;
+                RasterPlacement fieldPlacement = computeDistanceFieldPlacement(outline.header, 64.0f,
+                                                                               reader.getUnitsPerEm(), fieldOptions.spread);
+                std::vector<uint8_t> fieldPixels(static_cast<size_t>(fieldPlacement.width) * fieldPlacement.height * 3);
+                GlyphBitmap field;
+                field.pixels = fieldPixels.data();
+                field.width = fieldPlacement.width;
+                field.height = fieldPlacement.height;
+                field.stride = fieldPlacement.width;
+                
+                std::string sdfFilename = "glyph_" + std::to_string(glyphIndex) + "_sdf.pgm";
+                if (fieldGenerator.generate(outline, fieldPlacement, fieldOptions, field) &&
+                    writeBitmapPGM(field, sdfFilename)) {
+                    std::cout << "Distance field exported to: " << sdfFilename << std::endl;
+                }
+                
+                fieldOptions.multiChannel = true;
+                field.stride = fieldPlacement.width * 3;
+                std::string msdfFilename = "glyph_" + std::to_string(glyphIndex) + "_msdf.ppm";
+                if (fieldGenerator.generate(outline, fieldPlacement, fieldOptions, field) &&
+                    writeBitmapPPM(field, msdfFilename)) {
+                    std::cout << "Multi-channel distance field exported to: " << msdfFilename << std::endl;
+                }
             }
         }
     } else {
         std::cout << "'glyf' table not found!" << std::endl;
     }
     
+    // Lay out and render a whole string into one bitmap
+    CharMap lineMap;
+    HorizontalMetrics metrics;
+    if (reader.loadCharMap(lineMap) && reader.loadHorizontalMetrics(metrics)) {
+        std::string text = "Hello, world!";
+        std::vector<uint16_t> glyphIds(text.size());
+        size_t glyphCount = lineMap.mapUtf8(text.data(), text.size(), glyphIds.data());
+        
+        TextRenderer renderer(reader, metrics);
+        KerningTable kerning;
+        if (reader.loadKerning(kerning)) {
+            renderer.setKerning(&kerning);
+            std::cout << "\nKerning: " << kerning.getPairCount() << " pair(s), " << kerning.getClassSubtableCount()
+                      << " class subtable(s)" << std::endl;
+        }
+        LineMetrics line = renderer.measureLine(glyphIds.data(), glyphCount, 48.0f);
+        std::vector<uint8_t> linePixels(static_cast<size_t>(line.width) * line.height);
+        GlyphBitmap lineBitmap;
+        lineBitmap.pixels = linePixels.data();
+        lineBitmap.width = line.width;
+        lineBitmap.height = line.height;
+        lineBitmap.stride = line.width;
+        
+        if (renderer.renderLine(glyphIds.data(), glyphCount, 48.0f, lineBitmap) &&
+            writeBitmapPGM(lineBitmap, "line_48px.pgm")) {
+            std::cout << "\nLine \"" << text << "\" (" << line.width << "x" << line.height
+                      << ") exported to: line_48px.pgm" << std::endl;
+        }
+        
+        // The same line measured from glyph headers alone - no outline decoded
+        GlyphBoundsTable bounds;
+        std::vector<float> penX(glyphCount);
+        InkBounds ink;
+        if (reader.loadGlyphBounds(bounds)) {
+            float scale = 48.0f / reader.getUnitsPerEm();
+            layoutGlyphRun(glyphIds.data(), glyphCount, metrics, scale, penX.data(), &kerning);
+            if (measureRunInk(glyphIds.data(), glyphCount, penX.data(), scale, bounds, ink)) {
+                std::cout << "Ink box at 48px: x " << ink.xMin << " to " << ink.xMax << ", y " << ink.yMin
+                          << " to " << ink.yMax << " (" << bounds.glyphCount() << " glyph headers, "
+                          << bounds.getCompositeCount() << " composites)" << std::endl;
+            }
+        }
+    }
+    
+    // Printable ASCII at two sizes packed into one atlas page, plus what a GPU upload would cover
+    if (lineMap.getSubtableFormat()) {
+        GlyphAtlas atlas(reader);
+        AtlasEntry entry;
+        int packed = 0;
+        for (float pixelSize : {24.0f, 48.0f}) {
+            for (uint32_t c = 0x20; c < 0x7F; c++) {
+                if (atlas.acquire(lineMap.glyphForCodepoint(c), pixelSize, entry)) packed++;
+            }
+        }
+        std::vector<AtlasRect> dirty;
+        if (atlas.takeDirtyRects(0, dirty) && atlas.writePagePGM(0, "atlas_page0.pgm")) {
+            std::cout << "\nAtlas: " << packed << " glyphs on " << atlas.getPageCount() << " page(s), "
+                      << dirty.size() << " dirty rect(s), exported to: atlas_page0.pgm" << std::endl;
+        }
+    }
+    
+    // Variable fonts: the same glyph at the far end of each axis from the default
+    FontVariations variations;
+    if (variations.load(*reader.getFace())) {
+        std::cout << std::endl;
+        printVariationAxes(variations);
+        
+        int glyphIndex = lineMap.getSubtableFormat() ? lineMap.glyphForCodepoint('a') : 3;
+        OutlineArena arena;
+        for (const VariationAxis& axis : variations.getAxes()) {
+            float extreme = (axis.maxValue != axis.defaultValue) ? axis.maxValue : axis.minValue;
+            std::vector<float> user, normalized;
+            for (const VariationAxis& other : variations.getAxes()) {
+                user.push_back(&other == &axis ? extreme : other.defaultValue);
+            }
+            variations.normalize(user, normalized);
+            reader.setVariationInstance(variations.createInstance(normalized));
+            
+            GlyphOutline varied;
+            std::string filename = "glyph_" + std::to_string(glyphIndex) + "_" + axis.tag + "_" +
+                                   std::to_string(static_cast<int>(extreme)) + ".svg";
+            if (reader.loadOutline(glyphIndex, arena, varied) && reader.exportGlyphWithCurves(varied, filename)) {
+                std::cout << "Glyph at " << axis.tag << "=" << extreme << " exported to: " << filename << std::endl;
+            }
+        }
+        reader.setVariationInstance(nullptr);
+    }
+    
+    // Precompiled sidecar: later runs map it instead of decoding the font
+    FontPack pack;
+    FontPackOptions packOptions;
+    packOptions.bitmapSizes = {16.0f};
+    if (openFontPack(fontPath, fontPath + ".pack", packOptions, pack)) {
+        TTFReader packedReader;     // Shares the first reader's mapped face, no second open
+        if (packedReader.attachFace(reader.getFace()) && packedReader.setFontPack(&pack)) {
+            OutlineArena unused;
+            GlyphOutline packedOutline;
+            size_t points = 0;
+            for (int i = 0; i < packedReader.getNumGlyphs(); i++) {
+                if (packedReader.loadOutline(i, unused, packedOutline)) points += packedOutline.pointCount;
+            }
+            std::cout << "\nFont pack: " << fontPath << ".pack, " << pack.getNumGlyphs() << " glyphs ("
+                      << points << " points) served from the mapping, "
+                      << pack.getBitmapSizeCount() << " pre-rendered size(s)" << std::endl;
+        }
+    }
+    
+    // Pre-render the whole font at a few sizes on every core
+    BatchRasterOptions batch;
+    batch.pixelSizes = {12.0f, 16.0f, 24.0f, 32.0f};
+    BatchRasterResult batchResult;
+    if (rasterizeFontParallel(fontPath, batch, batchResult)) {
+        std::cout << "\nBatch: " << batchResult.glyphs << " glyphs, " << batchResult.bitmaps << " bitmaps in "
+                  << batchResult.wallSeconds * 1000.0 << " ms on " << batchResult.workers.size() << " threads" << std::endl;
+        for (size_t i = 0; i < batchResult.workers.size(); i++) {
+            const WorkerStats& worker = batchResult.workers[i];
+            std::cout << "  Thread " << i << ": " << worker.glyphs << " glyphs, " << worker.tasks << " tasks ("
+                      << worker.stolen << " stolen), " << static_cast<int>(worker.glyphsPerSecond()) << " glyphs/s" << std::endl;
+        }
+    }
+
+    // Every glyph as a <symbol> in one sprite file
+    SvgSpriteResult sprite;
+    if (exportFontSprite(fontPath, "font_sprite.svg", SvgSpriteOptions(), sprite)) {
+        std::cout << "\nSprite: font_sprite.svg, " << sprite.glyphs << " symbols, " << sprite.bytes / 1024 << " KB in "
+                  << sprite.wallSeconds * 1000.0 << " ms" << std::endl;
+    }
+
+    // Only populated in builds with -DTTF_INSTRUMENTATION
+    if (instrumentationEnabled()) {
+        InstrumentationSnapshot counters;
+        collectInstrumentation(counters);
+        std::cout << "\nInstrumentation:\n" << formatInstrumentationJSON(counters);
+    }
+    
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "point_decode.h"
+#include <atomic>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define POINT_DECODE_X86 1
+#endif
+
+// Flag bits
+const uint8_t ON_CURVE_POINT = 0x01;
+const uint8_t X_SHORT_VECTOR = 0x02;
+const uint8_t Y_SHORT_VECTOR = 0x04;
+const uint8_t REPEAT_FLAG = 0x08;
+const uint8_t X_IS_SAME_OR_POSITIVE = 0x10;
+const uint8_t Y_IS_SAME_OR_POSITIVE = 0x20;
+
+// One coordinate stream, point by point. Also the tail of the SIMD decoder.
+// Returns the stream position after the last point, or 0 on overrun.
+static size_t decodeAxisScalar(const uint8_t* data, size_t size, size_t pos, const uint8_t* flags,
+                               uint32_t begin, uint32_t end, uint8_t shortBit, uint8_t sameBit,
+                               int16_t current, int16_t* out) {
+    for (uint32_t i = begin; i < end; i++) {
+        uint8_t flag = flags[i];
+
+        if (flag & shortBit) {
+            if (pos >= size) return 0;
+            uint8_t delta = data[pos++];
+            current += (flag & sameBit) ? delta : -delta;
+        } else if (!(flag & sameBit)) {
+            if (pos + 2 > size) return 0;
+            current += static_cast<int16_t>((data[pos] << 8) | data[pos + 1]);
+            pos += 2;
+        }
+        out[i] = current;
+    }
+    return pos;
+}
+
+size_t decodeGlyphPointsScalar(const uint8_t* data, size_t size, uint32_t numPoints,
+                               uint8_t* flags, int16_t* xs, int16_t* ys, uint8_t* onCurveBits) {
+    size_t pos = 0;
+    for (uint32_t i = 0; i < numPoints; ) {
+        if (pos >= size) return 0;
+        uint8_t flag = data[pos++];
+        onCurveBits[i >> 3] |= static_cast<uint8_t>(flag & ON_CURVE_POINT) << (i & 7);
+        flags[i++] = flag;
+
+        if (flag & REPEAT_FLAG) {
+            if (pos >= size) return 0;
+            uint8_t repeatCount = data[pos++];
+            for (int j = 0; j < repeatCount && i < numPoints; j++, i++) {
+                onCurveBits[i >> 3] |= static_cast<uint8_t>(flag & ON_CURVE_POINT) << (i & 7);
+                flags[i] = flag;
+            }
+        }
+    }
+
+    pos = decodeAxisScalar(data, size, pos, flags, 0, numPoints, X_SHORT_VECTOR, X_IS_SAME_OR_POSITIVE, 0, xs);
+    if (pos == 0) return 0;
+    return decodeAxisScalar(data, size, pos, flags, 0, numPoints, Y_SHORT_VECTOR, Y_IS_SAME_OR_POSITIVE, 0, ys);
+}
+
+#ifdef POINT_DECODE_X86
+
+// Eight points per step, in 16-bit lanes:
+//   1. width from the flags: short -> 1 byte, same -> 0, otherwise 2
+//   2. exclusive prefix sum of the widths = each delta's offset in a 16-byte window
+//   3. pshufb gathers the deltas (big-endian words swapped, bytes zero-extended)
+//   4. negative short deltas are negated, then a prefix sum plus the previous
+//      coordinate gives absolute values
+// Eight deltas are at most 16 bytes, so one unaligned load covers a step.
+__attribute__((target("ssse3")))
+static size_t decodeAxisSSSE3(const uint8_t* data, size_t size, size_t pos, const uint8_t* flags,
+                              uint32_t numPoints, uint8_t shortBit, uint8_t sameBit, int16_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i shortBits = _mm_set1_epi16(shortBit);
+    const __m128i sameBits = _mm_set1_epi16(sameBit);
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i skipBytes = _mm_set1_epi16(static_cast<int16_t>(0x8080));
+    const __m128i zeroHighByte = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+    const __m128i lastLane = _mm_set1_epi16(0x0F0E);
+
+    __m128i carry = zero;
+    uint32_t i = 0;
+    for (; i + 8 <= numPoints && pos + 16 <= size; i += 8) {
+        __m128i f = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags + i)), zero);
+        __m128i isShort = _mm_cmpeq_epi16(_mm_and_si128(f, shortBits), shortBits);
+        __m128i isSame = _mm_cmpeq_epi16(_mm_and_si128(f, sameBits), sameBits);
+        __m128i isLong = _mm_cmpeq_epi16(_mm_or_si128(isShort, isSame), zero);
+
+        // Widths and their prefix sums
+        __m128i width = _mm_add_epi16(_mm_and_si128(isShort, one), _mm_and_si128(isLong, _mm_add_epi16(one, one)));
+        __m128i end = _mm_add_epi16(width, _mm_slli_si128(width, 2));
+        end = _mm_add_epi16(end, _mm_slli_si128(end, 4));
+        end = _mm_add_epi16(end, _mm_slli_si128(end, 8));
+        __m128i offset = _mm_sub_epi16(end, width);
+
+        // Shuffle control per lane (low byte, high byte)
+        __m128i longControl = _mm_or_si128(_mm_add_epi16(offset, one), _mm_slli_epi16(offset, 8));
+        __m128i shortControl = _mm_or_si128(offset, zeroHighByte);
+        __m128i control = _mm_or_si128(_mm_and_si128(isLong, longControl),
+                                       _mm_andnot_si128(isLong, skipBytes));
+        control = _mm_or_si128(_mm_and_si128(isShort, shortControl), _mm_andnot_si128(isShort, control));
+
+        __m128i window = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+        __m128i delta = _mm_shuffle_epi8(window, control);
+
+        __m128i negate = _mm_andnot_si128(isSame, isShort);
+        delta = _mm_sub_epi16(_mm_xor_si128(delta, negate), negate);
+
+        delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 2));
+        delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 4));
+        delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 8));
+        delta = _mm_add_epi16(delta, carry);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), delta);
+
+        carry = _mm_shuffle_epi8(delta, lastLane);
+        pos += static_cast<uint16_t>(_mm_extract_epi16(end, 7));
+    }
+
+    int16_t current = static_cast<int16_t>(_mm_cvtsi128_si32(carry));
+    return decodeAxisScalar(data, size, pos, flags, i, numPoints, shortBit, sameBit, current, out);
+}
+
+__attribute__((target("ssse3")))
+static size_t decodeGlyphPointsSSSE3Impl(const uint8_t* data, size_t size, uint32_t numPoints,
+                                         uint8_t* flags, int16_t* xs, int16_t* ys, uint8_t* onCurveBits) {
+    // Literal flags are copied 16 at a time up to the next repeat flag;
+    // repeats expand with one memset per run
+    size_t pos = 0;
+    for (uint32_t i = 0; i < numPoints; ) {
+        if (i + 16 <= numPoints && pos + 16 <= size) {
+            __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(flags + i), f);
+            int repeats = _mm_movemask_epi8(_mm_slli_epi16(f, 4)); // REPEAT_FLAG -> sign bit
+            int literal = repeats ? __builtin_ctz(repeats) : 16;
+            i += literal;
+            pos += literal;
+            if (literal == 16) continue;
+        }
+
+        if (pos >= size) return 0;
+        uint8_t flag = data[pos++];
+        flags[i++] = flag;
+
+        if (flag & REPEAT_FLAG) {
+            if (pos >= size) return 0;
+            uint32_t repeatCount = data[pos++];
+            if (repeatCount > numPoints - i) repeatCount = numPoints - i;
+            std::memset(flags + i, flag, repeatCount);
+            i += repeatCount;
+        }
+    }
+
+    // On-curve bit of 16 flags at a time: shift bit 0 up to each byte's sign bit
+    uint32_t i = 0;
+    for (; i + 16 <= numPoints; i += 16) {
+        __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(flags + i));
+        int bits = _mm_movemask_epi8(_mm_slli_epi16(f, 7));
+        onCurveBits[i >> 3] = static_cast<uint8_t>(bits);
+        onCurveBits[(i >> 3) + 1] = static_cast<uint8_t>(bits >> 8);
+    }
+    for (; i < numPoints; i++) {
+        onCurveBits[i >> 3] |= static_cast<uint8_t>(flags[i] & ON_CURVE_POINT) << (i & 7);
+    }
+
+    pos = decodeAxisSSSE3(data, size, pos, flags, numPoints, X_SHORT_VECTOR, X_IS_SAME_OR_POSITIVE, xs);
+    if (pos == 0) return 0;
+    return decodeAxisSSSE3(data, size, pos, flags, numPoints, Y_SHORT_VECTOR, Y_IS_SAME_OR_POSITIVE, ys);
+}
+
+#endif
+
+size_t decodeGlyphPointsSSSE3(const uint8_t* data, size_t size, uint32_t numPoints,
+                              uint8_t* flags, int16_t* xs, int16_t* ys, uint8_t* onCurveBits) {
+#ifdef POINT_DECODE_X86
+    return decodeGlyphPointsSSSE3Impl(data, size, numPoints, flags, xs, ys, onCurveBits);
+#else
+    return decodeGlyphPointsScalar(data, size, numPoints, flags, xs, ys, onCurveBits);
+#endif
+}
+
+const char* pointDecodeBackendName(PointDecodeBackend backend) {
+    switch (backend) {
+        case PointDecodeBackend::Auto: return "auto";
+        case PointDecodeBackend::Scalar: return "scalar";
+        case PointDecodeBackend::SSSE3: return "ssse3";
+    }
+    return "unknown";
+}
+
+bool pointDecodeBackendSupported(PointDecodeBackend backend) {
+    switch (backend) {
+        case PointDecodeBackend::Auto:
+        case PointDecodeBackend::Scalar:
+            return true;
+        case PointDecodeBackend::SSSE3:
+#ifdef POINT_DECODE_X86
+            return __builtin_cpu_supports("ssse3");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+typedef size_t (*PointDecoder)(const uint8_t*, size_t, uint32_t, uint8_t*, int16_t*, int16_t*, uint8_t*);
+
+// Resolved on first use so the CPU check happens once, not per glyph
+static std::atomic<PointDecodeBackend> selectedBackend{PointDecodeBackend::Auto};
+static std::atomic<PointDecoder> selectedDecoder{nullptr};
+
+bool setPointDecodeBackend(PointDecodeBackend backend) {
+    if (!pointDecodeBackendSupported(backend)) return false;
+    if (backend == PointDecodeBackend::Auto) {
+        backend = pointDecodeBackendSupported(PointDecodeBackend::SSSE3) ? PointDecodeBackend::SSSE3
+                                                                          : PointDecodeBackend::Scalar;
+    }
+
+    selectedBackend.store(backend, std::memory_order_relaxed);
+    selectedDecoder.store(backend == PointDecodeBackend::SSSE3 ? decodeGlyphPointsSSSE3 : decodeGlyphPointsScalar,
+                          std::memory_order_release);
+    return true;
+}
+
+PointDecodeBackend getPointDecodeBackend() {
+    if (!selectedDecoder.load(std::memory_order_acquire)) setPointDecodeBackend(PointDecodeBackend::Auto);
+    return selectedBackend.load(std::memory_order_relaxed);
+}
+
+size_t decodeGlyphPoints(const uint8_t* data, size_t size, uint32_t numPoints,
+                         uint8_t* flags, int16_t* xs, int16_t* ys, uint8_t* onCurveBits) {
+    PointDecoder decoder = selectedDecoder.load(std::memory_order_acquire);
+    if (!decoder) {
+        setPointDecodeBackend(PointDecodeBackend::Auto);
+        decoder = selectedDecoder.load(std::memory_order_acquire);
+    }
+    return decoder(data, size, numPoints, flags, xs, ys, onCurveBits);
+}
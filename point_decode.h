@@ -0,0 +1,44 @@
+#ifndef POINT_DECODE_H
+#define POINT_DECODE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Decoding of a simple glyph's point data: the run-length coded flag array
+// followed by the x and y delta streams. Each delta is 0, 1 or 2 bytes wide
+// depending on its flag, and coordinates are the running sum of the deltas.
+//
+// data/size cover everything from the first flag byte to the end of the
+// glyph. flags must hold numPoints bytes (scratch), xs/ys numPoints entries
+// and onCurveBits (numPoints + 7) / 8 bytes, zeroed by the caller. Returns
+// the bytes consumed, or 0 if the streams run past size.
+//
+// All backends produce identical output, including 16-bit wraparound on
+// malformed fonts.
+enum class PointDecodeBackend {
+    Auto,       // Best one the CPU supports
+    Scalar,
+    SSSE3
+};
+
+const char* pointDecodeBackendName(PointDecodeBackend backend);
+bool pointDecodeBackendSupported(PointDecodeBackend backend);
+
+// Selects the decoder used by decodeGlyphPoints. Returns false (and keeps the
+// current one) if the CPU can't run it.
+bool setPointDecodeBackend(PointDecodeBackend backend);
+PointDecodeBackend getPointDecodeBackend();
+
+size_t decodeGlyphPoints(const uint8_t* data, size_t size, uint32_t numPoints,
+                         uint8_t* flags, int16_t* xs, int16_t* ys, uint8_t* onCurveBits);
+
+// Direct entry points. Scalar is the reference for differential testing; the
+// SIMD one computes per-point byte widths from the flags, gathers 8 deltas
+// at a time with a byte shuffle and prefix-sums them in registers. It falls
+// back to scalar on builds without x86 kernels.
+size_t decodeGlyphPointsScalar(const uint8_t* data, size_t size, uint32_t numPoints,
+                               uint8_t* flags, int16_t* xs, int16_t* ys, uint8_t* onCurveBits);
+size_t decodeGlyphPointsSSSE3(const uint8_t* data, size_t size, uint32_t numPoints,
+                              uint8_t* flags, int16_t* xs, int16_t* ys, uint8_t* onCurveBits);
+
+#endif
@@ -0,0 +1,198 @@
+#include "rasterizer.h"
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+
+// Max distance (pixels) between a flattened quadratic and the true curve.
+// Far below what 8-bit coverage can show, and small glyphs get very few lines.
+static const float RASTER_FLATTEN_TOLERANCE = 0.1f;
+
+// Extra cells per accumulation row: a segment touching the right edge still
+// writes one or two cells past the last pixel column
+static const int RASTER_ROW_PADDING = 2;
+
+static inline int32_t toCoverage(float area) {
+    return static_cast<int32_t>(std::lrintf(area * RASTER_COVERAGE_ONE));
+}
+
+// Adds one line segment's signed area to the accumulation buffer.
+// Coordinates are in bitmap pixels (y down). Each cell receives the change in
+// coverage at its left edge, so a running sum along a row yields the winding
+// weighted area covered in every pixel.
+static void accumulateLine(int32_t* cells, int stride, int width, int height,
+                           float x0, float y0, float x1, float y1) {
+    if (y0 == y1) return; // Horizontal edges add no area
+
+    float dir = 1.0f;
+    if (y0 > y1) {
+        dir = -1.0f;
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    if (y1 <= 0.0f || y0 >= static_cast<float>(height)) return;
+
+    float dxdy = (x1 - x0) / (y1 - y0);
+
+    // Clip to the bitmap rows
+    float x = x0;
+    if (y0 < 0.0f) {
+        x -= y0 * dxdy;
+        y0 = 0.0f;
+    }
+    if (y1 > static_cast<float>(height)) y1 = static_cast<float>(height);
+
+    const float maxX = static_cast<float>(width);
+    int yStart = static_cast<int>(y0);
+    int yEnd = static_cast<int>(std::ceil(y1));
+
+    for (int y = yStart; y < yEnd; y++) {
+        int32_t* row = cells + static_cast<size_t>(y) * stride;
+        float dy = std::min(static_cast<float>(y + 1), y1) - std::max(static_cast<float>(y), y0);
+        float xNext = x + dxdy * dy;
+        float d = dy * dir;
+
+        // Area left of the bitmap still counts - it lands in column 0
+        float xa = std::min(std::max(std::min(x, xNext), 0.0f), maxX);
+        float xb = std::min(std::max(std::max(x, xNext), 0.0f), maxX);
+
+        float xaFloor = std::floor(xa);
+        int xai = static_cast<int>(xaFloor);
+        int xbi = static_cast<int>(std::ceil(xb));
+
+        if (xbi <= xai + 1) {
+            // Segment stays within one pixel column on this row
+            float xmf = 0.5f * (xa + xb) - xaFloor;
+            row[xai] += toCoverage(d - d * xmf);
+            row[xai + 1] += toCoverage(d * xmf);
+        } else {
+            // Segment crosses several columns: trapezoid areas per cell
+            float s = 1.0f / (xb - xa);
+            float xaFrac = xa - xaFloor;
+            float a0 = 0.5f * s * (1.0f - xaFrac) * (1.0f - xaFrac);
+            float xbFrac = xb - static_cast<float>(xbi) + 1.0f;
+            float am = 0.5f * s * xbFrac * xbFrac;
+
+            row[xai] += toCoverage(d * a0);
+            if (xbi == xai + 2) {
+                row[xai + 1] += toCoverage(d * (1.0f - a0 - am));
+            } else {
+                float a1 = s * (1.5f - xaFrac);
+                row[xai + 1] += toCoverage(d * (a1 - a0));
+                int32_t step = toCoverage(d * s);
+                for (int xi = xai + 2; xi < xbi - 1; xi++) {
+                    row[xi] += step;
+                }
+                float a2 = a1 + static_cast<float>(xbi - xai - 3) * s;
+                row[xbi - 1] += toCoverage(d * (1.0f - a2 - am));
+            }
+            row[xbi] += toCoverage(d * am);
+        }
+
+        x = xNext;
+    }
+}
+
+// Turns outline calls (font units) into accumulated line segments
+struct CoverageSink {
+    int32_t* cells;
+    int stride, width, height;
+    float scale, offsetX, offsetY;  // font units -> bitmap pixels
+    BezierPoint current;            // Last point, already in pixels
+
+    BezierPoint toPixels(const BezierPoint& p) const {
+        return BezierPoint(p.x * scale + offsetX, offsetY - p.y * scale);
+    }
+
+    void moveTo(const BezierPoint& p) {
+        current = toPixels(p);
+    }
+    void lineTo(const BezierPoint& p) {
+        BezierPoint next = toPixels(p);
+        accumulateLine(cells, stride, width, height, current.x, current.y, next.x, next.y);
+        current = next;
+    }
+    void quadTo(const BezierPoint& c, const BezierPoint& p) {
+        BezierPoint start = current;
+        BezierPoint control = toPixels(c);
+        BezierPoint end = toPixels(p);
+
+        int segments = quadraticSegmentCount(start, control, end, RASTER_FLATTEN_TOLERANCE);
+        for (int i = 1; i <= segments; i++) {
+            float t = static_cast<float>(i) / segments;
+            float mt = 1.0f - t;
+            BezierPoint next(mt * mt * start.x + 2.0f * mt * t * control.x + t * t * end.x,
+                             mt * mt * start.y + 2.0f * mt * t * control.y + t * t * end.y);
+            accumulateLine(cells, stride, width, height, current.x, current.y, next.x, next.y);
+            current = next;
+        }
+    }
+    void closePath() {}
+};
+
+RasterPlacement computeRasterPlacement(const GlyphHeader& header, float pixelSize, uint16_t unitsPerEm,
+                                       float subpixelX, float subpixelY) {
+    RasterPlacement placement;
+    if (unitsPerEm == 0 || pixelSize <= 0.0f) return placement;
+
+    placement.scale = pixelSize / unitsPerEm;
+    placement.shiftX = subpixelX;
+    placement.shiftY = subpixelY;
+
+    int x0 = static_cast<int>(std::floor(header.xMin * placement.scale + subpixelX));
+    int x1 = static_cast<int>(std::ceil(header.xMax * placement.scale + subpixelX));
+    int y0 = static_cast<int>(std::floor(header.yMin * placement.scale + subpixelY));
+    int y1 = static_cast<int>(std::ceil(header.yMax * placement.scale + subpixelY));
+
+    placement.left = x0;
+    placement.top = y1;
+    placement.width = std::max(0, x1 - x0);
+    placement.height = std::max(0, y1 - y0);
+    return placement;
+}
+
+size_t rasterScratchCells(const RasterPlacement& placement) {
+    if (placement.width <= 0 || placement.height <= 0) return 0;
+    return static_cast<size_t>(placement.width + RASTER_ROW_PADDING) * placement.height;
+}
+
+bool rasterizeGlyph(const GlyphOutline& glyph, const RasterPlacement& placement,
+                    int32_t* scratch, size_t scratchCells, GlyphBitmap& out) {
+    int width = placement.width;
+    int height = placement.height;
+    if (width <= 0 || height <= 0) return false;
+    if (!scratch || scratchCells < rasterScratchCells(placement)) return false;
+    if (!out.pixels || out.width < width || out.height < height || out.stride < width) return false;
+
+    int stride = width + RASTER_ROW_PADDING;
+    std::memset(scratch, 0, rasterScratchCells(placement) * sizeof(int32_t));
+
+    CoverageSink sink;
+    sink.cells = scratch;
+    sink.stride = stride;
+    sink.width = width;
+    sink.height = height;
+    sink.scale = placement.scale;
+    sink.offsetX = placement.shiftX - placement.left;
+    sink.offsetY = placement.top - placement.shiftY;
+    walkGlyphContours(glyph, sink);
+
+    // Running sum along each row gives the signed coverage per pixel
+    for (int y = 0; y < height; y++) {
+        accumulateCoverageRow(scratch + static_cast<size_t>(y) * stride,
+                              out.pixels + static_cast<size_t>(y) * out.stride, width);
+    }
+    return true;
+}
+
+bool writeBitmapPGM(const GlyphBitmap& bitmap, const std::string& filename) {
+    std::ofstream pgm(filename, std::ios::binary);
+    if (!pgm.is_open()) return false;
+
+    pgm << "P5\n" << bitmap.width << " " << bitmap.height << "\n255\n";
+    for (int y = 0; y < bitmap.height; y++) {
+        pgm.write(reinterpret_cast<const char*>(bitmap.pixels + static_cast<size_t>(y) * bitmap.stride),
+                  bitmap.width);
+    }
+    return pgm.good();
+}
@@ -0,0 +1,46 @@
+#ifndef RASTERIZER_H
+#define RASTERIZER_H
+
+#include "ttf_reader.h"
+#include "coverage_kernels.h"
+
+// 8-bit coverage bitmap owned by the caller.
+// Rows run top to bottom; 0 = empty, 255 = fully covered.
+struct GlyphBitmap {
+    uint8_t* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;     // Bytes per row (>= width)
+};
+
+// Where a glyph lands in pixel space at a given size and subpixel offset.
+// left/top are the bitmap's top-left corner relative to the pen position
+// (x right, y up), so pixel (0,0) covers x in [left, left+1), y in [top-1, top).
+struct RasterPlacement {
+    float scale = 0;        // Pixels per font unit
+    float shiftX = 0;       // Subpixel offset applied before snapping
+    float shiftY = 0;
+    int left = 0;
+    int top = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Sizes the bitmap for a glyph's bounding box at pixelSize (pixels per em)
+RasterPlacement computeRasterPlacement(const GlyphHeader& header, float pixelSize, uint16_t unitsPerEm,
+                                       float subpixelX = 0.0f, float subpixelY = 0.0f);
+
+// Number of int32_t accumulation cells rasterizeGlyph needs for a placement
+size_t rasterScratchCells(const RasterPlacement& placement);
+
+// Renders the glyph's filled outline (non-zero winding, exact area coverage)
+// into out. scratch must hold rasterScratchCells(placement) cells and out must
+// be at least placement.width x placement.height. Nothing is allocated.
+// The accumulation pass runs on the kernel picked by setRasterBackend().
+bool rasterizeGlyph(const GlyphOutline& glyph, const RasterPlacement& placement,
+                    int32_t* scratch, size_t scratchCells, GlyphBitmap& out);
+
+// Writes a bitmap as a binary PGM image (handy for eyeballing output)
+bool writeBitmapPGM(const GlyphBitmap& bitmap, const std::string& filename);
+
+#endif
@@ -0,0 +1,297 @@
+#include "svg_writer.h"
+#include "ttf_reader.h"
+#include "thread_pool.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <memory>
+
+char* SvgBuffer::reserve(size_t bytes) {
+    if (storage.size() - used < bytes) {
+        storage.resize(std::max({storage.size() * 2, used + bytes, static_cast<size_t>(4096)}));
+    }
+    return storage.data() + used;
+}
+
+void SvgBuffer::append(const char* text, size_t length) {
+    std::memcpy(reserve(length), text, length);
+    used += length;
+}
+
+void SvgBuffer::append(const char* text) {
+    append(text, std::strlen(text));
+}
+
+void SvgBuffer::append(char c) {
+    *reserve(1) = c;
+    used++;
+}
+
+void SvgBuffer::appendInt(long value) {
+    const size_t maxDigits = 24;
+    char* out = reserve(maxDigits);
+    used += std::to_chars(out, out + maxDigits, value).ptr - out;
+}
+
+void SvgBuffer::appendNumber(float value) {
+    if (value == 0.0f) value = 0.0f;    // No "-0"
+    const size_t maxChars = 32;
+    char* out = reserve(maxChars);
+    used += std::to_chars(out, out + maxChars, value).ptr - out;
+}
+
+bool SvgBuffer::writeTo(std::FILE* file) const {
+    return used == 0 || std::fwrite(storage.data(), 1, used, file) == used;
+}
+
+bool SvgBuffer::writeFile(const std::string& filename) const {
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) return false;
+    bool written = writeTo(file);
+    return std::fclose(file) == 0 && written;
+}
+
+namespace {
+
+struct SvgPathSink {
+    SvgBuffer& out;
+    float originX, originY;
+    float ySign;
+    bool started = false;
+
+    void point(const BezierPoint& p) {
+        out.appendNumber(p.x - originX);
+        out.append(' ');
+        out.appendNumber(ySign * (p.y - originY));
+    }
+    void moveTo(const BezierPoint& p) {
+        if (started) out.append(' ');
+        out.append("M ", 2);
+        point(p);
+        started = true;
+    }
+    void lineTo(const BezierPoint& p) {
+        out.append(" L ", 3);
+        point(p);
+    }
+    void quadTo(const BezierPoint& c, const BezierPoint& p) {
+        out.append(" Q ", 3);
+        point(c);
+        out.append(' ');
+        point(p);
+    }
+    void closePath() {
+        out.append(" Z", 2);
+    }
+};
+
+} // namespace
+
+void appendGlyphPath(SvgBuffer& out, const GlyphOutline& glyph, float originX, float originY, bool flipY) {
+    SvgPathSink sink{out, originX, originY, flipY ? -1.0f : 1.0f, false};
+    walkGlyphContours(glyph, sink);
+}
+
+void appendGlyphSVG(SvgBuffer& out, const GlyphOutline& glyph, bool curves) {
+    int width = glyph.header.xMax - glyph.header.xMin + 100;
+    int height = glyph.header.yMax - glyph.header.yMin + 100;
+
+    out.append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg width=\"");
+    out.appendInt(width);
+    out.append("\" height=\"");
+    out.appendInt(height);
+    out.append("\" xmlns=\"http://www.w3.org/2000/svg\">\n<g transform=\"translate(50,");
+    out.appendInt(height - 50);
+    out.append(") scale(1,-1)\">\n");
+
+    // Numbered points; the curve view draws them fainter as a reference
+    const char* onCurveStyle = curves ? "\" r=\"2\" fill=\"red\" opacity=\"0.5\"/>\n" : "\" r=\"3\" fill=\"red\"/>\n";
+    const char* offCurveStyle = curves ? "\" r=\"1\" fill=\"blue\" opacity=\"0.5\"/>\n" : "\" r=\"2\" fill=\"blue\"/>\n";
+    const char* labelStyle = curves ? "\" font-size=\"6\" fill=\"black\" transform=\"scale(1,-1)\">"
+                                    : "\" font-size=\"8\" fill=\"white\" transform=\"scale(1,-1)\">";
+    int labelOffset = curves ? 3 : 5;
+
+    for (size_t i = 0; i < glyph.pointCount; i++) {
+        int x = glyph.xs[i] - glyph.header.xMin;
+        int y = glyph.ys[i] - glyph.header.yMin;
+
+        out.append("<circle cx=\"");
+        out.appendInt(x);
+        out.append("\" cy=\"");
+        out.appendInt(y);
+        out.append(glyph.onCurve(i) ? onCurveStyle : offCurveStyle);
+
+        out.append("<text x=\"");
+        out.appendInt(x + labelOffset);
+        out.append("\" y=\"");
+        out.appendInt(y + labelOffset);
+        out.append(labelStyle);
+        out.appendInt(static_cast<long>(i));
+        out.append("</text>\n");
+    }
+
+    if (curves) {
+        // One path per contour, using the shared TrueType curve rules
+        struct ContourPathSink {
+            SvgPathSink path;
+
+            void moveTo(const BezierPoint& p) {
+                path.out.append("<path d=\"");
+                path.started = false;   // Each contour is a path of its own
+                path.moveTo(p);
+            }
+            void lineTo(const BezierPoint& p) { path.lineTo(p); }
+            void quadTo(const BezierPoint& c, const BezierPoint& p) { path.quadTo(c, p); }
+            void closePath() {
+                path.out.append(" Z\" fill=\"none\" stroke=\"green\" stroke-width=\"2\"/>\n");
+            }
+        };
+        ContourPathSink sink{{out, static_cast<float>(glyph.header.xMin), static_cast<float>(glyph.header.yMin), 1.0f, false}};
+        walkGlyphContours(glyph, sink);
+    } else {
+        size_t pointIndex = 0;
+        for (size_t contour = 0; contour < glyph.contourCount; contour++) {
+            size_t endPt = glyph.endPts[contour];
+
+            out.append("<polygon points=\"");
+            while (pointIndex <= endPt && pointIndex < glyph.pointCount) {
+                out.appendInt(glyph.xs[pointIndex] - glyph.header.xMin);
+                out.append(',');
+                out.appendInt(glyph.ys[pointIndex] - glyph.header.yMin);
+                out.append(' ');
+                pointIndex++;
+            }
+            out.append("\" fill=\"none\" stroke=\"green\" stroke-width=\"1\"/>\n");
+        }
+    }
+
+    out.append("</g>\n</svg>\n");
+}
+
+bool writeGlyphSVG(const GlyphOutline& glyph, const std::string& filename, bool curves, SvgBuffer& buffer) {
+    TTF_TIME_STAGE(Export);
+    buffer.clear();
+    appendGlyphSVG(buffer, glyph, curves);
+    return buffer.writeFile(filename);
+}
+
+namespace {
+
+struct alignas(64) SpriteWorker {
+    TTFReader reader;
+    OutlineArena arena;
+    GlyphOutline glyph;
+    SvgBuffer buffer;
+    uint64_t glyphs = 0;
+    uint64_t failedGlyphs = 0;
+};
+
+// Where a task's output landed: a slice of one worker's buffer
+struct SpriteChunk {
+    unsigned worker = 0;
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+void appendSymbol(SvgBuffer& out, const GlyphOutline& glyph, int glyphIndex, const std::string& idPrefix) {
+    const GlyphHeader& header = glyph.header;
+
+    // y is flipped in the path, so the font's yMax becomes the top edge
+    out.append("<symbol id=\"");
+    out.append(idPrefix.data(), idPrefix.size());
+    out.appendInt(glyphIndex);
+    out.append("\" viewBox=\"");
+    out.appendInt(header.xMin);
+    out.append(' ');
+    out.appendInt(-header.yMax);
+    out.append(' ');
+    out.appendInt(header.xMax - header.xMin);
+    out.append(' ');
+    out.appendInt(header.yMax - header.yMin);
+    if (glyph.empty()) {
+        out.append("\"/>\n");
+        return;
+    }
+    out.append("\"><path d=\"");
+    appendGlyphPath(out, glyph, 0.0f, 0.0f, true);
+    out.append("\"/></symbol>\n");
+}
+
+} // namespace
+
+bool exportFontSprite(const std::string& fontPath, const std::string& filename,
+                      const SvgSpriteOptions& options, SvgSpriteResult& result) {
+    TTF_TIME_STAGE(Export);
+    result = SvgSpriteResult();
+
+    WorkStealingPool pool(options.threads);
+    unsigned threadCount = pool.size();
+
+    std::shared_ptr<FontFace> face = std::make_shared<FontFace>();
+    if (!face->open(fontPath)) return false;
+    face->widenLoca();
+
+    std::vector<std::unique_ptr<SpriteWorker>> workers;
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.push_back(std::unique_ptr<SpriteWorker>(new SpriteWorker()));
+        if (!workers.back()->reader.attachFace(face)) return false;
+    }
+
+    int numGlyphs = workers[0]->reader.getNumGlyphs();
+    int first = std::max(0, options.firstGlyph);
+    int last = options.glyphCount < 0 ? numGlyphs : std::min(numGlyphs, first + options.glyphCount);
+    if (first >= last) return false;
+    int chunk = std::max(1, options.glyphsPerTask);
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Each task owns one chunk slot, so recording where its output went needs no lock
+    std::vector<SpriteChunk> chunks((last - first + chunk - 1) / chunk);
+    for (size_t c = 0; c < chunks.size(); c++) {
+        int begin = first + static_cast<int>(c) * chunk;
+        int end = std::min(last, begin + chunk);
+        pool.submit([&workers, &chunks, &options, c, begin, end](unsigned worker) {
+            SpriteWorker& context = *workers[worker];
+            size_t offset = context.buffer.size();
+            for (int glyphIndex = begin; glyphIndex < end; glyphIndex++) {
+                context.arena.reset();
+                if (!context.reader.loadOutline(glyphIndex, context.arena, context.glyph)) {
+                    context.failedGlyphs++;
+                    continue;
+                }
+                appendSymbol(context.buffer, context.glyph, glyphIndex, options.idPrefix);
+                context.glyphs++;
+            }
+            chunks[c] = SpriteChunk{worker, offset, context.buffer.size() - offset};
+        });
+    }
+    pool.wait();
+
+    std::FILE* file = std::fopen(filename.c_str(), "wb");
+    if (!file) return false;
+
+    static const char prologue[] = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                                   "<svg xmlns=\"http://www.w3.org/2000/svg\" style=\"display:none\">\n";
+    static const char epilogue[] = "</svg>\n";
+    bool written = std::fwrite(prologue, 1, sizeof(prologue) - 1, file) == sizeof(prologue) - 1;
+    result.bytes = sizeof(prologue) - 1;
+    for (const SpriteChunk& slice : chunks) {
+        if (!written) break;
+        if (slice.length == 0) continue;
+        written = std::fwrite(workers[slice.worker]->buffer.data() + slice.offset, 1, slice.length, file) == slice.length;
+        result.bytes += slice.length;
+    }
+    written = written && std::fwrite(epilogue, 1, sizeof(epilogue) - 1, file) == sizeof(epilogue) - 1;
+    result.bytes += sizeof(epilogue) - 1;
+    written = std::fclose(file) == 0 && written;
+
+    for (const auto& worker : workers) {
+        result.glyphs += worker->glyphs;
+        result.failedGlyphs += worker->failedGlyphs;
+    }
+    result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return written;
+}
@@ -0,0 +1,71 @@
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "glyph_outline.h"
+
+// Growable text buffer for SVG output. Numbers are formatted with
+// std::to_chars straight into the buffer - no streams, no locale, no
+// temporaries. clear() keeps the capacity, so one buffer serves any number
+// of documents without allocating again.
+class SvgBuffer {
+private:
+    std::vector<char> storage;
+    size_t used = 0;
+
+    char* reserve(size_t bytes);    // Room for at least bytes more; returns the write position
+
+public:
+    explicit SvgBuffer(size_t capacity = 64 * 1024) : storage(capacity) {}
+
+    void clear() { used = 0; }
+    const char* data() const { return storage.data(); }
+    size_t size() const { return used; }
+
+    void append(const char* text, size_t length);
+    void append(const char* text);
+    void append(char c);
+    void appendInt(long value);
+    void appendNumber(float value);     // Shortest round-trip form; "12" for whole numbers
+
+    bool writeTo(std::FILE* file) const;
+    bool writeFile(const std::string& filename) const;
+};
+
+// Path data ("M x y L x y Q cx cy x y Z ...") for every contour, relative to
+// the origin. flipY negates y so the path can be used in SVG's y-down space
+// without a transform.
+void appendGlyphPath(SvgBuffer& out, const GlyphOutline& glyph, float originX, float originY, bool flipY);
+
+// A standalone debug document: numbered points plus the outline, either as
+// straight-line polygons or as the real quadratic curves
+void appendGlyphSVG(SvgBuffer& out, const GlyphOutline& glyph, bool curves);
+
+// Formats into buffer (cleared first) and writes filename in one call
+bool writeGlyphSVG(const GlyphOutline& glyph, const std::string& filename, bool curves, SvgBuffer& buffer);
+
+struct SvgSpriteOptions {
+    int firstGlyph = 0;
+    int glyphCount = -1;                // -1 = every glyph from firstGlyph on
+    unsigned threads = 0;               // 0 = one per hardware thread
+    int glyphsPerTask = 64;
+    std::string idPrefix = "glyph-";    // Symbol ids are idPrefix + glyph index
+};
+
+struct SvgSpriteResult {
+    uint64_t glyphs = 0;            // Symbols written (empty glyphs included)
+    uint64_t failedGlyphs = 0;      // Undecodable; left out of the sprite
+    uint64_t bytes = 0;
+    double wallSeconds = 0;
+};
+
+// Writes a glyph range as one SVG sprite: a <symbol> per glyph with a
+// font-unit viewBox, usable as <use href="#glyph-N"/>. Workers format their
+// chunks into their own buffers and the chunks are written out in glyph
+// order, so the file is identical for any thread count.
+bool exportFontSprite(const std::string& fontPath, const std::string& filename,
+                      const SvgSpriteOptions& options, SvgSpriteResult& result);
+
+#endif
@@ -0,0 +1,160 @@
+#include "text_layout.h"
+#include "kerning.h"
+#include "glyph_bounds.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+bool HorizontalMetrics::build(ByteSpan hhea, ByteSpan hmtx, uint16_t numGlyphs) {
+    advances.clear();
+    leftSideBearings.clear();
+
+    uint16_t numberOfHMetrics;
+    if (!hhea.contains(0, 36) || !hhea.readU16(34, numberOfHMetrics)) return false;
+    if (numberOfHMetrics == 0) return false;
+
+    ascender = hhea.i16(4);
+    descender = hhea.i16(6);
+    lineGap = hhea.i16(8);
+
+    // Full records first, then bare left side bearings for the monospaced tail
+    size_t fullRecords = std::min<size_t>(numberOfHMetrics, numGlyphs);
+    if (!hmtx.contains(0, fullRecords * 4)) return false;
+
+    advances.resize(numGlyphs);
+    leftSideBearings.resize(numGlyphs);
+
+    for (size_t g = 0; g < fullRecords; g++) {
+        advances[g] = hmtx.u16(g * 4);
+        leftSideBearings[g] = hmtx.i16(g * 4 + 2);
+    }
+
+    uint16_t lastAdvance = fullRecords > 0 ? advances[fullRecords - 1] : 0;
+    size_t bearingBase = static_cast<size_t>(numberOfHMetrics) * 4;
+    for (size_t g = fullRecords; g < numGlyphs; g++) {
+        advances[g] = lastAdvance;
+        int16_t lsb = 0;
+        hmtx.readI16(bearingBase + (g - fullRecords) * 2, lsb); // Missing tail -> 0
+        leftSideBearings[g] = lsb;
+    }
+    return true;
+}
+
+float layoutGlyphRun(const uint16_t* glyphs, size_t count, const HorizontalMetrics& metrics,
+                     float scale, float* penX, const KerningTable* kerning) {
+    float pen = 0.0f;
+    if (kerning && !kerning->empty()) {
+        for (size_t i = 0; i < count; i++) {
+            penX[i] = pen;
+            int32_t advance = metrics.advanceWidth(glyphs[i]);
+            if (i + 1 < count) advance += kerning->pairValue(glyphs[i], glyphs[i + 1]);
+            pen += advance * scale;
+        }
+        return pen;
+    }
+    for (size_t i = 0; i < count; i++) {
+        penX[i] = pen;
+        pen += metrics.advanceWidth(glyphs[i]) * scale;
+    }
+    return pen;
+}
+
+bool measureRunInk(const uint16_t* glyphs, size_t count, const float* penX, float scale,
+                   const GlyphBoundsTable& bounds, InkBounds& ink) {
+    bool inked = false;
+    GlyphHeader header;
+    for (size_t i = 0; i < count; i++) {
+        if (bounds.isEmpty(glyphs[i]) || !bounds.getBounds(glyphs[i], header)) continue;     // Spaces
+        float x0 = penX[i] + header.xMin * scale;
+        float x1 = penX[i] + header.xMax * scale;
+        float y0 = header.yMin * scale;
+        float y1 = header.yMax * scale;
+        if (!inked) {
+            ink.xMin = x0;
+            ink.xMax = x1;
+            ink.yMin = y0;
+            ink.yMax = y1;
+            inked = true;
+        } else {
+            ink.xMin = std::min(ink.xMin, x0);
+            ink.xMax = std::max(ink.xMax, x1);
+            ink.yMin = std::min(ink.yMin, y0);
+            ink.yMax = std::max(ink.yMax, y1);
+        }
+    }
+    return inked;
+}
+
+TextRenderer::TextRenderer(TTFReader& reader, const HorizontalMetrics& metrics)
+    : reader(reader), metrics(metrics) {
+}
+
+LineMetrics TextRenderer::measureLine(const uint16_t* glyphs, size_t count, float pixelSize) {
+    LineMetrics line;
+    uint16_t unitsPerEm = reader.getUnitsPerEm();
+    if (unitsPerEm == 0) return line;
+    float scale = pixelSize / unitsPerEm;
+
+    if (positions.size() < count) positions.resize(count);
+    line.advance = layoutGlyphRun(glyphs, count, metrics, scale, positions.data(), kerning);
+
+    int ascent = static_cast<int>(std::ceil(metrics.getAscender() * scale));
+    int descent = static_cast<int>(std::ceil(-metrics.getDescender() * scale));
+    line.width = static_cast<int>(std::ceil(line.advance));
+    line.height = std::max(0, ascent + descent);
+    line.baseline = ascent;
+    return line;
+}
+
+bool TextRenderer::renderLine(const uint16_t* glyphs, size_t count, float pixelSize,
+                              GlyphBitmap& out, LineMetrics* lineMetrics) {
+    LineMetrics line = measureLine(glyphs, count, pixelSize);
+    if (lineMetrics) *lineMetrics = line;
+    if (!out.pixels || out.stride < out.width) return false;
+
+    for (int y = 0; y < out.height; y++) {
+        std::memset(out.pixels + static_cast<size_t>(y) * out.stride, 0, out.width);
+    }
+
+    uint16_t unitsPerEm = reader.getUnitsPerEm();
+    for (size_t i = 0; i < count; i++) {
+        std::shared_ptr<const StoredOutline> glyph = reader.acquireGlyph(glyphs[i]);
+        if (!glyph || glyph->empty()) continue; // Spaces, missing glyphs
+
+        // Whole pixels go into the blit position, the fraction into the raster
+        float pen = positions[i];
+        float penWhole = std::floor(pen);
+        RasterPlacement placement = computeRasterPlacement(glyph->header, pixelSize, unitsPerEm, pen - penWhole, 0.0f);
+        if (placement.width <= 0 || placement.height <= 0) continue;
+
+        size_t cells = rasterScratchCells(placement);
+        size_t pixelCount = static_cast<size_t>(placement.width) * placement.height;
+        if (scratch.size() < cells) scratch.resize(cells);
+        if (glyphPixels.size() < pixelCount) glyphPixels.resize(pixelCount);
+
+        GlyphBitmap glyphBitmap;
+        glyphBitmap.pixels = glyphPixels.data();
+        glyphBitmap.width = placement.width;
+        glyphBitmap.height = placement.height;
+        glyphBitmap.stride = placement.width;
+        if (!rasterizeGlyph(*glyph, placement, scratch.data(), scratch.size(), glyphBitmap)) continue;
+
+        // Composite with a saturating add so touching edges sum to full coverage
+        int originX = static_cast<int>(penWhole) + placement.left;
+        int originY = line.baseline - placement.top;
+        int x0 = std::max(0, -originX);
+        int x1 = std::min(placement.width, out.width - originX);
+        int y0 = std::max(0, -originY);
+        int y1 = std::min(placement.height, out.height - originY);
+
+        for (int y = y0; y < y1; y++) {
+            const uint8_t* src = glyphPixels.data() + static_cast<size_t>(y) * placement.width;
+            uint8_t* dst = out.pixels + static_cast<size_t>(originY + y) * out.stride + originX;
+            for (int x = x0; x < x1; x++) {
+                int sum = dst[x] + src[x];
+                dst[x] = static_cast<uint8_t>(sum > 255 ? 255 : sum);
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef TEXT_LAYOUT_H
+#define TEXT_LAYOUT_H
+
+#include "rasterizer.h"
+
+class KerningTable;
+class GlyphBoundsTable;
+
+// Horizontal metrics from 'hhea' + 'hmtx', expanded to one entry per glyph
+// so lookups are a plain array index.
+class HorizontalMetrics {
+private:
+    std::vector<uint16_t> advances;
+    std::vector<int16_t> leftSideBearings;
+    int16_t ascender = 0;
+    int16_t descender = 0;
+    int16_t lineGap = 0;
+
+public:
+    // numGlyphs comes from 'maxp'; glyphs past numberOfHMetrics reuse the last advance
+    bool build(ByteSpan hhea, ByteSpan hmtx, uint16_t numGlyphs);
+
+    size_t glyphCount() const { return advances.size(); }
+    uint16_t advanceWidth(uint16_t glyph) const { return glyph < advances.size() ? advances[glyph] : 0; }
+    int16_t leftSideBearing(uint16_t glyph) const {
+        return glyph < leftSideBearings.size() ? leftSideBearings[glyph] : 0;
+    }
+    int16_t getAscender() const { return ascender; }
+    int16_t getDescender() const { return descender; }    // Negative below the baseline
+    int16_t getLineGap() const { return lineGap; }
+};
+
+// Lays a run of glyphs along one baseline. Writes each glyph's pen position
+// (pixels from the line start) to penX and returns the total advance. With
+// kerning, each pair's adjustment is added after the left glyph's advance.
+// Pure arithmetic over caller-provided arrays - no allocation, no font access.
+float layoutGlyphRun(const uint16_t* glyphs, size_t count, const HorizontalMetrics& metrics,
+                     float scale, float* penX, const KerningTable* kerning = nullptr);
+
+// Pixel box around the ink of a laid-out run, x from the line start, y up
+// from the baseline
+struct InkBounds {
+    float xMin = 0;
+    float yMin = 0;
+    float xMax = 0;
+    float yMax = 0;
+};
+
+// Union of the glyph boxes at their pen positions (penX from layoutGlyphRun).
+// Boxes come from the table, so no outline is decoded. False if nothing in
+// the run has ink.
+bool measureRunInk(const uint16_t* glyphs, size_t count, const float* penX, float scale,
+                   const GlyphBoundsTable& bounds, InkBounds& ink);
+
+// Pixel size of a laid-out line
+struct LineMetrics {
+    int width = 0;
+    int height = 0;
+    int baseline = 0;       // Rows from the top of the bitmap to the baseline
+    float advance = 0;
+};
+
+// Renders runs of glyphs into one line bitmap. Scratch buffers live in the
+// renderer and only grow, so rendering many short labels stops allocating
+// after the first few. Glyphs come from TTFReader::acquireGlyph, so attach a
+// GlyphCache to the reader to skip re-decoding repeated glyphs.
+class TextRenderer {
+private:
+    TTFReader& reader;
+    const HorizontalMetrics& metrics;
+    const KerningTable* kerning = nullptr;
+    std::vector<float> positions;
+    std::vector<int32_t> scratch;
+    std::vector<uint8_t> glyphPixels;
+
+public:
+    TextRenderer(TTFReader& reader, const HorizontalMetrics& metrics);
+
+    // Kerns lines from now on; null turns it off. The table must outlive its use.
+    void setKerning(const KerningTable* table) { kerning = table; }
+
+    // Bitmap size needed for the line; also leaves the layout in positions
+    LineMetrics measureLine(const uint16_t* glyphs, size_t count, float pixelSize);
+
+    // Lays out and composites the glyphs into out (cleared first). Glyphs
+    // are placed at subpixel x positions; anything past the edges is clipped.
+    bool renderLine(const uint16_t* glyphs, size_t count, float pixelSize,
+                    GlyphBitmap& out, LineMetrics* lineMetrics = nullptr);
+};
+
+#endif
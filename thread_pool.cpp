@@ -0,0 +1,123 @@
+#include "thread_pool.h"
+
+// Lets submit() from inside a task push onto the running worker's own deque
+static thread_local const WorkStealingPool* currentPool = nullptr;
+static thread_local unsigned currentWorker = 0;
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0) threadCount = 1;
+
+    queues.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void WorkStealingPool::submit(Task task) {
+    unsigned target;
+    if (currentPool == this) {
+        target = currentWorker;
+    } else {
+        target = nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    }
+
+    // Count first so wait() can't miss a task that is about to be queued
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        unfinished++;
+        queued.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        WorkerQueue& queue = *queues[target];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    allDone.wait(lock, [this] { return unfinished == 0; });
+}
+
+std::vector<WorkerTaskStats> WorkStealingPool::getTaskStats() const {
+    std::vector<WorkerTaskStats> stats;
+    stats.reserve(queues.size());
+    for (const std::unique_ptr<WorkerQueue>& queue : queues) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        stats.push_back(queue->stats);
+    }
+    return stats;
+}
+
+bool WorkStealingPool::popLocal(unsigned worker, Task& task) {
+    WorkerQueue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    queue.stats.executed++;
+    return true;
+}
+
+bool WorkStealingPool::steal(unsigned thief, Task& task) {
+    // Start at the neighbour so thieves spread out instead of all hitting queue 0
+    unsigned count = size();
+    for (unsigned i = 1; i < count; i++) {
+        WorkerQueue& victim = *queues[(thief + i) % count];
+        std::unique_lock<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        lock.unlock();
+
+        WorkerQueue& own = *queues[thief];
+        std::lock_guard<std::mutex> ownLock(own.mutex);
+        own.stats.executed++;
+        own.stats.stolen++;
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(unsigned worker) {
+    currentPool = this;
+    currentWorker = worker;
+
+    Task task;
+    for (;;) {
+        if (popLocal(worker, task) || steal(worker, task)) {
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            task(worker);
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            if (--unfinished == 0) allDone.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        if (queued.load(std::memory_order_relaxed) > 0) {
+            // Counted but not pushed yet - the submitter is mid-call
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        if (stopping) return;
+        workAvailable.wait(lock, [this] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+    }
+}
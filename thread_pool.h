@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Per-worker task counters
+struct WorkerTaskStats {
+    uint64_t executed = 0;
+    uint64_t stolen = 0;     // Of those, taken from another worker's queue
+};
+
+// Fixed-size pool where every worker owns a task deque. Owners pop from the
+// back (newest, cache-warm); idle workers steal from the front of someone
+// else's deque (oldest, usually the biggest remaining chunk). Uneven tasks -
+// a period next to a complex ideograph - then balance out on their own.
+class WorkStealingPool {
+public:
+    // Task receives the index of the worker running it (0..size()-1)
+    typedef std::function<void(unsigned worker)> Task;
+
+    explicit WorkStealingPool(unsigned threadCount = 0);   // 0 = one per hardware thread
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    // Queues a task. From inside a worker it goes to that worker's own deque,
+    // otherwise queues are filled round-robin.
+    void submit(Task task);
+
+    // Blocks until every submitted task has finished
+    void wait();
+
+    std::vector<WorkerTaskStats> getTaskStats() const;
+
+private:
+    struct alignas(64) WorkerQueue {
+        mutable std::mutex mutex;
+        std::deque<Task> tasks;
+        WorkerTaskStats stats;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    std::atomic<size_t> queued{0};      // Tasks sitting in a deque
+    size_t unfinished = 0;              // Submitted but not completed (guarded by sleepMutex)
+    bool stopping = false;              // Guarded by sleepMutex
+    std::atomic<unsigned> nextQueue{0};
+
+    void workerLoop(unsigned worker);
+    bool popLocal(unsigned worker, Task& task);
+    bool steal(unsigned thief, Task& task);
+};
+
+#endif
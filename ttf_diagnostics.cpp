@@ -0,0 +1,223 @@
+#include "ttf_diagnostics.h"
+#include <iomanip>
+
+void printHeader(const TTFHeader& header, std::ostream& out) {
+    out << "TTF Header:\n";
+    out << "  scalerType: 0x" << std::hex << header.scalerType << std::dec;
+    if (header.scalerType == 0x00010000) {
+        out << " (TrueType)\n";
+    } else {
+        out << " (Unknown)\n";
+    }
+    out << "  numTables: " << header.numTables << '\n';
+}
+
+void printTableEntry(const TableEntry& entry, std::ostream& out) {
+    out << "  Table: " << entry.tag 
+        << ", Offset: " << entry.offset 
+        << ", Length: " << entry.length << '\n';
+}
+
+void printVariationAxes(const FontVariations& variations, std::ostream& out) {
+    out << "Variation axes: " << variations.getAxes().size() << '\n';
+    for (const VariationAxis& axis : variations.getAxes()) {
+        out << "  " << axis.tag << ": " << axis.minValue << " - " << axis.maxValue
+            << " (default " << axis.defaultValue << ")" << ((axis.flags & 1) ? ", hidden" : "") << '\n';
+    }
+    out << "Named instances: " << variations.getNamedInstances().size() << '\n';
+    for (const NamedInstance& instance : variations.getNamedInstances()) {
+        out << "  name " << instance.subfamilyNameId << ":";
+        for (float value : instance.coordinates) {
+            out << ' ' << value;
+        }
+        out << '\n';
+    }
+}
+
+void printHexDump(const std::vector<uint8_t>& data, size_t offset, std::ostream& out) {
+    out << "Hex dump (" << data.size() << " bytes):\n";
+    
+    for (size_t i = 0; i < data.size(); i += 16) {
+        // Print offset
+        out << std::setfill('0') << std::setw(8) << std::hex << (offset + i) << ": ";
+        
+        // Print hex bytes
+        for (size_t j = 0; j < 16 && (i + j) < data.size(); j++) {
+            out << std::setfill('0') << std::setw(2) << std::hex 
+                << static_cast<int>(data[i + j]) << " ";
+        }
+        out << '\n';
+    }
+    out << std::dec; // Reset to decimal
+}
+
+void printGlyph(const GlyphOutline& glyph, std::ostream& out) {
+    out << "Glyph Info:\n";
+    out << "  Contours: " << glyph.header.numberOfContours << '\n';
+    out << "  Bounding box: (" << glyph.header.xMin << ", " << glyph.header.yMin 
+        << ") to (" << glyph.header.xMax << ", " << glyph.header.yMax << ")\n";
+    
+    out << "  End points: ";
+    for (size_t i = 0; i < glyph.contourCount; i++) {
+        out << glyph.endPts[i] << " ";
+    }
+    out << '\n';
+    
+    out << "  Points:\n";
+    for (size_t i = 0; i < glyph.pointCount; i++) {
+        out << "    " << i << ": (" << glyph.xs[i] << ", " << glyph.ys[i] 
+            << ") " << (glyph.onCurve(i) ? "ON" : "OFF") << '\n';
+    }
+}
+
+void plotGlyph(const GlyphOutline& glyph, int width, int height, std::ostream& out) {
+    if (glyph.empty()) return;
+    
+    std::vector<std::vector<char>> grid(height, std::vector<char>(width, ' '));
+    
+    int16_t xRange = glyph.header.xMax - glyph.header.xMin;
+    int16_t yRange = glyph.header.yMax - glyph.header.yMin;
+    
+    if (xRange == 0 || yRange == 0) return;
+    
+    for (size_t i = 0; i < glyph.pointCount; i++) {
+        int x = ((glyph.xs[i] - glyph.header.xMin) * (width - 1)) / xRange;
+        int y = height - 1 - ((glyph.ys[i] - glyph.header.yMin) * (height - 1)) / yRange;
+        
+        // Bounds check
+        if (x >= 0 && x < width && y >= 0 && y < height) {
+            grid[y][x] = glyph.onCurve(i) ? '*' : 'o';
+        }
+    }
+    
+    // Print grid
+    out << "\nGlyph Plot (" << width << "x" << height << "):\n";
+    out << "* = on-curve points, o = off-curve (control) points\n";
+    
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            out << grid[y][x];
+        }
+        out << '\n';
+    }
+}
+
+bool printGlyphsSequential(TTFReader& reader, int count, std::ostream& out) {
+    OutlineArena arena;
+    for (int i = 0; i < count; i++) {
+        out << "\n--- Parsing glyph " << i << " ---\n";
+        
+        // Save current position
+        size_t currentPos = reader.getCursor();
+        
+        SimpleGlyph glyph;
+        GlyphOutline outline;
+        arena.reset();
+        if (reader.readSimpleGlyph(glyph) && outlineFromGlyph(glyph, arena, outline)) {
+            out << "Glyph " << i << ":\n";
+            printGlyph(outline, out);
+            plotGlyph(outline, 80, 40, out);
+            
+            std::string filename = "glyph_" + std::to_string(i) + ".svg";
+            if (reader.exportGlyphSVG(outline, filename)) out << "SVG exported to: " << filename << '\n';
+        } else {
+            out << "Failed to parse glyph " << i << " - trying to skip ahead\n";
+            
+            // Go back to where we started and skip a reasonable amount
+            if (!reader.setCursor(currentPos + 100)) {
+                out << "Reached end of glyph data\n";
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void explainLocaTable(TTFReader& reader, std::ostream& out) {
+    out << "\n=== Understanding 'loca' table ===\n";
+    
+    // Step 1: Check format in head table
+    TableEntry headEntry;
+    if (!reader.findTable("head", headEntry)) {
+        out << "No 'head' table found\n";
+        return;
+    }
+    
+    out << "Found 'head' table at offset: " << headEntry.offset << '\n';
+    
+    // Read indexToLocFormat (at offset 50 in head table)
+    int16_t indexToLocFormat;
+    if (!reader.tableData(&headEntry).readI16(50, indexToLocFormat)) {
+        out << "'head' table is truncated\n";
+        return;
+    }
+    
+    bool isLongFormat = (indexToLocFormat == 1);
+    out << "Format: " << (isLongFormat ? "Long (4 bytes)" : "Short (2 bytes)") << '\n';
+    
+    // Step 2: Read loca table
+    TableEntry locaEntry;
+    if (!reader.findTable("loca", locaEntry)) {
+        out << "No 'loca' table found\n";
+        return;
+    }
+    
+    out << "Found 'loca' table at offset: " << locaEntry.offset 
+        << ", length: " << locaEntry.length << '\n';
+    
+    // Calculate number of glyphs
+    size_t entrySize = isLongFormat ? 4 : 2;
+    size_t numEntries = locaEntry.length / entrySize;
+    size_t numGlyphs = numEntries - 1; // Last entry is end marker
+    
+    out << "Number of glyphs: " << numGlyphs << '\n';
+    
+    // Read first 10 entries as example
+    ByteSpan loca = reader.tableData(&locaEntry);
+    if (loca.empty()) {
+        out << "'loca' table runs past end of file\n";
+        return;
+    }
+    out << "\nFirst 10 glyph locations:\n";
+    
+    for (int i = 0; i < 10 && i < static_cast<int>(numEntries); i++) {
+        uint32_t offset;
+        
+        if (isLongFormat) {
+            offset = loca.u32(i * 4);
+        } else {
+            offset = loca.u16(i * 2) * 2; // Convert to actual offset
+        }
+        
+        out << "  Glyph " << i << ": starts at offset " << offset << '\n';
+    }
+}
+
+void printGlyphsByIndex(TTFReader& reader, int startIndex, int count, std::ostream& out) {
+    OutlineArena arena;
+    for (int i = 0; i < count; i++) {
+        int glyphIndex = startIndex + i;
+        out << "\n=== Reading Glyph " << glyphIndex << " ===\n";
+        
+        SimpleGlyph glyph;
+        GlyphOutline outline;
+        arena.reset();
+        if (reader.readGlyphByIndex(glyphIndex, glyph) && outlineFromGlyph(glyph, arena, outline)) {
+            printGlyph(outline, out);
+            plotGlyph(outline, 80, 40, out);
+            
+            std::string filename = "glyph_" + std::to_string(glyphIndex) + ".svg";
+            if (reader.exportGlyphSVG(outline, filename)) out << "SVG exported to: " << filename << '\n';
+        } else {
+            out << "Failed to read glyph " << glyphIndex << " (" << readerStatusName(reader.getLastStatus()) << ")\n";
+        }
+    }
+}
+
+void consoleLogSink(LogLevel level, const char* message, void*) {
+    if (level >= LogLevel::Warning) {
+        std::cerr << message << std::endl;
+    } else {
+        std::cout << message << '\n';
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef TTF_DIAGNOSTICS_H
+#define TTF_DIAGNOSTICS_H
+
+#include <iostream>
+#include "ttf_reader.h"
+
+// Human-readable dumps for the command-line tool and for debugging. Kept out
+// of TTFReader so the library itself never writes to a console; everything
+// here prints to the stream it's given.
+
+void printHeader(const TTFHeader& header, std::ostream& out = std::cout);
+void printTableEntry(const TableEntry& entry, std::ostream& out = std::cout);
+void printHexDump(const std::vector<uint8_t>& data, size_t offset = 0, std::ostream& out = std::cout);
+
+void printGlyph(const GlyphOutline& glyph, std::ostream& out = std::cout);
+void plotGlyph(const GlyphOutline& glyph, int width = 80, int height = 40, std::ostream& out = std::cout);
+
+// 'fvar' axes (tag, range, default) and named instance coordinates
+void printVariationAxes(const FontVariations& variations, std::ostream& out = std::cout);
+
+// Walks through the 'head' format flag and the first 'loca' entries
+void explainLocaTable(TTFReader& reader, std::ostream& out = std::cout);
+
+// Print, plot and export (glyph_N.svg) a run of glyphs: sequentially from the
+// reader's cursor, skipping ahead on bad data, or by glyph index via 'loca'
+bool printGlyphsSequential(TTFReader& reader, int count, std::ostream& out = std::cout);
+void printGlyphsByIndex(TTFReader& reader, int startIndex, int count, std::ostream& out = std::cout);
+
+// LogSink for TTFReader::setLogSink: warnings and errors to std::cerr,
+// everything else to std::cout. Ignores the context.
+void consoleLogSink(LogLevel level, const char* message, void* context);
+
+#endif
@@ -1,539 +1,741 @@
 #include "ttf_reader.h"
-#include <iomanip>
+#include "glyph_cache.h"
+#include "char_map.h"
+#include "text_layout.h"
+#include "kerning.h"
+#include "glyph_bounds.h"
+#include "point_decode.h"
+#include "font_pack.h"
+#include "instrumentation.h"
+#include <cstdarg>
+#include <cstdio>
+#include <algorithm>
 
 TTFReader::TTFReader() {
-    littleEndian = isLittleEndian();
 }
 
 TTFReader::~TTFReader() {
     close();
 }
 
-bool TTFReader::isLittleEndian() {
-    uint16_t test = 1;
-    return reinterpret_cast<uint8_t*>(&test)[0] == 1;
+bool TTFReader::openFont(const std::string& filename) {
+    close();
+    std::shared_ptr<FontFace> privateFace = std::make_shared<FontFace>();
+    if (!privateFace->open(filename)) {
+        if (privateFace->getOpenStatus() == ReaderStatus::OpenFailed) {
+            if (logging(LogLevel::Error)) logMessage(LogLevel::Error, "Cannot open font file %s", filename.c_str());
+        } else if (logging(LogLevel::Error)) {
+            logMessage(LogLevel::Error, "%s has no valid table directory", filename.c_str());
+        }
+        return fail(privateFace->getOpenStatus());
+    }
+    return attachFace(std::move(privateFace));
 }
 
-uint16_t TTFReader::swapUint16(uint16_t val) {
-    return (val << 8) | (val >> 8);
+bool TTFReader::attachFace(std::shared_ptr<const FontFace> sharedFace) {
+    close();
+    if (!sharedFace || !sharedFace->isOpen()) return fail(ReaderStatus::OpenFailed);
+    
+    face = std::move(sharedFace);
+    fontData = face->bytes();
+    loca = face->getLoca();
+    lastStatus = ReaderStatus::Ok;
+    return true;
 }
 
-uint32_t TTFReader::swapUint32(uint32_t val) {
-    return (val << 24) | ((val & 0x0000FF00) << 8) | 
-           ((val & 0x00FF0000) >> 8) | (val >> 24);
+void TTFReader::close() {
+    face.reset();
+    fontData = ByteSpan();
+    cursor = 0;
+    loca = LocaTable();
+    glyphOffsets.clear();
+    fontPack = nullptr;
+    variationInstance.reset();
+    componentCache.clear();
+    compositeStack.clear();
 }
 
-bool TTFReader::openFont(const std::string& filename) {
-    file.open(filename, std::ios::binary);
-    return file.is_open();
+void TTFReader::setLogSink(LogSink sink, void* context, LogLevel minLevel) {
+    logSink = sink;
+    logContext = context;
+    logLevel = minLevel;
 }
 
-void TTFReader::close() {
-    if (file.is_open()) {
-        file.close();
-    }
+void TTFReader::logMessage(LogLevel level, const char* format, ...) const {
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    std::vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    logSink(level, message, logContext);
 }
 
 bool TTFReader::readHeader(TTFHeader& header) {
-    if (!file.good()) return false;
+    if (!fontData.contains(cursor, 12)) return false;
     
-    file.read(reinterpret_cast<char*>(&header.scalerType), 4);
-    file.read(reinterpret_cast<char*>(&header.numTables), 2);
-    file.read(reinterpret_cast<char*>(&header.searchRange), 2);
-    file.read(reinterpret_cast<char*>(&header.entrySelector), 2);
-    file.read(reinterpret_cast<char*>(&header.rangeShift), 2);
+    header.scalerType = fontData.u32(cursor);
+    header.numTables = fontData.u16(cursor + 4);
+    header.searchRange = fontData.u16(cursor + 6);
+    header.entrySelector = fontData.u16(cursor + 8);
+    header.rangeShift = fontData.u16(cursor + 10);
+    cursor += 12;
+    TTF_COUNT(BytesRead, 12);
     
-    if (littleEndian) {
-        header.scalerType = swapUint32(header.scalerType);
-        header.numTables = swapUint16(header.numTables);
-        header.searchRange = swapUint16(header.searchRange);
-        header.entrySelector = swapUint16(header.entrySelector);
-        header.rangeShift = swapUint16(header.rangeShift);
-    }
-    
-    return file.good();
+    return true;
 }
 
 bool TTFReader::readTableEntry(TableEntry& entry) {
-    if (!file.good()) return false;
+    if (!fontData.contains(cursor, 16)) return false;
     
-    file.read(entry.tag, 4);
+    for (int i = 0; i < 4; i++) {
+        entry.tag[i] = static_cast<char>(fontData.u8(cursor + i));
+    }
     entry.tag[4] = '\0';  // Null terminate
     
-    file.read(reinterpret_cast<char*>(&entry.checksum), 4);
-    file.read(reinterpret_cast<char*>(&entry.offset), 4);
-    file.read(reinterpret_cast<char*>(&entry.length), 4);
+    entry.checksum = fontData.u32(cursor + 4);
+    entry.offset = fontData.u32(cursor + 8);
+    entry.length = fontData.u32(cursor + 12);
+    cursor += 16;
+    TTF_COUNT(BytesRead, 16);
     
-    if (littleEndian) {
-        entry.checksum = swapUint32(entry.checksum);
-        entry.offset = swapUint32(entry.offset);
-        entry.length = swapUint32(entry.length);
-    }
-    
-    return file.good();
+    return true;
 }
 
-void TTFReader::printHeader(const TTFHeader& header) {
-    std::cout << "TTF Header:" << std::endl;
-    std::cout << "  scalerType: 0x" << std::hex << header.scalerType << std::dec;
-    if (header.scalerType == 0x00010000) {
-        std::cout << " (TrueType)" << std::endl;
-    } else {
-        std::cout << " (Unknown)" << std::endl;
-    }
-    std::cout << "  numTables: " << header.numTables << std::endl;
-}
 
-void TTFReader::printTableEntry(const TableEntry& entry) {
-    std::cout << "  Table: " << entry.tag 
-              << ", Offset: " << entry.offset 
-              << ", Length: " << entry.length << std::endl;
-}
 
+const std::vector<TableEntry>& TTFReader::getTableEntries() const {
+    static const std::vector<TableEntry> none;
+    return face ? face->getTableEntries() : none;
+}
 
 bool TTFReader::findTable(const std::string& tableName, TableEntry& entry) {
-    // Reset to start of file and skip header
-    file.seekg(12, std::ios::beg);
-    
-    TTFHeader header;
-    file.seekg(0, std::ios::beg);
-    if (!readHeader(header)) return false;
-    
-    // Search through table entries
-    for (int i = 0; i < header.numTables; i++) {
-        TableEntry tempEntry;
-        if (readTableEntry(tempEntry)) {
-            if (std::string(tempEntry.tag) == tableName) {
-                entry = tempEntry;
-                return true;
-            }
-        }
-    }
-    return false;
+    const TableEntry* found = lookupTable(tagFromString(tableName));
+    if (!found) return false;
+    entry = *found;
+    return true;
 }
 
 bool TTFReader::seekToTable(const std::string& tableName) {
-    TableEntry entry;
-    if (findTable(tableName, entry)) {
-        file.seekg(entry.offset, std::ios::beg);
+    const TableEntry* entry = lookupTable(tagFromString(tableName));
+    if (entry && entry->offset <= fontData.size) {
+        TTF_COUNT(Seeks, 1);
+        cursor = entry->offset;
         return true;
     }
     return false;
 }
 
+bool TTFReader::setCursor(size_t offset) {
+    if (offset >= fontData.size) return false;
+    TTF_COUNT(Seeks, 1);
+    cursor = offset;
+    return true;
+}
+
 std::vector<uint8_t> TTFReader::readBytes(size_t count) {
-    std::vector<uint8_t> data(count);
-    file.read(reinterpret_cast<char*>(data.data()), count);
+    // Clamp to what's left in the file, like a short stream read
+    size_t available = cursor < fontData.size ? fontData.size - cursor : 0;
+    if (count > available) count = available;
     
-    // Resize to actual bytes read
-    data.resize(file.gcount());
+    std::vector<uint8_t> data(fontData.data + cursor, fontData.data + cursor + count);
+    cursor += count;
+    TTF_COUNT(BytesRead, count);
     return data;
 }
 
-void TTFReader::printHexDump(const std::vector<uint8_t>& data, size_t offset) {
-    std::cout << "Hex dump (" << data.size() << " bytes):" << std::endl;
-    
-    for (size_t i = 0; i < data.size(); i += 16) {
-        // Print offset
-        std::cout << std::setfill('0') << std::setw(8) << std::hex << (offset + i) << ": ";
-        
-        // Print hex bytes
-        for (size_t j = 0; j < 16 && (i + j) < data.size(); j++) {
-            std::cout << std::setfill('0') << std::setw(2) << std::hex 
-                      << static_cast<int>(data[i + j]) << " ";
-        }
-        std::cout << std::endl;
+bool TTFReader::readGlyphHeader(GlyphHeader& header) {
+    if (!fontData.contains(cursor, 10)) return false;
+    
+    header.numberOfContours = fontData.i16(cursor);
+    header.xMin = fontData.i16(cursor + 2);
+    header.yMin = fontData.i16(cursor + 4);
+    header.xMax = fontData.i16(cursor + 6);
+    header.yMax = fontData.i16(cursor + 8);
+    cursor += 10;
+    return true;
+}
+
+bool TTFReader::readSimpleGlyph(SimpleGlyph& glyph) {
+    if (cursor >= fontData.size) return fail(ReaderStatus::GlyphOutOfRange);
+
+    // Without a loca entry we don't know the glyph's length, so allow up to end of file
+    size_t consumed = decodeGlyph(fontData.subspan(cursor, fontData.size - cursor), -1, 0, glyph);
+    if (consumed == 0) return fail(ReaderStatus::MalformedGlyph);
+    TTF_COUNT(BytesRead, consumed);
+    if (fontData.i16(cursor) < 0) {
+        TTF_COUNT(CompositeGlyphs, 1);
+    } else {
+        TTF_COUNT(SimpleGlyphs, 1);
     }
-    std::cout << std::dec; // Reset to decimal
+
+    cursor += consumed;
+    lastStatus = ReaderStatus::Ok;
+    return true;
 }
 
+size_t TTFReader::decodeGlyph(ByteSpan data, int glyphIndex, int depth, SimpleGlyph& glyph) {
+    if (!data.contains(0, 10)) return 0;
+    if (data.i16(0) < 0) return decodeCompositeGlyph(data, glyphIndex, depth, glyph);
+    return decodeSimpleGlyph(data, glyphIndex, glyph);
+}
 
+size_t TTFReader::decodeSimpleGlyph(ByteSpan data, int glyphIndex, SimpleGlyph& glyph) {
+    // Same decoder as the outline path, then copied out to the AoS form
+    OutlineArena::Marker marker = decodeArena.mark();
+    GlyphOutline outline;
+    size_t consumed = decodeSimpleOutline(data, glyphIndex, decodeArena, outline);
+    if (consumed != 0) glyphFromOutline(outline, glyph);
+    decodeArena.rewind(marker);
+    return consumed;
+}
 
+size_t TTFReader::decodeOutline(ByteSpan data, int glyphIndex, OutlineArena& arena, GlyphOutline& outline) {
+    if (!data.contains(0, 10)) return 0;
+    if (data.i16(0) >= 0) return decodeSimpleOutline(data, glyphIndex, arena, outline);
 
-bool TTFReader::readGlyphHeader(GlyphHeader& header) {
-    if (!file.good()) return false;
-    
-    file.read(reinterpret_cast<char*>(&header.numberOfContours), 2);
-    file.read(reinterpret_cast<char*>(&header.xMin), 2);
-    file.read(reinterpret_cast<char*>(&header.yMin), 2);
-    file.read(reinterpret_cast<char*>(&header.xMax), 2);
-    file.read(reinterpret_cast<char*>(&header.yMax), 2);
-    
-    if (littleEndian) {
-        header.numberOfContours = static_cast<int16_t>(swapUint16(header.numberOfContours));
-        header.xMin = static_cast<int16_t>(swapUint16(header.xMin));
-        header.yMin = static_cast<int16_t>(swapUint16(header.yMin));
-        header.xMax = static_cast<int16_t>(swapUint16(header.xMax));
-        header.yMax = static_cast<int16_t>(swapUint16(header.yMax));
+    size_t consumed = decodeCompositeGlyph(data, glyphIndex, 0, compositeScratch);
+    if (consumed == 0 || !outlineFromGlyph(compositeScratch, arena, outline)) return 0;
+    return consumed;
+}
+
+// Varied outlines get a fresh bounding box, like an instanced font would store
+static void boundsFromPoints(const int16_t* xs, const int16_t* ys, size_t count, GlyphHeader& header) {
+    if (count == 0) return;
+    header.xMin = header.xMax = xs[0];
+    header.yMin = header.yMax = ys[0];
+    for (size_t i = 1; i < count; i++) {
+        header.xMin = std::min(header.xMin, xs[i]);
+        header.xMax = std::max(header.xMax, xs[i]);
+        header.yMin = std::min(header.yMin, ys[i]);
+        header.yMax = std::max(header.yMax, ys[i]);
     }
-    return file.good();
 }
 
-bool TTFReader::readSimpleGlyph(SimpleGlyph& glyph) {
-    if(!readGlyphHeader(glyph.header)) return false;
+size_t TTFReader::decodeSimpleOutline(ByteSpan data, int glyphIndex, OutlineArena& arena, GlyphOutline& outline) {
+    if (!data.contains(0, 10)) return 0;
 
-    if (glyph.header.numberOfContours < 0) {
-        std::cout << "Composite glyph - not implemented yet" << std::endl;
-        return false;
-    }
+    GlyphHeader header;
+    header.numberOfContours = data.i16(0);
+    header.xMin = data.i16(2);
+    header.yMin = data.i16(4);
+    header.xMax = data.i16(6);
+    header.yMax = data.i16(8);
+    size_t pos = 10;
 
-    glyph.endPtsOfContours.resize(glyph.header.numberOfContours);
-    for (int i = 0; i < glyph.header.numberOfContours; i++) {
-        uint16_t endPt;
-        file.read(reinterpret_cast<char*>(&endPt), 2);
-        if (littleEndian) endPt = swapUint16(endPt);
-        glyph.endPtsOfContours[i] = endPt;
-    }
+    if (header.numberOfContours < 0) return 0; // Composite - see decodeCompositeGlyph
 
-    uint16_t numPoints = glyph.endPtsOfContours.back() + 1;
+    size_t numContours = static_cast<size_t>(header.numberOfContours);
+    if (numContours == 0 || !data.contains(pos, numContours * 2 + 2)) return 0;
 
-    uint16_t instructionLength;
-    file.read(reinterpret_cast<char*>(&instructionLength), 2);
-    if (littleEndian) instructionLength = swapUint16(instructionLength);
-    file.seekg(instructionLength, std::ios::cur); // Skip instructions
-    
-    std::vector<uint8_t> flags;
-    flags.reserve(numPoints);
+    uint32_t numPoints = static_cast<uint32_t>(data.u16(pos + (numContours - 1) * 2)) + 1;
 
-    for (uint16_t i = 0; i < numPoints; ) {
-        uint8_t flag;
-        file.read(reinterpret_cast<char*>(&flag), 1);
-        flags.push_back(flag);
-        i++;
-        
-        // Handle repeat flag
-        if (flag & 0x08) { // REPEAT_FLAG
-            uint8_t repeatCount;
-            file.read(reinterpret_cast<char*>(&repeatCount), 1);
-            for (int j = 0; j < repeatCount && i < numPoints; j++, i++) {
-                flags.push_back(flag);
-            }
-        }
-    }
+    // Nothing in the arena survives a failed decode
+    OutlineArena::Marker start = arena.mark();
+    GlyphOutline decoded;
+    OutlineArrays arrays = allocateOutline(arena, numPoints, static_cast<uint16_t>(numContours), decoded);
+    decoded.header = header;
 
-    glyph.points.resize(numPoints);
-    int16_t currentX = 0, currentY = 0;
+    for (size_t i = 0; i < numContours; i++) {
+        arrays.endPts[i] = data.u16(pos);
+        pos += 2;
+    }
 
-    for (uint16_t i = 0; i < numPoints; i++) {
-        uint8_t flag = flags[i];
-        glyph.points[i].onCurve = (flag & 0x01) != 0;  
+    uint16_t instructionLength = data.u16(pos);
+    pos += 2 + instructionLength; // Skip instructions
+    if (pos > data.size) {
+        arena.rewind(start);
+        return 0;
+    }
 
-        if (flag & 0x02) { // X_SHORT_VECTOR
-            uint8_t deltaX;
-            file.read(reinterpret_cast<char*>(&deltaX), 1);
-            currentX += (flag & 0x10) ? deltaX : -deltaX;
-        } else if (!(flag & 0x10)) { // X coordinate changed
-            int16_t deltaX;
-            file.read(reinterpret_cast<char*>(&deltaX), 2);
-            if (littleEndian) deltaX = static_cast<int16_t>(swapUint16(deltaX));
-            currentX += deltaX;
-        }
+    // Expanded flags only live until the coordinates are decoded
+    OutlineArena::Marker flagsStart = arena.mark();
+    uint8_t* flags = arena.allocateArray<uint8_t>(numPoints);
 
-        glyph.points[i].x = currentX;
+    size_t consumed = decodeGlyphPoints(data.data + pos, data.size - pos, numPoints,
+                                        flags, arrays.xs, arrays.ys, arrays.onCurveBits);
+    if (consumed == 0) {
+        arena.rewind(start);
+        return 0;
     }
+    pos += consumed;
+    arena.rewind(flagsStart);
 
-     for (uint16_t i = 0; i < numPoints; i++) {
-        uint8_t flag = flags[i];
-        
-        if (flag & 0x04) { // Y_SHORT_VECTOR
-            uint8_t deltaY;
-            file.read(reinterpret_cast<char*>(&deltaY), 1);
-            currentY += (flag & 0x20) ? deltaY : -deltaY;
-        } else if (!(flag & 0x20)) { // Y coordinate changed
-            int16_t deltaY;
-            file.read(reinterpret_cast<char*>(&deltaY), 2);
-            if (littleEndian) deltaY = static_cast<int16_t>(swapUint16(deltaY));
-            currentY += deltaY;
+    if (varying() && glyphIndex >= 0) {
+        // Deltas are inferred from the default outline, so compute before moving anything
+        if (!variator.compute(*variationInstance, glyphIndex, numPoints, arrays.xs, arrays.ys, arrays.endPts,
+                              numContours)) {
+            arena.rewind(start);
+            return 0;
+        }
+        if (variator.hasDeltas()) {
+            variator.apply(arrays.xs, arrays.ys, numPoints);
+            boundsFromPoints(arrays.xs, arrays.ys, numPoints, decoded.header);
         }
-        glyph.points[i].y = currentY;
     }
-    return true;
+    outline = decoded;
+    TTF_COUNT(PointsDecoded, numPoints);
+    return pos;
 }
 
 
-void TTFReader::printGlyph(const SimpleGlyph& glyph) {
-    std::cout << "Glyph Info:" << std::endl;
-    std::cout << "  Contours: " << glyph.header.numberOfContours << std::endl;
-    std::cout << "  Bounding box: (" << glyph.header.xMin << ", " << glyph.header.yMin 
-              << ") to (" << glyph.header.xMax << ", " << glyph.header.yMax << ")" << std::endl;
-    
-    std::cout << "  End points: ";
-    for (auto endPt : glyph.endPtsOfContours) {
-        std::cout << endPt << " ";
-    }
-    std::cout << std::endl;
-    
-    std::cout << "  Points:" << std::endl;
-    for (size_t i = 0; i < glyph.points.size(); i++) {
-        std::cout << "    " << i << ": (" << glyph.points[i].x << ", " << glyph.points[i].y 
-                  << ") " << (glyph.points[i].onCurve ? "ON" : "OFF") << std::endl;
-    }
+// F2DOT14: signed 2.14 fixed point, used for component scales
+static float readF2Dot14(ByteSpan data, size_t offset) {
+    return data.i16(offset) / 16384.0f;
 }
 
-void TTFReader::plotGlyph(const SimpleGlyph& glyph, int width, int height) {
-    if (glyph.points.empty()) return;
-    
-    std::vector<std::vector<char>> grid(height, std::vector<char>(width, ' '));
-    
-    int16_t xRange = glyph.header.xMax - glyph.header.xMin;
-    int16_t yRange = glyph.header.yMax - glyph.header.yMin;
-    
-    if (xRange == 0 || yRange == 0) return;
-    
-    for (const auto& point : glyph.points) {
-        int x = ((point.x - glyph.header.xMin) * (width - 1)) / xRange;
-        int y = height - 1 - ((point.y - glyph.header.yMin) * (height - 1)) / yRange;
-        
-        // Bounds check
-        if (x >= 0 && x < width && y >= 0 && y < height) {
-            grid[y][x] = point.onCurve ? '*' : 'o';
+// Components in a composite record, for sizing its variation deltas; 0 if malformed
+static size_t countComponents(ByteSpan data) {
+    size_t pos = 10, count = 0;
+    uint16_t flags;
+    do {
+        if (!data.readU16(pos, flags)) return 0;
+        pos += 4 + ((flags & ARG_1_AND_2_ARE_WORDS) ? 4 : 2);
+        if (flags & WE_HAVE_A_SCALE) {
+            pos += 2;
+        } else if (flags & WE_HAVE_AN_X_AND_Y_SCALE) {
+            pos += 4;
+        } else if (flags & WE_HAVE_A_TWO_BY_TWO) {
+            pos += 8;
         }
-    }
-    
-    // Print grid
-    std::cout << "\nGlyph Plot (" << width << "x" << height << "):" << std::endl;
-    std::cout << "* = on-curve points, o = off-curve (control) points" << std::endl;
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            std::cout << grid[y][x];
-        }
-        std::cout << std::endl;
-    }
+        count++;
+    } while ((flags & MORE_COMPONENTS) && count < MAX_COMPOSITE_POINTS);
+    return count;
 }
 
-void TTFReader::exportGlyphSVG(const SimpleGlyph& glyph, const std::string& filename) {
-    std::ofstream svg(filename);
-    
-    int width = glyph.header.xMax - glyph.header.xMin + 100;
-    int height = glyph.header.yMax - glyph.header.yMin + 100;
-    
-    svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    svg << "<svg width=\"" << width << "\" height=\"" << height << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
-    svg << "<g transform=\"translate(50," << (height - 50) << ") scale(1,-1)\">\n";
+size_t TTFReader::decodeCompositeGlyph(ByteSpan data, int glyphIndex, int depth, SimpleGlyph& glyph) {
+    if (!data.contains(0, 10) || depth >= MAX_COMPOSITE_DEPTH) return 0;
+    
+    glyph.header.numberOfContours = data.i16(0);
+    glyph.header.xMin = data.i16(2);
+    glyph.header.yMin = data.i16(4);
+    glyph.header.xMax = data.i16(6);
+    glyph.header.yMax = data.i16(8);
+    glyph.endPtsOfContours.clear();
+    glyph.points.clear();
+    
+    // Mark this glyph as in progress so a component referring back to it fails
+    struct StackGuard {
+        std::vector<int>& stack;
+        StackGuard(std::vector<int>& s, int index) : stack(s) { stack.push_back(index); }
+        ~StackGuard() { stack.pop_back(); }
+    } guard(compositeStack, glyphIndex);
+    
+    // A composite's variation "points" are its component offsets. Components
+    // reuse the variator as they resolve, so keep a copy of ours.
+    std::vector<float> offsetDeltas;
+    if (varying() && glyphIndex >= 0) {
+        size_t components = countComponents(data);
+        if (components == 0) return 0;
+        if (!variator.compute(*variationInstance, glyphIndex, components, nullptr, nullptr, nullptr, 0)) return 0;
+        if (variator.hasDeltas()) {
+            offsetDeltas.resize(components * 2);
+            for (size_t i = 0; i < components; i++) {
+                offsetDeltas[i * 2] = variator.deltaX(i);
+                offsetDeltas[i * 2 + 1] = variator.deltaY(i);
+            }
+        }
+    }
     
-    // Draw points
-    for (size_t i = 0; i < glyph.points.size(); i++) {
-        const auto& point = glyph.points[i];
-        int x = point.x - glyph.header.xMin;
-        int y = point.y - glyph.header.yMin;
+    size_t pos = 10;
+    size_t componentNumber = 0;
+    uint16_t flags;
+    do {
+        if (!data.contains(pos, 4)) return 0;
+        flags = data.u16(pos);
+        uint16_t componentIndex = data.u16(pos + 2);
+        pos += 4;
         
-        if (point.onCurve) {
-            svg << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"3\" fill=\"red\"/>\n";
+        // Arguments: x/y offsets, or point numbers to match up
+        int32_t arg1, arg2;
+        if (flags & ARG_1_AND_2_ARE_WORDS) {
+            if (!data.contains(pos, 4)) return 0;
+            if (flags & ARGS_ARE_XY_VALUES) {
+                arg1 = data.i16(pos);
+                arg2 = data.i16(pos + 2);
+            } else {
+                arg1 = data.u16(pos);
+                arg2 = data.u16(pos + 2);
+            }
+            pos += 4;
         } else {
-            svg << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"2\" fill=\"blue\"/>\n";
+            if (!data.contains(pos, 2)) return 0;
+            if (flags & ARGS_ARE_XY_VALUES) {
+                arg1 = static_cast<int8_t>(data.u8(pos));
+                arg2 = static_cast<int8_t>(data.u8(pos + 1));
+            } else {
+                arg1 = data.u8(pos);
+                arg2 = data.u8(pos + 1);
+            }
+            pos += 2;
         }
         
-        svg << "<text x=\"" << (x + 5) << "\" y=\"" << (y + 5) << "\" font-size=\"8\" fill=\"white\" transform=\"scale(1,-1)\">" << i << "</text>\n";
-    }
-    
-    size_t pointIndex = 0;
-    for (size_t contour = 0; contour < glyph.endPtsOfContours.size(); contour++) {
-        size_t startPt = pointIndex;
-        size_t endPt = glyph.endPtsOfContours[contour];
+        if ((flags & ARGS_ARE_XY_VALUES) && componentNumber * 2 < offsetDeltas.size()) {
+            arg1 = static_cast<int32_t>(std::floor(arg1 + offsetDeltas[componentNumber * 2] + 0.5f));
+            arg2 = static_cast<int32_t>(std::floor(arg2 + offsetDeltas[componentNumber * 2 + 1] + 0.5f));
+        }
+        componentNumber++;
         
-        svg << "<polygon points=\"";
-        while (pointIndex <= endPt) {
-            const auto& point = glyph.points[pointIndex];
-            int x = point.x - glyph.header.xMin;
-            int y = point.y - glyph.header.yMin;
-            svg << x << "," << y << " ";
-            pointIndex++;
+        // Transform: x' = xx*x + yx*y, y' = xy*x + yy*y
+        float xx = 1.0f, xy = 0.0f, yx = 0.0f, yy = 1.0f;
+        if (flags & WE_HAVE_A_SCALE) {
+            if (!data.contains(pos, 2)) return 0;
+            xx = yy = readF2Dot14(data, pos);
+            pos += 2;
+        } else if (flags & WE_HAVE_AN_X_AND_Y_SCALE) {
+            if (!data.contains(pos, 4)) return 0;
+            xx = readF2Dot14(data, pos);
+            yy = readF2Dot14(data, pos + 2);
+            pos += 4;
+        } else if (flags & WE_HAVE_A_TWO_BY_TWO) {
+            if (!data.contains(pos, 8)) return 0;
+            xx = readF2Dot14(data, pos);
+            xy = readF2Dot14(data, pos + 2);
+            yx = readF2Dot14(data, pos + 4);
+            yy = readF2Dot14(data, pos + 6);
+            pos += 8;
         }
-        svg << "\" fill=\"none\" stroke=\"green\" stroke-width=\"1\"/>\n";
-    }
-    
-    svg << "</g>\n</svg>\n";
-    svg.close();
-    
-    std::cout << "SVG exported to: " << filename << std::endl;
-}
-
-
-
-bool TTFReader::readMultipleGlyphs(int count) {
-    for (int i = 0; i < count; i++) {
-        std::cout << "\n--- Parsing glyph " << i << " ---" << std::endl;
         
-        // Save current position
-        std::streampos currentPos = file.tellg();
+        std::shared_ptr<const SimpleGlyph> component;
+        if (!resolveComponent(componentIndex, depth + 1, component)) return 0;
         
-        SimpleGlyph glyph;
-        if (readSimpleGlyph(glyph)) {
-            std::cout << "Glyph " << i << ":" << std::endl;
-            printGlyph(glyph);
-            plotGlyph(glyph);
-            
-            std::string filename = "glyph_" + std::to_string(i) + ".svg";
-            exportGlyphSVG(glyph, filename);
-        } else {
-            std::cout << "Failed to parse glyph " << i << " - trying to skip ahead" << std::endl;
-            
-            // Go back to where we started and skip a reasonable amount
-            file.clear(); // Clear any error flags
-            file.seekg(currentPos + std::streamoff(100), std::ios::beg); // Skip 100 bytes
-            
-            if (!file.good()) {
-                std::cout << "Reached end of glyph data" << std::endl;
-                break;
+        size_t basePoint = glyph.points.size();
+        if (basePoint + component->points.size() > MAX_COMPOSITE_POINTS) return 0;
+        
+        // Transformed component points, before the offset is applied
+        glyph.points.reserve(basePoint + component->points.size());
+        for (const Point& p : component->points) {
+            Point q;
+            q.x = roundToInt16(xx * p.x + yx * p.y);
+            q.y = roundToInt16(xy * p.x + yy * p.y);
+            q.onCurve = p.onCurve;
+            glyph.points.push_back(q);
+        }
+        
+        float dx, dy;
+        if (flags & ARGS_ARE_XY_VALUES) {
+            dx = static_cast<float>(arg1);
+            dy = static_cast<float>(arg2);
+            // Offsets are unscaled unless the font explicitly asks otherwise
+            if ((flags & SCALED_COMPONENT_OFFSET) && !(flags & UNSCALED_COMPONENT_OFFSET)) {
+                float sx = xx * dx + yx * dy;
+                float sy = xy * dx + yy * dy;
+                dx = sx;
+                dy = sy;
             }
+            if (flags & ROUND_XY_TO_GRID) {
+                dx = std::round(dx);
+                dy = std::round(dy);
+            }
+        } else {
+            // Point matching: move the component so its point arg2 lands on our point arg1
+            size_t parentPoint = static_cast<size_t>(arg1);
+            size_t childPoint = basePoint + static_cast<size_t>(arg2);
+            if (parentPoint >= basePoint || childPoint >= glyph.points.size()) return 0;
+            dx = static_cast<float>(glyph.points[parentPoint].x - glyph.points[childPoint].x);
+            dy = static_cast<float>(glyph.points[parentPoint].y - glyph.points[childPoint].y);
+        }
+        
+        int16_t offsetX = roundToInt16(dx);
+        int16_t offsetY = roundToInt16(dy);
+        for (size_t i = basePoint; i < glyph.points.size(); i++) {
+            glyph.points[i].x = roundToInt16(static_cast<float>(glyph.points[i].x) + offsetX);
+            glyph.points[i].y = roundToInt16(static_cast<float>(glyph.points[i].y) + offsetY);
+        }
+        
+        for (uint16_t endPt : component->endPtsOfContours) {
+            glyph.endPtsOfContours.push_back(static_cast<uint16_t>(basePoint + endPt));
+        }
+    } while (flags & MORE_COMPONENTS);
+    
+    if (flags & WE_HAVE_INSTRUCTIONS) {
+        uint16_t instructionLength;
+        if (!data.readU16(pos, instructionLength)) return 0;
+        pos += 2 + instructionLength;
+        if (pos > data.size) return 0;
+    }
+    
+    // Callers see an ordinary outline: positive contour count, resolved points
+    glyph.header.numberOfContours = static_cast<int16_t>(glyph.endPtsOfContours.size());
+    if (varying() && glyphIndex >= 0 && !glyph.points.empty()) {
+        // Components may have moved even if this glyph has no deltas of its own
+        const Point& first = glyph.points[0];
+        glyph.header.xMin = glyph.header.xMax = first.x;
+        glyph.header.yMin = glyph.header.yMax = first.y;
+        for (const Point& p : glyph.points) {
+            glyph.header.xMin = std::min(glyph.header.xMin, p.x);
+            glyph.header.xMax = std::max(glyph.header.xMax, p.x);
+            glyph.header.yMin = std::min(glyph.header.yMin, p.y);
+            glyph.header.yMax = std::max(glyph.header.yMax, p.y);
         }
     }
-    return true;
+    return pos;
 }
 
-void TTFReader::explainLocaTable() {
-    std::cout << "\n=== Understanding 'loca' table ===" << std::endl;
-    
-    // Step 1: Check format in head table
-    TableEntry headEntry;
-    if (!findTable("head", headEntry)) {
-        std::cout << "No 'head' table found" << std::endl;
-        return;
+bool TTFReader::glyphDataForIndex(int glyphIndex, ByteSpan& data) {
+    if (!locaReady()) return false;
+    const TableEntry* glyfTable = face->glyf();
+    if (!glyfTable) return fail(ReaderStatus::MissingTable);
+    if (glyphIndex < 0 || static_cast<size_t>(glyphIndex) >= loca.glyphCount()) {
+        return fail(ReaderStatus::GlyphOutOfRange);
     }
     
-    std::cout << "Found 'head' table at offset: " << headEntry.offset << std::endl;
-    
-    // Read indexToLocFormat (at offset 50 in head table)
-    file.seekg(headEntry.offset + 50, std::ios::beg);
-    int16_t indexToLocFormat;
-    file.read(reinterpret_cast<char*>(&indexToLocFormat), 2);
-    if (littleEndian) indexToLocFormat = static_cast<int16_t>(swapUint16(indexToLocFormat));
-    
-    bool isLongFormat = (indexToLocFormat == 1);
-    std::cout << "Format: " << (isLongFormat ? "Long (4 bytes)" : "Short (2 bytes)") << std::endl;
-    
-    // Step 2: Read loca table
-    TableEntry locaEntry;
-    if (!findTable("loca", locaEntry)) {
-        std::cout << "No 'loca' table found" << std::endl;
-        return;
+    uint32_t glyphOffset = loca.offset(glyphIndex);
+    uint32_t nextGlyphOffset = loca.offset(glyphIndex + 1);
+    if (nextGlyphOffset < glyphOffset || nextGlyphOffset > glyfTable->length) {
+        return fail(ReaderStatus::CorruptTable);
     }
     
-    std::cout << "Found 'loca' table at offset: " << locaEntry.offset 
-              << ", length: " << locaEntry.length << std::endl;
+    data = ByteSpan();
+    if (glyphOffset == nextGlyphOffset) return true; // Empty glyph
     
-    // Calculate number of glyphs
-    size_t entrySize = isLongFormat ? 4 : 2;
-    size_t numEntries = locaEntry.length / entrySize;
-    size_t numGlyphs = numEntries - 1; // Last entry is end marker
+    data = fontData.subspan(static_cast<size_t>(glyfTable->offset) + glyphOffset, nextGlyphOffset - glyphOffset);
+    TTF_COUNT(Seeks, 1);
+    TTF_COUNT(BytesRead, data.size);
+    return !data.empty() || fail(ReaderStatus::CorruptTable);
+}
+
+bool TTFReader::readGlyphBounds(int glyphIndex, GlyphHeader& header) {
+    ByteSpan data;
+    if (!glyphDataForIndex(glyphIndex, data)) return false;
+    if (data.empty()) {
+        header = GlyphHeader{0, 0, 0, 0, 0};
+        return true;
+    }
+    if (!data.contains(0, 10)) return fail(ReaderStatus::MalformedGlyph);
+    header.numberOfContours = data.i16(0);
+    header.xMin = data.i16(2);
+    header.yMin = data.i16(4);
+    header.xMax = data.i16(6);
+    header.yMax = data.i16(8);
+    return true;
+}
+
+bool TTFReader::resolveComponent(uint16_t glyphIndex, int depth, std::shared_ptr<const SimpleGlyph>& component) {
+    auto cached = componentCache.find(glyphIndex);
+    if (cached != componentCache.end()) {
+        component = cached->second;
+        return true;
+    }
     
-    std::cout << "Number of glyphs: " << numGlyphs << std::endl;
+    // Still being resolved further up the chain: the font has a cycle
+    if (std::find(compositeStack.begin(), compositeStack.end(), glyphIndex) != compositeStack.end()) {
+        return false;
+    }
     
-    // Read first 10 entries as example
-    file.seekg(locaEntry.offset, std::ios::beg);
-    std::cout << "\nFirst 10 glyph locations:" << std::endl;
+    ByteSpan data;
+    if (!glyphDataForIndex(glyphIndex, data)) return false;
     
-    for (int i = 0; i < 10 && i < static_cast<int>(numEntries); i++) {
-        uint32_t offset;
-        
-        if (isLongFormat) {
-            file.read(reinterpret_cast<char*>(&offset), 4);
-            if (littleEndian) offset = swapUint32(offset);
-        } else {
-            uint16_t shortOffset;
-            file.read(reinterpret_cast<char*>(&shortOffset), 2);
-            if (littleEndian) shortOffset = swapUint16(shortOffset);
-            offset = shortOffset * 2; // Convert to actual offset
-        }
-        
-        std::cout << "  Glyph " << i << ": starts at offset " << offset << std::endl;
+    SimpleGlyph resolved;
+    if (data.empty()) {
+        resolved.header = GlyphHeader{0, 0, 0, 0, 0};
+    } else if (decodeGlyph(data, glyphIndex, depth, resolved) == 0) {
+        return false;
     }
+    
+    component = std::make_shared<const SimpleGlyph>(std::move(resolved));
+    componentCache[glyphIndex] = component;
+    return true;
+}
+
+
+bool TTFReader::exportGlyphSVG(const GlyphOutline& glyph, const std::string& filename) {
+    return writeGlyphSVG(glyph, filename, false, svgBuffer);
 }
 
 
 
 bool TTFReader::loadLocaTable() {
-    // Step 1: Get format from head table
-    TableEntry headEntry;
-    if (!findTable("head", headEntry)) return false;
-    
-    file.seekg(headEntry.offset + 50, std::ios::beg);
-    int16_t indexToLocFormat;
-    file.read(reinterpret_cast<char*>(&indexToLocFormat), 2);
-    if (littleEndian) indexToLocFormat = static_cast<int16_t>(swapUint16(indexToLocFormat));
-    
-    isLongFormat = (indexToLocFormat == 1);
-    
-    // Step 2: Load all glyph offsets
-    TableEntry locaEntry;
-    if (!findTable("loca", locaEntry)) return false;
-    
-    size_t entrySize = isLongFormat ? 4 : 2;
-    size_t numEntries = locaEntry.length / entrySize;
-    
-    glyphOffsets.clear();
-    glyphOffsets.reserve(numEntries);
-    
-    file.seekg(locaEntry.offset, std::ios::beg);
+    if (!locaReady()) {
+        if (logging(LogLevel::Error)) logMessage(LogLevel::Error, "'loca' table is missing or malformed");
+        return false;
+    }
+    if (logging(LogLevel::Info)) {
+        logMessage(LogLevel::Info, "Found %zu glyph locations (%s format)", loca.glyphCount(),
+                   loca.longFormat ? "long" : "short");
+    }
+    return true;
+}
+
+const std::vector<uint32_t>& TTFReader::getGlyphOffsets() {
+    if (face && !fontPack && !face->getGlyphOffsets().empty()) return face->getGlyphOffsets();
+    if (!glyphOffsets.empty() || !locaReady()) return glyphOffsets;
     
-    for (size_t i = 0; i < numEntries; i++) {
-        uint32_t offset;
-        
-        if (isLongFormat) {
-            file.read(reinterpret_cast<char*>(&offset), 4);
-            if (littleEndian) offset = swapUint32(offset);
-        } else {
-            uint16_t shortOffset;
-            file.read(reinterpret_cast<char*>(&shortOffset), 2);
-            if (littleEndian) shortOffset = swapUint16(shortOffset);
-            offset = shortOffset * 2;
+    TTF_TIME_STAGE(LocaLoad);
+    glyphOffsets.resize(loca.entries);
+    if (loca.widened) {
+        // Already native (a font pack's copy)
+        std::copy(loca.widened, loca.widened + loca.entries, glyphOffsets.begin());
+    } else {
+        widenLocaOffsets(loca.data, loca.entries, loca.longFormat, glyphOffsets.data());
+        TTF_COUNT(BytesRead, loca.entries * (loca.longFormat ? 4 : 2));
+    }
+    loca.widened = glyphOffsets.data();
+    return glyphOffsets;
+}
+
+bool TTFReader::setFontPack(const FontPack* pack) {
+    if (!pack) {
+        // Don't keep pointing into a pack the caller may close
+        if (fontPack) {
+            loca = face ? face->getLoca() : LocaTable();
+            glyphOffsets.clear();
         }
-        
-        glyphOffsets.push_back(offset);
+        fontPack = nullptr;
+        return true;
     }
+    if (!face || !pack->isOpen() || pack->getNumGlyphs() != face->getNumGlyphs()) return false;
     
-    std::cout << "Loaded " << (numEntries - 1) << " glyph locations" << std::endl;
+    // The pack's 'loca' is already native-endian: use it in place
+    loca = LocaTable();
+    loca.widened = pack->getGlyphOffsets();
+    loca.entries = static_cast<size_t>(pack->getNumGlyphs()) + 1;
+    loca.longFormat = pack->hasLongLoca();
+    glyphOffsets.clear();
+    fontPack = pack;
     return true;
 }
 
+void TTFReader::setVariationInstance(std::shared_ptr<const VariationInstance> instance) {
+    uint32_t previous = varying() ? variationInstance->getSerial() : 0;
+    variationInstance = std::move(instance);
+    uint32_t current = varying() ? variationInstance->getSerial() : 0;
+    // Resolved components were decoded at the old location
+    if (current != previous) componentCache.clear();
+}
+
 
 bool TTFReader::readGlyphByIndex(int glyphIndex, SimpleGlyph& glyph) {
-    if (glyphOffsets.empty()) {
+    TTF_TIME_STAGE(GlyphDecode);
+    if (loca.empty()) {
         if (!loadLocaTable()) return false;
     }
+    const TableEntry* glyfTable = face->glyf();
 
-    if (glyphIndex < 0 || glyphIndex >= static_cast<int>(glyphOffsets.size() - 1)) {
-        std::cout << "Glyph index " << glyphIndex << " out of range" << std::endl;
-        return false;
+    if (glyphIndex < 0 || static_cast<size_t>(glyphIndex) >= loca.glyphCount()) {
+        if (logging(LogLevel::Warning)) logMessage(LogLevel::Warning, "Glyph index %d out of range", glyphIndex);
+        return fail(ReaderStatus::GlyphOutOfRange);
     }
     
-    uint32_t glyphOffset = glyphOffsets[glyphIndex];
-    uint32_t nextGlyphOffset = glyphOffsets[glyphIndex + 1];
+    uint32_t glyphOffset = loca.offset(glyphIndex);
+    uint32_t nextGlyphOffset = loca.offset(glyphIndex + 1);
     
     if (glyphOffset == nextGlyphOffset) {
-        std::cout << "Glyph " << glyphIndex << " is empty (no outline data)" << std::endl;
-        return false;
+        TTF_COUNT(EmptyGlyphs, 1);
+        if (logging(LogLevel::Info)) logMessage(LogLevel::Info, "Glyph %d is empty (no outline data)", glyphIndex);
+        return fail(ReaderStatus::EmptyGlyph);
     }
     
-    TableEntry glyfEntry;
-    if (!findTable("glyf", glyfEntry)) return false;
+    if (!glyfTable) return fail(ReaderStatus::MissingTable);
     
-    file.seekg(glyfEntry.offset + glyphOffset, std::ios::beg);
+    // Bound the decoder to this glyph's bytes, and the glyph to its table
+    if (nextGlyphOffset < glyphOffset || nextGlyphOffset > glyfTable->length) {
+        if (logging(LogLevel::Error)) logMessage(LogLevel::Error, "Glyph %d has a corrupt 'loca' entry", glyphIndex);
+        return fail(ReaderStatus::CorruptTable);
+    }
+    size_t glyphStart = static_cast<size_t>(glyfTable->offset) + glyphOffset;
+    ByteSpan glyphData = fontData.subspan(glyphStart, nextGlyphOffset - glyphOffset);
+    if (glyphData.empty()) return fail(ReaderStatus::CorruptTable);
+    
+    if (logging(LogLevel::Debug)) {
+        logMessage(LogLevel::Debug, "Reading glyph %d at offset %zu (size: %zu bytes)", glyphIndex, glyphStart,
+                   glyphData.size);
+    }
+    
+    TTF_COUNT(Seeks, 1);
+    TTF_COUNT(BytesRead, glyphData.size);
     
-    std::cout << "Reading glyph " << glyphIndex << " at offset " << (glyfEntry.offset + glyphOffset) 
-              << " (size: " << (nextGlyphOffset - glyphOffset) << " bytes)" << std::endl;
+    size_t consumed = decodeGlyph(glyphData, glyphIndex, 0, glyph);
+    if (consumed == 0) {
+        if (logging(LogLevel::Error)) logMessage(LogLevel::Error, "Glyph %d failed to decode", glyphIndex);
+        return fail(ReaderStatus::MalformedGlyph);
+    }
+    if (glyphData.i16(0) < 0) {
+        TTF_COUNT(CompositeGlyphs, 1);
+    } else {
+        TTF_COUNT(SimpleGlyphs, 1);
+    }
     
-    return readSimpleGlyph(glyph);
+    cursor = glyphStart + consumed;
+    lastStatus = ReaderStatus::Ok;
+    return true;
 }
 
 
-void TTFReader::readMultipleGlyphsByIndex(int startIndex, int count) {
-    for (int i = 0; i < count; i++) {
-        int glyphIndex = startIndex + i;
-        std::cout << "\n=== Reading Glyph " << glyphIndex << " ===" << std::endl;
-        
-        SimpleGlyph glyph;
-        if (readGlyphByIndex(glyphIndex, glyph)) {
-            printGlyph(glyph);
-            plotGlyph(glyph);
-            
-            std::string filename = "glyph_" + std::to_string(glyphIndex) + ".svg";
-            exportGlyphSVG(glyph, filename);
-        } else {
-            std::cout << "Failed to read glyph " << glyphIndex << std::endl;
+bool TTFReader::loadOutline(int glyphIndex, OutlineArena& arena, GlyphOutline& outline) {
+    TTF_TIME_STAGE(GlyphDecode);
+    if (fontPack && !varying()) {
+        if (fontPack->getOutline(glyphIndex, outline)) {
+            lastStatus = ReaderStatus::Ok;
+            return true;
         }
+        bool inRange = glyphIndex >= 0 && glyphIndex < getNumGlyphs();
+        return fail(inRange ? ReaderStatus::MalformedGlyph : ReaderStatus::GlyphOutOfRange);
+    }
+    
+    ByteSpan data;
+    if (!glyphDataForIndex(glyphIndex, data)) return false;
+    
+    if (data.empty()) {
+        // Empty glyph (e.g. space): a valid outline with no contours
+        TTF_COUNT(EmptyGlyphs, 1);
+        outline = GlyphOutline();
+        lastStatus = ReaderStatus::Ok;
+        return true;
     }
+    if (decodeOutline(data, glyphIndex, arena, outline) == 0) return fail(ReaderStatus::MalformedGlyph);
+    if (data.i16(0) < 0) {
+        TTF_COUNT(CompositeGlyphs, 1);
+    } else {
+        TTF_COUNT(SimpleGlyphs, 1);
+    }
+    lastStatus = ReaderStatus::Ok;
+    return true;
+}
+
+
+std::shared_ptr<const StoredOutline> TTFReader::acquireGlyph(int glyphIndex) {
+    if (glyphIndex < 0) return nullptr;
+    
+    GlyphKey key = glyphCacheKey(static_cast<uint32_t>(glyphIndex), varying() ? variationInstance->getSerial() : 0);
+    if (glyphCache) {
+        GlyphHandle cached = glyphCache->find(key);
+        if (cached) return cached;
+    }
+    
+    // Decode into scratch, then copy into one right-sized block
+    decodeArena.reset();
+    GlyphOutline outline;
+    if (!loadOutline(glyphIndex, decodeArena, outline)) return nullptr;
+    
+    if (glyphCache) {
+        return glyphCache->insert(key, outline);
+    }
+    return std::make_shared<const StoredOutline>(outline);
+}
+
+
+bool TTFReader::loadCharMap(CharMap& map) {
+    if (!face || !face->cmap()) return false;
+    return map.build(face->tableData(face->cmap()));
+}
+
+
+bool TTFReader::loadHorizontalMetrics(HorizontalMetrics& metrics) {
+    if (!face || !face->hhea() || !face->hmtx()) return false;
+    return metrics.build(face->tableData(face->hhea()), face->tableData(face->hmtx()), face->getNumGlyphs());
+}
+
+
+bool TTFReader::loadKerning(KerningTable& kerning) {
+    if (!face) return false;
+    return kerning.build(face->tableData(face->lookupTable(TAG_GPOS)), face->tableData(face->lookupTable(TAG_KERN)),
+                         face->getNumGlyphs());
+}
+
+
+bool TTFReader::loadGlyphBounds(GlyphBoundsTable& bounds, WorkStealingPool* pool) {
+    if (!face) return false;
+    return bounds.build(*face, pool);
 }
 
 
@@ -559,221 +761,104 @@ std::vector<BezierPoint> TTFReader::generateBezierCurve(const BezierPoint& start
         float t = static_cast<float>(i) / resolution;
         points.push_back(quadraticBezier(start, control, end, t));
     }
+    TTF_COUNT(BezierSegments, resolution);
     
     return points;
 }
 
 
-std::vector<BezierPoint> TTFReader::generateGlyphOutline(const SimpleGlyph& glyph, int resolution) {
-    std::vector<BezierPoint> outline;
-    
-    size_t pointIndex = 0;
-    
-    // Process each contour
-    for (size_t contour = 0; contour < glyph.endPtsOfContours.size(); contour++) {
-        size_t startPt = pointIndex;
-        size_t endPt = glyph.endPtsOfContours[contour];
-        
-        std::cout << "Processing contour " << contour << " (points " << startPt << " to " << endPt << ")" << std::endl;
-        
-        // Process points in this contour
-        while (pointIndex <= endPt) {
-            const Point& currentPt = glyph.points[pointIndex];
-            
-            if (currentPt.onCurve) {
-                // On-curve point - add directly to outline
-                outline.push_back(BezierPoint(currentPt.x, currentPt.y));
-                pointIndex++;
-            } else {
-                // Off-curve point - this is a control point for a Bézier curve
-                if (pointIndex == 0 || pointIndex >= glyph.points.size() - 1) {
-                    // Edge case: skip if we can't form a proper curve
-                    pointIndex++;
-                    continue;
-                }
-                
-                // Find the previous on-curve point
-                BezierPoint startPoint;
-                if (outline.empty()) {
-                    // Use the last point of this contour as start
-                    const Point& lastPt = glyph.points[endPt];
-                    startPoint = BezierPoint(lastPt.x, lastPt.y);
-                } else {
-                    startPoint = outline.back();
-                }
-                
-                // Current point is the control point
-                BezierPoint controlPoint(currentPt.x, currentPt.y);
-                
-                // Find the next on-curve point (or implied point)
-                BezierPoint endPoint;
-                if (pointIndex + 1 <= endPt && glyph.points[pointIndex + 1].onCurve) {
-                    // Next point is on-curve
-                    const Point& nextPt = glyph.points[pointIndex + 1];
-                    endPoint = BezierPoint(nextPt.x, nextPt.y);
-                } else if (pointIndex + 1 <= endPt) {
-                    // Next point is also off-curve, so we have an implied on-curve point
-                    const Point& nextPt = glyph.points[pointIndex + 1];
-                    endPoint = BezierPoint(
-                        (currentPt.x + nextPt.x) / 2.0f,
-                        (currentPt.y + nextPt.y) / 2.0f
-                    );
-                } else {
-                    // Wrap to start of contour
-                    const Point& firstPt = glyph.points[startPt];
-                    endPoint = BezierPoint(firstPt.x, firstPt.y);
-                }
-                
-                // Generate the Bézier curve
-                std::vector<BezierPoint> curvePoints = generateBezierCurve(startPoint, controlPoint, endPoint, resolution);
-                
-                // Add curve points to outline (skip first point to avoid duplication)
-                for (size_t i = 1; i < curvePoints.size(); i++) {
-                    outline.push_back(curvePoints[i]);
-                }
-                
-                pointIndex++;
+// Collects a flattened outline: fixed resolution per curve, or (resolution == 0)
+// adaptive segment counts from the tolerance, both into one reused vector
+struct OutlineFlattener {
+    TTFReader& reader;
+    std::vector<BezierPoint>& out;
+    int resolution;
+    float tolerance;        // Font units
+    FlattenStats stats;
+    BezierPoint current;
+    
+    void moveTo(const BezierPoint& p) {
+        out.push_back(p);
+        current = p;
+        stats.contours++;
+    }
+    void lineTo(const BezierPoint& p) {
+        out.push_back(p);
+        current = p;
+        stats.lines++;
+    }
+    void quadTo(const BezierPoint& control, const BezierPoint& end) {
+        if (resolution > 0) {
+            // Skip t = 0, it's the point we're already at
+            for (int i = 1; i <= resolution; i++) {
+                float t = static_cast<float>(i) / resolution;
+                out.push_back(reader.quadraticBezier(current, control, end, t));
             }
+            TTF_COUNT(BezierSegments, resolution);
+        } else {
+            reader.flattenQuadratic(current, control, end, tolerance, out);
         }
+        current = end;
+        stats.curves++;
     }
-    
-    return outline;
-
-}
-
+    void closePath() {}
+};
 
 
-// void TTFReader::exportGlyphWithCurves(const SimpleGlyph& glyph, const std::string& filename) {
-//     std::ofstream svg(filename);
-    
-//     int width = glyph.header.xMax - glyph.header.xMin + 100;
-//     int height = glyph.header.yMax - glyph.header.yMin + 100;
-    
-//     svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-//     svg << "<svg width=\"" << width << "\" height=\"" << height << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
-//     svg << "<g transform=\"translate(50," << (height - 50) << ") scale(1,-1)\">\n";
-    
-//     // Draw original points (for reference)
-//     for (size_t i = 0; i < glyph.points.size(); i++) {
-//         const auto& point = glyph.points[i];
-//         int x = point.x - glyph.header.xMin;
-//         int y = point.y - glyph.header.yMin;
-        
-//         if (point.onCurve) {
-//             svg << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"2\" fill=\"red\" opacity=\"0.7\"/>\n";
-//         } else {
-//             svg << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"1\" fill=\"blue\" opacity=\"0.7\"/>\n";
-//         }
-//     }
-    
-//     // Generate and draw smooth outline
-//     std::vector<BezierPoint> outline = generateGlyphOutline(glyph, 10);
+std::vector<BezierPoint> TTFReader::generateGlyphOutline(const GlyphOutline& glyph, int resolution) {
+    TTF_TIME_STAGE(OutlineGeneration);
+    std::vector<BezierPoint> outline;
     
-//     if (!outline.empty()) {
-//         svg << "<polyline points=\"";
-//         for (const auto& point : outline) {
-//             int x = static_cast<int>(point.x - glyph.header.xMin);
-//             int y = static_cast<int>(point.y - glyph.header.yMin);
-//             svg << x << "," << y << " ";
-//         }
-//         svg << "\" fill=\"none\" stroke=\"green\" stroke-width=\"2\"/>\n";
-//     }
+    if (logging(LogLevel::Debug)) {
+        size_t startPt = 0;
+        for (size_t contour = 0; contour < glyph.contourCount; contour++) {
+            size_t endPt = glyph.endPts[contour];
+            logMessage(LogLevel::Debug, "Processing contour %zu (points %zu to %zu)", contour, startPt, endPt);
+            startPt = endPt + 1;
+        }
+    }
     
-//     svg << "</g>\n</svg>\n";
-//     svg.close();
+    OutlineFlattener flattener{*this, outline, resolution > 0 ? resolution : 1, 0.0f, FlattenStats(), BezierPoint()};
+    walkGlyphContours(glyph, flattener);
     
-//     std::cout << "Smooth curve SVG exported to: " << filename << std::endl;
-// }
-
-
+    return outline;
+}
 
-// Keep the existing working exportGlyphSVG function as is, and add this new function:
 
-void TTFReader::exportGlyphWithCurves(const SimpleGlyph& glyph, const std::string& filename) {
-    std::ofstream svg(filename);
-    
-    int width = glyph.header.xMax - glyph.header.xMin + 100;
-    int height = glyph.header.yMax - glyph.header.yMin + 100;
-    
-    svg << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
-    svg << "<svg width=\"" << width << "\" height=\"" << height << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
-    svg << "<g transform=\"translate(50," << (height - 50) << ") scale(1,-1)\">\n";
-    
-    // Draw original points for reference
-    for (size_t i = 0; i < glyph.points.size(); i++) {
-        const auto& point = glyph.points[i];
-        int x = point.x - glyph.header.xMin;
-        int y = point.y - glyph.header.yMin;
-        
-        if (point.onCurve) {
-            svg << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"2\" fill=\"red\" opacity=\"0.5\"/>\n";
-        } else {
-            svg << "<circle cx=\"" << x << "\" cy=\"" << y << "\" r=\"1\" fill=\"blue\" opacity=\"0.5\"/>\n";
-        }
-        svg << "<text x=\"" << (x + 3) << "\" y=\"" << (y + 3) << "\" font-size=\"6\" fill=\"black\" transform=\"scale(1,-1)\">" << i << "</text>\n";
+size_t TTFReader::flattenQuadratic(const BezierPoint& start, const BezierPoint& control, const BezierPoint& end,
+                                   float tolerance, std::vector<BezierPoint>& out) {
+    int segments = quadraticSegmentCount(start, control, end, tolerance);
+    TTF_COUNT(BezierSegments, segments);
+    if (segments == 1) {
+        out.push_back(end);
+        return 1;
     }
     
-    // Process each contour separately
-    size_t pointIndex = 0;
-    for (size_t contour = 0; contour < glyph.endPtsOfContours.size(); contour++) {
-        size_t startPt = pointIndex;
-        size_t endPt = glyph.endPtsOfContours[contour];
-        
-        svg << "<path d=\"";
-        
-        const auto& firstPoint = glyph.points[startPt];
-        int startX = firstPoint.x - glyph.header.xMin;
-        int startY = firstPoint.y - glyph.header.yMin;
-        svg << "M " << startX << " " << startY;
-        
-        // Process each point in the contour
-        for (size_t i = startPt; i <= endPt; i++) {
-            size_t nextIndex = (i == endPt) ? startPt : i + 1;  // Wrap around at end
-            
-            const auto& currentPt = glyph.points[i];
-            const auto& nextPt = glyph.points[nextIndex];
-            
-            int nextX = nextPt.x - glyph.header.xMin;
-            int nextY = nextPt.y - glyph.header.yMin;
-            
-            if (nextPt.onCurve) {
-                // Straight line to next on-curve point
-                svg << " L " << nextX << " " << nextY;
-            } else {
-                // Quadratic curve - find the end point
-                size_t endIndex = (nextIndex == endPt) ? startPt : nextIndex + 1;
-                if (endIndex > endPt) endIndex = startPt;
-                
-                const auto& endPoint = glyph.points[endIndex];
-                int endX, endY;
-                
-                if (endPoint.onCurve) {
-                    // Next point after control is on-curve
-                    endX = endPoint.x - glyph.header.xMin;
-                    endY = endPoint.y - glyph.header.yMin;
-                    i++; // Skip the control point in next iteration
-                } else {
-                    // Two consecutive off-curve points = implied on-curve point
-                    endX = (nextPt.x + endPoint.x) / 2 - glyph.header.xMin;
-                    endY = (nextPt.y + endPoint.y) / 2 - glyph.header.yMin;
-                    // Don't skip - the next off-curve point will be processed next
-                }
-                
-                // Control point
-                int ctrlX = nextPt.x - glyph.header.xMin;
-                int ctrlY = nextPt.y - glyph.header.yMin;
-                
-                svg << " Q " << ctrlX << " " << ctrlY << " " << endX << " " << endY;
-            }
-        }
-        
-        svg << " Z\" fill=\"none\" stroke=\"green\" stroke-width=\"2\"/>\n";  // Z closes the path
-        
-        pointIndex = endPt + 1;
+    float step = 1.0f / segments;
+    for (int i = 1; i < segments; i++) {
+        out.push_back(quadraticBezier(start, control, end, i * step));
     }
+    out.push_back(end); // Exact endpoint, no rounding drift
+    return static_cast<size_t>(segments);
+}
+
+
+FlattenStats TTFReader::flattenGlyphOutline(const GlyphOutline& glyph, float tolerance, float scale,
+                                            std::vector<BezierPoint>& outline) {
+    TTF_TIME_STAGE(OutlineGeneration);
+    outline.clear(); // Keeps capacity, so a reused buffer stops allocating after warm-up
+    
+    // Tolerance is given in pixels; the curves are in font units
+    float unitTolerance = (scale > 0.0f) ? tolerance / scale : tolerance;
     
-    svg << "</g>\n</svg>\n";
-    svg.close();
+    OutlineFlattener flattener{*this, outline, 0, unitTolerance, FlattenStats(), BezierPoint()};
+    walkGlyphContours(glyph, flattener);
     
-    std::cout << "Curve SVG exported to: " << filename << std::endl;
+    flattener.stats.vertices = outline.size();
+    return flattener.stats;
+}
+
+
+bool TTFReader::exportGlyphWithCurves(const GlyphOutline& glyph, const std::string& filename) {
+    return writeGlyphSVG(glyph, filename, true, svgBuffer);
 }
\ No newline at end of file
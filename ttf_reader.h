@@ -1,10 +1,15 @@
 #ifndef TTF_READER_H
 #define TTF_READER_H
 
-#include <iostream>
-#include <fstream>
 #include <vector>
 #include <string>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+#include "font_face.h"
+#include "font_variations.h"
+#include "glyph_outline.h"
+#include "svg_writer.h"
 
 // TTF Header (Offset Table)
 struct TTFHeader {
@@ -15,83 +20,294 @@ struct TTFHeader {
     uint16_t rangeShift;
 };
 
-struct GlyphHeader {
-    int16_t numberOfContours;
-    int16_t xMin, yMin, xMax, yMax;
-};
+// Composite glyph flags (glyf component records)
+const uint16_t ARG_1_AND_2_ARE_WORDS = 0x0001;
+const uint16_t ARGS_ARE_XY_VALUES = 0x0002;
+const uint16_t ROUND_XY_TO_GRID = 0x0004;
+const uint16_t WE_HAVE_A_SCALE = 0x0008;
+const uint16_t MORE_COMPONENTS = 0x0020;
+const uint16_t WE_HAVE_AN_X_AND_Y_SCALE = 0x0040;
+const uint16_t WE_HAVE_A_TWO_BY_TWO = 0x0080;
+const uint16_t WE_HAVE_INSTRUCTIONS = 0x0100;
+const uint16_t SCALED_COMPONENT_OFFSET = 0x0800;
+const uint16_t UNSCALED_COMPONENT_OFFSET = 0x1000;
 
-struct Point {
-    int16_t x, y;
-    bool onCurve;
-};
+// Limits that keep a malicious composite from recursing or growing without bound
+const int MAX_COMPOSITE_DEPTH = 8;
+const size_t MAX_COMPOSITE_POINTS = 65535;
 
-struct SimpleGlyph {
-    GlyphHeader header;
-    std::vector<uint16_t> endPtsOfContours;
-    std::vector<Point> points;
+struct BezierPoint {
+    float x, y;
+    BezierPoint(float x = 0, float y = 0) : x(x), y(y) {}
 };
 
-// Table Directory Entry
-struct TableEntry {
-    char tag[5];       
-    uint32_t checksum;
-    uint32_t offset;
-    uint32_t length;
+// Vertex counts from flattening an outline, for comparing modes
+struct FlattenStats {
+    size_t contours = 0;
+    size_t lines = 0;       // Straight segments in the source outline
+    size_t curves = 0;      // Quadratic segments in the source outline
+    size_t vertices = 0;    // Points emitted
 };
 
-struct BezierPoint {
-    float x, y;
-    BezierPoint(float x = 0, float y = 0) : x(x), y(y) {}
+// Upper bound on segments per quadratic, so a huge scale can't explode the output
+const int MAX_FLATTEN_SEGMENTS = 256;
+
+// Segments needed so a quadratic split uniformly in t stays within `tolerance`
+// of the true curve. B'' = 2 * (start - 2*control + end), so the worst-case error of n chords
+// is |dd| / (4 n^2) and n = ceil(sqrt(|dd| / (4 * tolerance))); nearly flat curves collapse
+// to one line.
+inline int quadraticSegmentCount(const BezierPoint& start, const BezierPoint& control,
+                                 const BezierPoint& end, float tolerance) {
+    float ddx = start.x - 2.0f * control.x + end.x;
+    float ddy = start.y - 2.0f * control.y + end.y;
+    float dd = std::sqrt(ddx * ddx + ddy * ddy);
+    if (tolerance <= 0.0f) return MAX_FLATTEN_SEGMENTS;
+    if (dd <= 4.0f * tolerance) return 1;
+    int n = static_cast<int>(std::ceil(std::sqrt(dd / (4.0f * tolerance))));
+    return n < MAX_FLATTEN_SEGMENTS ? n : MAX_FLATTEN_SEGMENTS;
+}
+
+// Walks each contour of a glyph using TrueType's curve rules and reports it
+// to a sink as moveTo / lineTo / quadTo calls (font units, y up):
+//   ON -> ON         straight line
+//   ON -> OFF -> ON  one quadratic with the OFF point as control
+//   OFF -> OFF       implied ON point at their midpoint
+// Contours that start on an OFF point begin at the last point (if ON) or at
+// the implied midpoint. Every contour ends with an explicit segment back to
+// its start, followed by closePath().
+template <typename Sink>
+void walkGlyphContours(const GlyphOutline& glyph, Sink& sink) {
+    size_t startPt = 0;
+    for (size_t contour = 0; contour < glyph.contourCount; contour++) {
+        size_t endPt = glyph.endPts[contour];
+        if (endPt >= glyph.pointCount || endPt < startPt) return; // Corrupt contour data
+
+        BezierPoint first(glyph.xs[startPt], glyph.ys[startPt]);
+        BezierPoint last(glyph.xs[endPt], glyph.ys[endPt]);
+
+        BezierPoint start;
+        size_t i = startPt, stop = endPt;
+        if (glyph.onCurve(startPt)) {
+            start = first;
+            i = startPt + 1;
+        } else if (glyph.onCurve(endPt)) {
+            start = last;
+            stop = endPt - 1; // Last point is the start, don't visit it twice
+        } else {
+            start = BezierPoint((first.x + last.x) / 2.0f, (first.y + last.y) / 2.0f);
+        }
+
+        sink.moveTo(start);
+
+        bool haveControl = false;
+        BezierPoint control;
+        for (; i <= stop && i <= endPt; i++) {
+            BezierPoint p(glyph.xs[i], glyph.ys[i]);
+
+            if (glyph.onCurve(i)) {
+                if (haveControl) {
+                    sink.quadTo(control, p);
+                    haveControl = false;
+                } else {
+                    sink.lineTo(p);
+                }
+            } else {
+                if (haveControl) {
+                    // Two OFF points in a row - curve ends at the implied midpoint
+                    BezierPoint implied((control.x + p.x) / 2.0f, (control.y + p.y) / 2.0f);
+                    sink.quadTo(control, implied);
+                }
+                control = p;
+                haveControl = true;
+            }
+        }
+
+        // Close back to the start point
+        if (haveControl) {
+            sink.quadTo(control, start);
+        } else {
+            sink.lineTo(start);
+        }
+        sink.closePath();
+
+        startPt = endPt + 1;
+    }
+}
+
+// Optional diagnostics. The reader never prints; with no sink set, a log
+// call is a single pointer test and the message is never formatted.
+enum class LogLevel {
+    Debug,      // Per-glyph / per-contour tracing
+    Info,
+    Warning,
+    Error
 };
 
+typedef void (*LogSink)(LogLevel level, const char* message, void* context);
+
+class GlyphCache;
+class CharMap;
+class HorizontalMetrics;
+class KerningTable;
+class GlyphBoundsTable;
+class WorkStealingPool;
+class FontPack;
+
+// A decode context over a FontFace. Everything here that changes while
+// reading - the cursor, scratch buffers, the component cache, the last
+// status - belongs to one reader, so use one reader per thread. Readers that
+// attach the same face share its mapping, table index and 'loca'.
 class TTFReader {
 private:
-    std::ifstream file;
-    bool littleEndian;
-    bool isLongFormat = false; 
-    std::vector<uint32_t> glyphOffsets;
-    
-    // Byte swapping utilities
-    uint16_t swapUint16(uint16_t val);
-    uint32_t swapUint32(uint32_t val);
-    bool isLittleEndian();
+    std::shared_ptr<const FontFace> face;
+    ByteSpan fontData;          // face->bytes(), cached for the sequential reads
+    size_t cursor = 0;          // Read position for the sequential read* calls
+    GlyphCache* glyphCache = nullptr; // Optional, not owned
+    const FontPack* fontPack = nullptr; // Optional, not owned
+    ReaderStatus lastStatus = ReaderStatus::Ok;
+    LogSink logSink = nullptr;
+    void* logContext = nullptr;
+    LogLevel logLevel = LogLevel::Info;
+    LocaTable loca;                     // The face's view, or a font pack's offsets
+    std::vector<uint32_t> glyphOffsets; // Widened by getGlyphOffsets() when the face isn't
+    std::shared_ptr<const VariationInstance> variationInstance;  // Null = default outlines
+    GlyphVariator variator;
+
+    bool fail(ReaderStatus status) {
+        lastStatus = status;
+        return false;
+    }
+    bool varying() const { return variationInstance && !variationInstance->isDefault(); }
+    bool logging(LogLevel level) const { return logSink && level >= logLevel; }
+    void logMessage(LogLevel level, const char* format, ...) const;    // printf-style; check logging() first
+
+    bool locaReady() {
+        return !loca.empty() || fail(face ? face->getLocaStatus() : ReaderStatus::MissingTable);
+    }
+
+    // Decoders take exactly the glyph's bytes and return bytes consumed (0 on failure).
+    // glyphIndex is -1 when unknown (sequential reads); it's used for cycle detection
+    // and to find the glyph's variation deltas.
+    size_t decodeGlyph(ByteSpan data, int glyphIndex, int depth, SimpleGlyph& glyph);
+    size_t decodeSimpleGlyph(ByteSpan data, int glyphIndex, SimpleGlyph& glyph);
+    size_t decodeCompositeGlyph(ByteSpan data, int glyphIndex, int depth, SimpleGlyph& glyph);
+
+    // Outline decoders write straight into arena arrays (simple glyphs), or
+    // assemble a composite in compositeScratch and copy it over
+    size_t decodeOutline(ByteSpan data, int glyphIndex, OutlineArena& arena, GlyphOutline& outline);
+    size_t decodeSimpleOutline(ByteSpan data, int glyphIndex, OutlineArena& arena, GlyphOutline& outline);
+    OutlineArena decodeArena{16 * 1024};    // Scratch for the SimpleGlyph paths
+    SvgBuffer svgBuffer{0};                 // Reused by the SVG exports; grows on first use
+    SimpleGlyph compositeScratch;
+
+    // Composite support: components are resolved once into flattened outlines
+    // and memoized, so shared parts (base letters, accents) decode only once
+    std::unordered_map<uint16_t, std::shared_ptr<const SimpleGlyph>> componentCache;
+    std::vector<int> compositeStack;    // Glyphs being resolved, for cycle detection
+    bool glyphDataForIndex(int glyphIndex, ByteSpan& data);
+    bool resolveComponent(uint16_t glyphIndex, int depth, std::shared_ptr<const SimpleGlyph>& component);
 
 public:
     TTFReader();
     ~TTFReader();
     
+    // Opens a private face on the file
     bool openFont(const std::string& filename);
+    // Reads from a face that may be shared with other readers (and threads).
+    // Resets this reader's cursor, caches and font pack.
+    bool attachFace(std::shared_ptr<const FontFace> sharedFace);
+    const std::shared_ptr<const FontFace>& getFace() const { return face; }
     void close();
+    uint16_t getUnitsPerEm() const { return face ? face->getUnitsPerEm() : 0; }
+    uint16_t getNumGlyphs() const { return face ? face->getNumGlyphs() : 0; }
+    ReaderStatus getLastStatus() const { return lastStatus; }
+    
+    // Messages at minLevel and above go to sink (nullptr turns logging off).
+    // The sink is called on the thread using the reader.
+    void setLogSink(LogSink sink, void* context = nullptr, LogLevel minLevel = LogLevel::Info);
     
+    // Sequential reads from the cursor (starts at 0, the offset table)
     bool readHeader(TTFHeader& header);
     bool readTableEntry(TableEntry& entry);
-    void printHeader(const TTFHeader& header);
-    void printTableEntry(const TableEntry& entry);
+    size_t getCursor() const { return cursor; }
+    bool setCursor(size_t offset);      // False (cursor unchanged) past the end of the file
 
     bool findTable(const std::string& tableName, TableEntry& entry);
     bool seekToTable(const std::string& tableName);
+    const TableEntry* lookupTable(uint32_t tag) const { return face ? face->lookupTable(tag) : nullptr; }
+    const std::vector<TableEntry>& getTableEntries() const;     // Sorted by tag
+    ByteSpan tableData(const TableEntry* entry) const { return face ? face->tableData(entry) : ByteSpan(); }
     std::vector<uint8_t> readBytes(size_t count);
-    void printHexDump(const std::vector<uint8_t>& data, size_t offset = 0);
 
     // glphy reading functions
     bool readGlyphHeader(GlyphHeader& header);
     bool readSimpleGlyph(SimpleGlyph& glyph);
-    void printGlyph(const SimpleGlyph& glyph);
-    void plotGlyph(const SimpleGlyph& glyph, int width = 80, int height = 40);
-    void exportGlyphSVG(const SimpleGlyph& glyph, const std::string& filename);
-    bool readMultipleGlyphs(int count);
-    void explainLocaTable();
+    bool exportGlyphSVG(const GlyphOutline& glyph, const std::string& filename);
+    // Checks 'loca' is usable (the face resolves it at open in O(1); nothing
+    // is read or copied) and logs how many glyphs it covers. Optional.
     bool loadLocaTable(); 
+    // 'loca' widened in one pass to byte offsets into 'glyf' (numGlyphs + 1
+    // entries), for callers that will visit every glyph; later lookups read
+    // this array instead of the raw table. Shared if the face was widened
+    // (FontFace::widenLoca), else private to this reader. Empty if the table
+    // is missing or malformed.
+    const std::vector<uint32_t>& getGlyphOffsets();
+    bool hasLongLoca() const { return loca.longFormat; }
     bool readGlyphByIndex(int glyphIndex, SimpleGlyph& glyph);
-    void readMultipleGlyphsByIndex(int startIndex, int count);
+
+    // Only the 10-byte header: contour count (-1 for a composite) and the box
+    // as stored. Empty glyphs succeed with all zeros. Doesn't move the cursor.
+    bool readGlyphBounds(int glyphIndex, GlyphHeader& header);
+
+    // Like readGlyphByIndex but silent, and empty glyphs succeed with no contours.
+    // The outline's arrays are carved from arena, so it stays valid until the
+    // arena is reset. Doesn't move the read cursor - meant for batch and cached paths.
+    bool loadOutline(int glyphIndex, OutlineArena& arena, GlyphOutline& outline);
+
+    // Shared, immutable outlines. With a cache attached, repeat reads skip
+    // decoding entirely; one cache may be shared by readers of the same font.
+    void setGlyphCache(GlyphCache* cache) { glyphCache = cache; }
+    std::shared_ptr<const StoredOutline> acquireGlyph(int glyphIndex);
+
+    // Serves loadOutline (and everything built on it) straight from a
+    // precompiled pack of this font, and takes 'loca' from it instead of
+    // parsing. The caller checks the pack matches (openFontPack does) and
+    // keeps it open. Fails if the glyph counts disagree.
+    bool setFontPack(const FontPack* pack);
+
+    // Decodes every glyph by index (loadOutline, acquireGlyph, readGlyphByIndex)
+    // at a location of a variable font; nullptr or a default instance goes back
+    // to the stored outlines. The instance must come from a FontVariations
+    // loaded from this reader's face. Varied outlines bypass a font pack, and
+    // are cached under their own keys in the glyph cache.
+    void setVariationInstance(std::shared_ptr<const VariationInstance> instance);
+    const std::shared_ptr<const VariationInstance>& getVariationInstance() const { return variationInstance; }
+
+    // Compiles the font's Unicode 'cmap' subtable (format 4 or 12) into map
+    bool loadCharMap(CharMap& map);
+
+    // Advance widths and side bearings from 'hhea' + 'hmtx'
+    bool loadHorizontalMetrics(HorizontalMetrics& metrics);
+
+    // Pair kerning from the GPOS 'kern' feature, or the 'kern' table if the
+    // font has no GPOS kerning
+    bool loadKerning(KerningTable& kerning);
+
+    // Every glyph's header in one pass (over pool if given), nothing decoded
+    bool loadGlyphBounds(GlyphBoundsTable& bounds, WorkStealingPool* pool = nullptr);
 
     // Bezier curve functions
     BezierPoint lerp(const BezierPoint& p1, const BezierPoint& p2, float t);
     BezierPoint quadraticBezier(const BezierPoint& start, const BezierPoint& control, const BezierPoint& end, float t);
     std::vector<BezierPoint> generateBezierCurve(const BezierPoint& start, const BezierPoint& control, const BezierPoint& end, int resolution = 20);
-    std::vector<BezierPoint> generateGlyphOutline(const SimpleGlyph& glyph, int resolution = 20);
-    std::vector<BezierPoint> generateContourOutline(const SimpleGlyph& glyph, size_t startPt, size_t endPt, int resolution = 20);
-    void exportGlyphWithCurves(const SimpleGlyph& glyph, const std::string& filename);
+    std::vector<BezierPoint> generateGlyphOutline(const GlyphOutline& glyph, int resolution = 20);
+    // Adaptive flattening: tolerance is in pixels, scale is pixels per font unit.
+    // Points are appended to out (caller reuses it); returns how many were added.
+    size_t flattenQuadratic(const BezierPoint& start, const BezierPoint& control, const BezierPoint& end,
+                            float tolerance, std::vector<BezierPoint>& out);
+    FlattenStats flattenGlyphOutline(const GlyphOutline& glyph, float tolerance, float scale,
+                                     std::vector<BezierPoint>& outline);
+    bool exportGlyphWithCurves(const GlyphOutline& glyph, const std::string& filename);
 };
 
 #endif
\ No newline at end of file